@@ -9,6 +9,8 @@
 #include <span>
 #include <numbers>
 
+#include "fade_curve.h"
+
 struct Coeffs {
     double a, b, c, d;
 };
@@ -141,6 +143,23 @@ void find_y_for_x_range_linear_stub(std::span<std::pair<double, double>> results
     }
 }
 
+// runtime fade path: curve is baked once, evaluation is segment lookup and lerp
+void find_y_for_x_range_knots(std::span<std::pair<double, double>> results, std::span<const hle_audio::rt::fade_curve_knot_t> knots, double step = 0.01) {
+    uint32_t segment_hint = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        double x = step * static_cast<double>(i);
+
+        double y = hle_audio::rt::sample_fade_curve_knots(knots.data(), uint32_t(knots.size()), float(x), &segment_hint);
+        results[i] = {x, y};
+    }
+}
+
+uint32_t g_knot_count = 0;
+
+void bake_knots(std::span<hle_audio::rt::fade_curve_knot_t> knots, const hle_audio::rt::fade_curve_t& curve) {
+    g_knot_count = hle_audio::rt::bake_fade_curve_knots(curve, knots.data());
+}
+
 template <typename Func, typename... Args>
 double benchmark(Func&& func, int iterations, Args&&... args) {
     using namespace std::chrono;
@@ -189,5 +208,28 @@ int main() {
     std::cout << "find_y_for_x_range_cubic took: " << range_cubic_us << " us\n";
     std::cout << "find_y_for_x_range_linear_stub took: " << range_stub_time_us << " us\n";
 
+    // knots baked by tool vs solvers
+    const hle_audio::rt::fade_curve_t curve = {
+        hle_audio::rt::fade_curve_type_e::bezier,
+        {float(p1.x), float(p1.y), float(p2.x), float(p2.y)}
+    };
+    std::vector<hle_audio::rt::fade_curve_knot_t> knots(hle_audio::rt::MAX_FADE_CURVE_KNOTS);
+
+    double bake_us = benchmark(bake_knots, N, std::span<hle_audio::rt::fade_curve_knot_t>(knots), curve);
+    knots.resize(g_knot_count);
+    double range_knots_us = benchmark(find_y_for_x_range_knots, N, results, std::span<const hle_audio::rt::fade_curve_knot_t>(knots), step);
+
+    // newton above could stall on flat x'(t), so bracketed solver is the reference
+    find_y_for_x_range_knots(results, knots, step);
+
+    double max_error = 0.0;
+    for (auto& [x, y] : results) {
+        max_error = std::max(max_error, std::abs(y - hle_audio::rt::evaluate_fade_curve(curve, float(x))));
+    }
+
+    std::cout << "bake_fade_curve_knots (" << knots.size() << " knots) took: " << bake_us << " us\n";
+    std::cout << "find_y_for_x_range_knots took: " << range_knots_us << " us\n";
+    std::cout << "knots max error vs exact: " << max_error << " (bound " << hle_audio::rt::FADE_CURVE_MAX_ERROR << ")\n";
+
     return 0;
 }
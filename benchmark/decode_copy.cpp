@@ -0,0 +1,126 @@
+/**
+ * decoded frames copies of resident adpcm sound read by miniaudio-sized periods:
+ *  - output ring: blocks are decoded into decoder output and copied into the read frames
+ *  - decode_into: frames are decoded straight into the read frames, blocks are continued across periods
+ * miniaudio default period is 10ms (480 frames at 48kHz), odd sized period checks partial block reads
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <random>
+
+#include "default_allocator.h"
+#include "decoders/decoder_adpcm.h"
+#include "data_sources/buffer_data_source.h"
+#include "adpcm.h"
+
+using namespace hle_audio;
+using namespace hle_audio::rt;
+
+static const uint32_t SAMPLE_RATE = 48000;
+static const uint8_t CHANNELS = 2;
+static const uint32_t SOUND_SECONDS = 60;
+static const uint32_t DEFAULT_PERIOD_FRAMES = SAMPLE_RATE / 100;
+
+// decoder output bytes, all of them are copied into the read frames
+static uint64_t g_output_bytes = 0;
+static data_buffer_t (*g_next_output)(void* state, const data_buffer_t& current_buf) = nullptr;
+
+static data_buffer_t counting_next_output(void* state, const data_buffer_t& current_buf) {
+    auto res = g_next_output(state, current_buf);
+    g_output_bytes += res.size;
+    return res;
+}
+
+struct run_result_t {
+    double ms_per_audio_second;
+    double copied_bytes_per_audio_second;
+    uint64_t checksum; // the same frames are expected to be read
+};
+
+static run_result_t run(std::vector<uint8_t>& encoded, uint64_t length_in_samples,
+        uint32_t period_frames, bool use_decode_into) {
+    auto allocator = make_default_allocator();
+
+    adpcm_decoder_create_info_t dec_info = {};
+    dec_info.allocator = allocator;
+    dec_info.channels = CHANNELS;
+    auto dec = create_decoder(dec_info);
+
+    // same decoder with the output counted, "before" one has no decode_into
+    auto decoder = cast_to_decoder(dec);
+    decoder_ti vt = *decoder.vt;
+    g_next_output = vt.next_output;
+    vt.next_output = counting_next_output;
+    if (!use_decode_into) vt.decode_into = nullptr;
+    decoder.vt = &vt;
+
+    buffer_data_source_init_info_t ds_info = {};
+    ds_info.decoder = decoder;
+    ds_info.format = ma_format_s16;
+    ds_info.meta.coding_format = audio_format_type_e::adpcm;
+    ds_info.meta.length_in_samples = length_in_samples;
+    ds_info.meta.sample_rate = SAMPLE_RATE;
+    ds_info.meta.channels = CHANNELS;
+    ds_info.buffer.data = encoded.data();
+    ds_info.buffer.size = encoded.size();
+
+    buffer_data_source_t ds;
+    buffer_data_source_init(&ds, ds_info);
+
+    std::vector<int16_t> period(period_frames * CHANNELS);
+    g_output_bytes = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t total_frames = 0;
+    uint64_t checksum = 0;
+    while (total_frames < length_in_samples) {
+        ma_uint64 frames_read = 0;
+        ma_data_source_read_pcm_frames(&ds, period.data(), period_frames, &frames_read);
+        if (!frames_read) break;
+        total_frames += frames_read;
+
+        for (ma_uint64 i = 0; i < frames_read * CHANNELS; ++i) checksum = checksum * 31 + uint16_t(period[i]);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    buffer_data_source_uninit(&ds);
+    destroy(dec);
+
+    double audio_seconds = double(total_frames) / SAMPLE_RATE;
+
+    run_result_t res = {};
+    res.ms_per_audio_second = std::chrono::duration<double, std::milli>(end - start).count() / audio_seconds;
+    res.copied_bytes_per_audio_second = g_output_bytes / audio_seconds;
+    res.checksum = checksum;
+    return res;
+}
+
+int main() {
+    const uint64_t block_count = uint64_t(SAMPLE_RATE) * SOUND_SECONDS / ADPCM_BLOCK_FRAMES;
+    const uint64_t length_in_samples = block_count * ADPCM_BLOCK_FRAMES;
+
+    // any codes are valid adpcm, the content doesn't matter for copies
+    std::vector<uint8_t> encoded(block_count * adpcm_block_size(CHANNELS));
+    std::mt19937 rng(42);
+    for (auto& byte : encoded) byte = uint8_t(rng());
+
+    std::cout << "adpcm " << int(CHANNELS) << "ch " << SAMPLE_RATE << "Hz, s16 output "
+        << SAMPLE_RATE * CHANNELS * sizeof(int16_t) << " bytes per second\n";
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (uint32_t period_frames : {DEFAULT_PERIOD_FRAMES, 256u, 333u, 1024u, 4096u}) {
+        auto before = run(encoded, length_in_samples, period_frames, false);
+        auto after = run(encoded, length_in_samples, period_frames, true);
+
+        std::cout << "period " << period_frames << " frames" << (period_frames == DEFAULT_PERIOD_FRAMES ? " (miniaudio default)" : "") << ":\n";
+        std::cout << "  output ring: " << before.copied_bytes_per_audio_second << " bytes copied/s, "
+            << before.ms_per_audio_second << " ms/s\n";
+        std::cout << "  decode_into: " << after.copied_bytes_per_audio_second << " bytes copied/s, "
+            << after.ms_per_audio_second << " ms/s\n";
+        if (before.checksum != after.checksum) std::cout << "  frames mismatch!\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * engine group lifecycle cost of fire event and release of short one-shot groups,
+ * measured through runtime api on headless context:
+ *  - fade: file node is filtered by fade node, so group plays through an engine group,
+ *    acquired by hlea_fire_event and released by hlea_process_frame when finished
+ *  - direct: group plays without engine group, the baseline
+ * the first plays initialize engine groups, the rest reuse the released ones
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "hlea/runtime.h"
+#include "generated_bank.h"
+
+using namespace hle_audio;
+
+static const uint32_t CHANNELS = 2;
+static const uint32_t PERIOD_FRAMES = 480;
+static const uint32_t GROUP_COUNT = 64;
+static const uint32_t EVENTS_PER_PERIOD = 4;
+static const uint32_t EVENT_COUNT = 20000;
+
+// ~50ms one-shots, events of the first periods are fired before any group is finished
+static const float SOUND_SECONDS = 0.05f;
+static const uint32_t FIRST_EVENTS = 4 * EVENTS_PER_PERIOD;
+
+using clock_type = std::chrono::steady_clock;
+
+static double elapsed_ns(clock_type::time_point start) {
+    return std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+}
+
+struct run_result_t {
+    double first_fire_ns;   // per event, engine groups are initialized
+    double fire_ns;         // per event, released groups are reused
+    double process_ns;      // hlea_process_frame per event, finished groups are released
+    uint32_t engine_groups; // high water
+};
+
+static run_result_t run(bool fade) {
+    hlea_context_create_info_t info = {};
+    info.output_bus_count = 1;
+    info.no_device = true;
+    auto ctx = hlea_create(&info);
+
+    bench::generated_bank_info_t bank_info = {};
+    bank_info.group_count = GROUP_COUNT;
+    bank_info.sound_count = 4;
+    bank_info.sound_seconds = SOUND_SECONDS;
+    bank_info.channels = 1;
+    bank_info.fade = fade;
+    auto blob = bench::generate_bank(bank_info);
+    auto bank = hlea_load_events_bank_from_buffer(ctx, blob.data(), blob.size());
+
+    std::vector<std::string> names;
+    for (uint32_t i = 0; i < GROUP_COUNT; ++i) names.push_back(bench::play_event_name(i));
+
+    std::vector<float> period(PERIOD_FRAMES * CHANNELS);
+    double first_fire_ns = 0.0;
+    double fire_ns = 0.0;
+    double process_ns = 0.0;
+
+    for (uint32_t i = 0; i < EVENT_COUNT; ++i) {
+        // object per event, so each event plays a new group instance
+        auto start = clock_type::now();
+        hlea_fire_event(ctx, bank, names[i % GROUP_COUNT].c_str(), i);
+        (i < FIRST_EVENTS ? first_fire_ns : fire_ns) += elapsed_ns(start);
+
+        if (i % EVENTS_PER_PERIOD == EVENTS_PER_PERIOD - 1) {
+            start = clock_type::now();
+            hlea_process_frame(ctx);
+            process_ns += elapsed_ns(start);
+
+            hlea_render_pcm(ctx, period.data(), PERIOD_FRAMES);
+        }
+    }
+
+    hlea_runtime_stats_t stats = {};
+    hlea_get_stats(ctx, &stats);
+
+    hlea_unload_events_bank(ctx, bank);
+    hlea_destroy(ctx);
+
+    run_result_t res = {};
+    res.first_fire_ns = first_fire_ns / FIRST_EVENTS;
+    res.fire_ns = fire_ns / (EVENT_COUNT - FIRST_EVENTS);
+    res.process_ns = process_ns / EVENT_COUNT;
+    res.engine_groups = stats.engine_groups.high_water;
+    return res;
+}
+
+static void print(const char* name, const run_result_t& res) {
+    std::cout << name << res.first_fire_ns << " ns first fires, "
+        << res.fire_ns << " ns fire, "
+        << res.process_ns << " ns process frame per event, "
+        << res.engine_groups << " engine groups\n";
+}
+
+int main() {
+    std::cout << EVENT_COUNT << " events, " << EVENTS_PER_PERIOD << " per "
+        << PERIOD_FRAMES << " frames period, " << SOUND_SECONDS * 1000.0f << "ms one-shots\n";
+    std::cout << std::fixed << std::setprecision(1);
+
+    // warm up
+    run(true);
+
+    print("fade:   ", run(true));
+    print("direct: ", run(false));
+
+    return 0;
+}
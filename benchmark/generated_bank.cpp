@@ -0,0 +1,106 @@
+#include "generated_bank.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "data_state.h"
+
+namespace hle_audio {
+namespace bench {
+
+using namespace hle_audio::data;
+
+static const uint32_t SAMPLE_RATE = 48000;
+
+/**
+ * sine tones of raw s16 pcm, frequency depends on sound index so sounds differ
+ */
+class tone_data_provider_t : public audio_file_data_provider_ti {
+public:
+    float seconds;
+    uint8_t channels;
+
+    audio_file_data_t get_file_data(const char* filename, uint32_t file_index, const audio_file_flags_t& flags) override {
+        const uint64_t length_in_samples = uint64_t(seconds * SAMPLE_RATE);
+        const float frequency = 220.0f + 20.0f * float(atoi(filename + 5)); // "tone_<i>"
+        const float step = 2.0f * 3.14159265f * frequency / float(SAMPLE_RATE);
+
+        audio_file_data_t res = {};
+        res.meta.coding_format = rt::audio_format_type_e::pcm;
+        res.meta.length_in_samples = length_in_samples;
+        res.meta.sample_rate = SAMPLE_RATE;
+        res.meta.channels = channels;
+
+        res.content.resize(length_in_samples * channels * sizeof(int16_t));
+        auto samples = (int16_t*)res.content.data();
+        for (uint64_t i = 0; i < length_in_samples; ++i) {
+            auto sample = int16_t(8000.0f * sinf(step * float(i)));
+            for (uint8_t ch = 0; ch < channels; ++ch) samples[i * channels + ch] = sample;
+        }
+
+        res.data_chunk_range.offset = 0;
+        res.data_chunk_range.size = uint32_t(res.content.size());
+        return res;
+    }
+};
+
+static std::u8string tone_filename(uint32_t sound_index) {
+    auto name = "tone_" + std::to_string(sound_index);
+    return std::u8string(name.begin(), name.end());
+}
+
+std::string play_event_name(uint32_t group_index) {
+    return "play_" + std::to_string(group_index);
+}
+
+std::string stop_event_name(uint32_t group_index) {
+    return "stop_" + std::to_string(group_index);
+}
+
+std::vector<uint8_t> generate_bank(const generated_bank_info_t& info) {
+    data_state_t state = {};
+    init(&state);
+
+    const uint32_t sound_count = info.sound_count ? info.sound_count : info.group_count;
+    for (uint32_t i = 0; i < info.group_count; ++i) {
+        create_group(&state, i);
+
+        auto node_id = create_node(&state, i, FILE_FNODE_TYPE, {});
+        auto& file_node = get_file_node_mut(&state, node_id);
+        file_node.filename = tone_filename(i % sound_count);
+        file_node.loop = info.loop;
+        file_node.stream = info.stream;
+
+        if (info.fade) {
+            auto fade_node_id = create_node(&state, i, FADE_FNODE_TYPE, {});
+            auto& fade_node = get_fade_node_mut(&state, fade_node_id);
+            fade_node.start_time = 0.05f;
+            fade_node.end_time = 0.05f;
+
+            link_t link = {};
+            link.from = {node_id, file_flow_node_t::FILTER_OUT_PIN};
+            link.to = {fade_node_id, 0};
+            get_group_mut(&state, i).links.push_back(link);
+        }
+
+        event_t play_event = {};
+        play_event.name = play_event_name(i);
+        play_event.actions.push_back({rt::action_type_e::play, i, 0.0f});
+        state.events.push_back(play_event);
+
+        event_t stop_event = {};
+        stop_event.name = stop_event_name(i);
+        stop_event.actions.push_back({rt::action_type_e::stop, i, 0.0f});
+        state.events.push_back(stop_event);
+    }
+
+    tone_data_provider_t provider;
+    provider.seconds = info.sound_seconds;
+    provider.channels = info.channels ? info.channels : 2;
+
+    return save_store_blob_buffer(&state, &provider, info.stream ? info.stream_filename : nullptr);
+}
+
+}
+}
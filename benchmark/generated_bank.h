@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hle_audio {
+namespace bench {
+
+/**
+ * bank compiled in memory from synthesized pcm tones, no project or sound files needed:
+ * group i plays a single file node of tone (i % sound_count),
+ * events "play_<i>" and "stop_<i>" target group i
+ */
+struct generated_bank_info_t {
+    uint32_t group_count;
+    uint32_t sound_count; // distinct tones (0 - one per group)
+    float sound_seconds;
+    uint8_t channels;
+    bool loop;
+
+    // file node is filtered by fade node, so groups use engine groups and fade nodes (not direct)
+    bool fade;
+
+    // sounds are streamed from stream_filename, which is written by generate_bank
+    bool stream;
+    const char* stream_filename;
+};
+
+std::vector<uint8_t> generate_bank(const generated_bank_info_t& info);
+
+std::string play_event_name(uint32_t group_index);
+std::string stop_event_name(uint32_t group_index);
+
+}
+}
@@ -0,0 +1,742 @@
+/**
+ * runtime hot paths, headless (no audio device), results are written as json:
+ *  - fire_event: hlea_fire_event by name and by actions (index)
+ *  - process_frame: hlea_process_frame with 10, 100 and 1000 requested looping groups
+ *  - decode: frames decoded per second per thread, pcm and adpcm are synthesized,
+ *    mp3 and vorbis are decoded from --sounds directory files (skipped otherwise)
+ *  - chunk_cache: acquire_chunk/release_chunk of cached chunks from several threads
+ *  - hash_indices, index_list: container operations
+ *  - mix: offline rendering cost per playing voice
+ *
+ * usage: benchmark_runtime [--out file.json] [--sounds dir]
+ */
+#include <cassert>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <thread>
+#include <random>
+#include <filesystem>
+
+#include "hlea/runtime.h"
+#include "miniaudio_public.h"
+
+#include "default_allocator.h"
+#include "audio_kernels.h"
+#include "async_file_reader.h"
+#include "chunk_streaming_cache.h"
+#include "decoders/decoder_mp3.h"
+#include "decoders/decoder_vorbis.h"
+#include "decoders/decoder_adpcm.h"
+#include "data_sources/buffer_data_source.h"
+#include "hash_indices.inl"
+#include "index_list.inl"
+#include "adpcm.h"
+
+#include "generated_bank.h"
+
+namespace fs = std::filesystem;
+
+using namespace hle_audio;
+using namespace hle_audio::rt;
+
+using clock_type = std::chrono::steady_clock;
+
+static const uint32_t SAMPLE_RATE = 48000;
+static const uint32_t CHANNELS = 2;
+static const uint32_t PERIOD_FRAMES = 480;
+
+static double elapsed_ns(clock_type::time_point start) {
+    return std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+}
+
+/**
+ * minimal json output, objects and arrays of objects
+ */
+struct json_writer_t {
+    FILE* f;
+    uint32_t depth;
+    bool first;
+
+    void item_prefix(const char* key) {
+        fprintf(f, "%s\n%*s", first ? "" : ",", int(depth * 2), "");
+        if (key) fprintf(f, "\"%s\": ", key);
+        first = false;
+    }
+
+    void begin(const char* key, char bracket) {
+        item_prefix(key);
+        fputc(bracket, f);
+        first = true;
+        ++depth;
+    }
+
+    void end(char bracket) {
+        --depth;
+        fprintf(f, "\n%*s%c", int(depth * 2), "", bracket);
+        first = false;
+    }
+
+    void begin_object(const char* key = nullptr) { begin(key, '{'); }
+    void end_object() { end('}'); }
+    void begin_array(const char* key) { begin(key, '['); }
+    void end_array() { end(']'); }
+
+    void value(const char* key, double v) {
+        item_prefix(key);
+        fprintf(f, "%.3f", v);
+    }
+
+    void value(const char* key, uint64_t v) {
+        item_prefix(key);
+        fprintf(f, "%llu", (unsigned long long)v);
+    }
+
+    void value(const char* key, const char* v) {
+        item_prefix(key);
+        fprintf(f, "\"%s\"", v);
+    }
+};
+
+/**
+ * runtime context without device, frames are rendered by benchmark
+ */
+static hlea_context_t* create_headless_context() {
+    hlea_context_create_info_t info = {};
+    info.output_bus_count = 1;
+    info.no_device = true;
+    return hlea_create(&info);
+}
+
+static hlea_event_bank_t* load_generated_bank(hlea_context_t* ctx, const bench::generated_bank_info_t& info) {
+    auto blob = bench::generate_bank(info);
+    return hlea_load_events_bank_from_buffer(ctx, blob.data(), blob.size());
+}
+
+static void render_periods(hlea_context_t* ctx, std::vector<float>& period, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        hlea_render_pcm(ctx, period.data(), PERIOD_FRAMES);
+    }
+}
+
+//
+// fire event
+//
+
+static const uint32_t FIRE_EVENT_GROUPS = 64;
+static const uint32_t FIRE_EVENT_COUNT = 20000;
+
+static double run_fire_event(bool by_name) {
+    auto ctx = create_headless_context();
+
+    // ~50ms one-shots, so finished groups are released while events are fired
+    bench::generated_bank_info_t bank_info = {};
+    bank_info.group_count = FIRE_EVENT_GROUPS;
+    bank_info.sound_count = 4;
+    bank_info.sound_seconds = 0.05f;
+    auto bank = load_generated_bank(ctx, bank_info);
+
+    std::vector<std::string> names;
+    for (uint32_t i = 0; i < FIRE_EVENT_GROUPS; ++i) names.push_back(bench::play_event_name(i));
+
+    std::vector<float> period(PERIOD_FRAMES * CHANNELS);
+    double events_ns = 0.0;
+    for (uint32_t i = 0; i < FIRE_EVENT_COUNT; ++i) {
+        auto group_index = i % FIRE_EVENT_GROUPS;
+
+        auto start = clock_type::now();
+        if (by_name) {
+            hlea_fire_event(ctx, bank, names[group_index].c_str(), 0);
+        } else {
+            hlea_action_info_t action = {};
+            action.type = hlea_action_type_e::play;
+            action.target_index = group_index;
+
+            hlea_fire_event_info_t event_info = {};
+            event_info.bank = bank;
+            event_info.actions = &action;
+            event_info.action_count = 1;
+            hlea_fire_event(ctx, &event_info);
+        }
+        events_ns += elapsed_ns(start);
+
+        if (i % 4 == 0) {
+            hlea_process_frame(ctx);
+            render_periods(ctx, period, 1);
+        }
+    }
+
+    hlea_unload_events_bank(ctx, bank);
+    hlea_destroy(ctx);
+
+    return events_ns / FIRE_EVENT_COUNT;
+}
+
+static void bench_fire_event(json_writer_t& json) {
+    run_fire_event(true); // warm up
+
+    json.begin_object("fire_event");
+    json.value("event_count", uint64_t(FIRE_EVENT_COUNT));
+    json.value("by_name_ns", run_fire_event(true));
+    json.value("by_index_ns", run_fire_event(false));
+    json.end_object();
+}
+
+//
+// process frame
+//
+
+static const uint32_t PROCESS_FRAME_GROUPS = 128;
+static const uint32_t PROCESS_FRAME_ITERATIONS = 500;
+
+static void bench_process_frame(json_writer_t& json) {
+    json.begin_array("process_frame");
+
+    for (uint32_t requested : {10u, 100u, 1000u}) {
+        auto ctx = create_headless_context();
+
+        bench::generated_bank_info_t bank_info = {};
+        bank_info.group_count = PROCESS_FRAME_GROUPS;
+        bank_info.sound_count = 8;
+        bank_info.sound_seconds = 1.0f;
+        bank_info.loop = true;
+        auto bank = load_generated_bank(ctx, bank_info);
+
+        // instances beyond group count are played for other objects
+        for (uint32_t i = 0; i < requested; ++i) {
+            auto name = bench::play_event_name(i % PROCESS_FRAME_GROUPS);
+            hlea_fire_event(ctx, bank, name.c_str(), i / PROCESS_FRAME_GROUPS);
+        }
+
+        std::vector<float> period(PERIOD_FRAMES * CHANNELS);
+        hlea_process_frame(ctx);
+        render_periods(ctx, period, 4);
+
+        double process_ns = 0.0;
+        for (uint32_t i = 0; i < PROCESS_FRAME_ITERATIONS; ++i) {
+            auto start = clock_type::now();
+            hlea_process_frame(ctx);
+            process_ns += elapsed_ns(start);
+
+            render_periods(ctx, period, 1);
+        }
+
+        hlea_runtime_stats_t stats = {};
+        hlea_get_stats(ctx, &stats);
+
+        // active groups pool is limited, requests above it are dropped
+        json.begin_object();
+        json.value("requested_groups", uint64_t(requested));
+        json.value("active_groups", uint64_t(hlea_get_active_groups_count(ctx)));
+        json.value("dropped_events", stats.dropped_events);
+        json.value("us_per_frame", process_ns / PROCESS_FRAME_ITERATIONS / 1000.0);
+        json.end_object();
+
+        hlea_unload_events_bank(ctx, bank);
+        hlea_destroy(ctx);
+    }
+
+    json.end_array();
+}
+
+//
+// decoding
+//
+
+struct decode_input_t {
+    std::vector<uint8_t> data;
+    uint8_t channels;
+    uint64_t length_in_samples;
+};
+
+using decode_func_t = uint64_t (*)(const decode_input_t& input, std::vector<int16_t>& frames);
+
+static uint64_t decode_mp3(const decode_input_t& input, std::vector<int16_t>& frames) {
+    data_buffer_t buf = {(uint8_t*)input.data.data(), input.data.size()};
+    return mp3_decode_buffer_s16(buf, input.channels, frames.data(), input.length_in_samples);
+}
+
+static uint64_t decode_vorbis(const decode_input_t& input, std::vector<int16_t>& frames) {
+    data_buffer_t buf = {(uint8_t*)input.data.data(), input.data.size()};
+    return vorbis_decode_buffer_s16(make_default_allocator(), buf, input.channels, frames.data(), input.length_in_samples);
+}
+
+static uint64_t decode_adpcm(const decode_input_t& input, std::vector<int16_t>& frames) {
+    data_buffer_t buf = {(uint8_t*)input.data.data(), input.data.size()};
+    return adpcm_decode_buffer_s16(buf, input.channels, frames.data(), input.length_in_samples);
+}
+
+/**
+ * resident pcm is read by data source without decoder, so its reads are measured
+ */
+static uint64_t read_pcm(const decode_input_t& input, std::vector<int16_t>& frames) {
+    buffer_data_source_init_info_t ds_info = {};
+    ds_info.format = ma_format_f32;
+    ds_info.meta.coding_format = audio_format_type_e::pcm;
+    ds_info.meta.length_in_samples = input.length_in_samples;
+    ds_info.meta.sample_rate = SAMPLE_RATE;
+    ds_info.meta.channels = input.channels;
+    ds_info.buffer.data = (uint8_t*)input.data.data();
+    ds_info.buffer.size = input.data.size();
+
+    buffer_data_source_t ds;
+    buffer_data_source_init(&ds, ds_info);
+
+    // s16 frames buffer is big enough for f32 periods
+    auto period = (float*)frames.data();
+    uint64_t total_frames = 0;
+    while (total_frames < input.length_in_samples) {
+        ma_uint64 frames_read = 0;
+        ma_data_source_read_pcm_frames(&ds, period, PERIOD_FRAMES, &frames_read);
+        if (!frames_read) break;
+        total_frames += frames_read;
+    }
+
+    buffer_data_source_uninit(&ds);
+    return total_frames;
+}
+
+static std::vector<uint8_t> read_file_data(const fs::path& path) {
+    std::vector<uint8_t> res;
+    FILE* f = fopen(path.string().c_str(), "rb");
+    if (!f) return res;
+
+    fseek(f, 0, SEEK_END);
+    res.resize(size_t(ftell(f)));
+    fseek(f, 0, SEEK_SET);
+    if (fread(res.data(), 1, res.size(), f) != res.size()) res.clear();
+    fclose(f);
+    return res;
+}
+
+static std::vector<decode_input_t> load_sound_inputs(const char* sounds_path, const char* extension) {
+    std::vector<decode_input_t> res;
+    if (!sounds_path) return res;
+
+    std::error_code ec;
+    for (auto& entry : fs::directory_iterator(sounds_path, ec)) {
+        if (entry.path().extension() != extension) continue;
+
+        decode_input_t input = {};
+        input.data = read_file_data(entry.path());
+        if (input.data.empty()) continue;
+
+        ma_decoder_config config = ma_decoder_config_init(ma_format_s16, 0, 0);
+        ma_decoder decoder;
+        if (ma_decoder_init_memory(input.data.data(), input.data.size(), &config, &decoder) != MA_SUCCESS) continue;
+
+        ma_uint64 length = 0;
+        ma_uint32 channels = 0;
+        ma_data_source_get_length_in_pcm_frames(decoder.pBackend, &length);
+        ma_data_source_get_data_format(decoder.pBackend, nullptr, &channels, nullptr, nullptr, 0);
+        ma_decoder_uninit(&decoder);
+
+        input.channels = uint8_t(channels);
+        input.length_in_samples = length;
+        if (length && channels <= CHANNELS) res.push_back(std::move(input));
+    }
+
+    return res;
+}
+
+static decode_input_t make_pcm_input(uint32_t seconds) {
+    decode_input_t res = {};
+    res.channels = CHANNELS;
+    res.length_in_samples = uint64_t(SAMPLE_RATE) * seconds;
+    res.data.resize(res.length_in_samples * CHANNELS * sizeof(int16_t));
+
+    auto samples = (int16_t*)res.data.data();
+    for (uint64_t i = 0; i < res.length_in_samples * CHANNELS; ++i) samples[i] = int16_t(i * 31);
+    return res;
+}
+
+static decode_input_t make_adpcm_input(uint32_t seconds) {
+    const uint64_t block_count = uint64_t(SAMPLE_RATE) * seconds / ADPCM_BLOCK_FRAMES;
+
+    // any codes are valid adpcm
+    decode_input_t res = {};
+    res.channels = CHANNELS;
+    res.length_in_samples = block_count * ADPCM_BLOCK_FRAMES;
+    res.data.resize(block_count * adpcm_block_size(CHANNELS));
+
+    std::mt19937 rng(42);
+    for (auto& byte : res.data) byte = uint8_t(rng());
+    return res;
+}
+
+static const double DECODE_MIN_AUDIO_SECONDS = 60.0; // per thread
+
+/**
+ * @return decoded frames per second of each thread
+ */
+static double run_decode(const std::vector<decode_input_t>& inputs, decode_func_t decode, uint32_t thread_count) {
+    uint64_t max_length = 0;
+    for (auto& input : inputs) max_length = std::max(max_length, input.length_in_samples);
+
+    std::vector<uint64_t> thread_frames(thread_count);
+    auto thread_func = [&](uint32_t thread_index) {
+        std::vector<int16_t> frames(max_length * CHANNELS);
+
+        uint64_t decoded = 0;
+        while (decoded < DECODE_MIN_AUDIO_SECONDS * SAMPLE_RATE) {
+            uint64_t pass_decoded = 0;
+            for (auto& input : inputs) pass_decoded += decode(input, frames);
+            if (!pass_decoded) break;
+            decoded += pass_decoded;
+        }
+        thread_frames[thread_index] = decoded;
+    };
+
+    auto start = clock_type::now();
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < thread_count; ++i) threads.emplace_back(thread_func, i);
+    for (auto& thread : threads) thread.join();
+    double seconds = elapsed_ns(start) / 1e9;
+
+    uint64_t total_frames = 0;
+    for (auto frames : thread_frames) total_frames += frames;
+    return double(total_frames) / thread_count / seconds;
+}
+
+static void bench_decode(json_writer_t& json, const char* sounds_path) {
+    struct format_t {
+        const char* name;
+        std::vector<decode_input_t> inputs;
+        decode_func_t decode;
+    };
+    format_t formats[4] = {};
+    formats[0] = {"pcm", {}, read_pcm};
+    formats[0].inputs.push_back(make_pcm_input(10));
+    formats[1] = {"adpcm", {}, decode_adpcm};
+    formats[1].inputs.push_back(make_adpcm_input(10));
+    formats[2] = {"mp3", load_sound_inputs(sounds_path, ".mp3"), decode_mp3};
+    formats[3] = {"vorbis", load_sound_inputs(sounds_path, ".ogg"), decode_vorbis};
+
+    uint32_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    json.begin_array("decode");
+    for (auto& format : formats) {
+        json.begin_object();
+        json.value("format", format.name);
+        json.value("inputs", uint64_t(format.inputs.size()));
+        if (format.inputs.empty()) {
+            json.value("skipped", "no input files, see --sounds");
+            json.end_object();
+            continue;
+        }
+
+        run_decode(format.inputs, format.decode, 1); // warm up
+
+        // real time factor is decoded audio seconds per wall second
+        auto single = run_decode(format.inputs, format.decode, 1);
+        json.value("realtime_factor_1_thread", single / SAMPLE_RATE);
+
+        auto all = run_decode(format.inputs, format.decode, hardware_threads);
+        json.value("threads", uint64_t(hardware_threads));
+        json.value("realtime_factor_per_thread", all / SAMPLE_RATE);
+        json.end_object();
+    }
+    json.end_array();
+}
+
+//
+// chunk streaming cache
+//
+
+static const uint32_t CACHE_CHUNKS_USED = 16; // every chunk is cached, so requests are hits
+static const uint32_t CACHE_OPS_PER_THREAD = 200000;
+
+static void bench_chunk_cache(json_writer_t& json) {
+    auto path = fs::temp_directory_path() / "hlea_benchmark_chunks.bin";
+    {
+        std::vector<uint8_t> data(CACHE_CHUNKS_USED * READ_CHUNK_SIZE, 0x5a);
+        FILE* f = fopen(path.string().c_str(), "wb");
+        if (!f) return;
+        fwrite(data.data(), 1, data.size(), f);
+        fclose(f);
+    }
+
+    auto allocator = make_default_allocator();
+
+    ma_default_vfs vfs;
+    ma_default_vfs_init(&vfs, nullptr);
+    ma_vfs_file file = nullptr;
+    ma_vfs_open(&vfs, path.string().c_str(), MA_OPEN_MODE_READ, &file);
+
+    async_file_reader_create_info_t reader_info = {};
+    reader_info.allocator = allocator;
+    reader_info.vfs = &vfs;
+    auto reader = create_async_file_reader(reader_info);
+
+    chunk_streaming_cache_init_info_t cache_info = {};
+    cache_info.allocator = allocator;
+    cache_info.async_io = reader;
+    auto cache = create_cache(cache_info);
+
+    auto afile = start_async_reading(reader, file);
+    auto src = register_source(cache, afile);
+
+    chunk_request_t request = {};
+    request.src = src;
+    request.buffer_block.offset = 0;
+    request.buffer_block.size = CACHE_CHUNKS_USED * READ_CHUNK_SIZE;
+
+    // fill cache
+    uint32_t chunk_indices[CACHE_CHUNKS_USED];
+    for (uint32_t i = 0; i < CACHE_CHUNKS_USED; ++i) {
+        request.block_offset = i * READ_CHUNK_SIZE;
+        chunk_indices[i] = acquire_chunk(*cache, request).index;
+    }
+    for (auto chunk_index : chunk_indices) {
+        while (chunk_status(*cache, chunk_index) != chunk_status_e::READY) {
+            update_pending_reads(cache);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        release_chunk(*cache, chunk_index);
+    }
+
+    json.begin_array("chunk_cache");
+    for (uint32_t thread_count : {1u, 2u, 4u, 8u}) {
+        auto thread_func = [&](uint32_t thread_index) {
+            chunk_request_t thread_request = request;
+            for (uint32_t i = 0; i < CACHE_OPS_PER_THREAD; ++i) {
+                thread_request.block_offset = ((thread_index * 7 + i) % CACHE_CHUNKS_USED) * READ_CHUNK_SIZE;
+                auto res = acquire_chunk(*cache, thread_request);
+                assert(res.index != ~0u);
+                release_chunk(*cache, res.index);
+            }
+        };
+
+        auto start = clock_type::now();
+        std::vector<std::thread> threads;
+        for (uint32_t i = 0; i < thread_count; ++i) threads.emplace_back(thread_func, i);
+        for (auto& thread : threads) thread.join();
+        double total_ns = elapsed_ns(start);
+
+        uint64_t op_count = uint64_t(thread_count) * CACHE_OPS_PER_THREAD;
+        json.begin_object();
+        json.value("threads", uint64_t(thread_count));
+        json.value("acquire_release_ns", total_ns * thread_count / op_count); // per thread
+        json.value("acquire_release_per_second", op_count / (total_ns / 1e9));
+        json.end_object();
+    }
+    json.end_array();
+
+    deregister_source(cache, src);
+    destroy(cache);
+    stop_async_reading(reader, afile);
+    destroy(reader);
+    ma_vfs_close(&vfs, file);
+    fs::remove(path);
+}
+
+//
+// containers
+//
+
+static const uint32_t HASH_SIZE = 1024;
+static const uint32_t HASH_ENTRIES = 512; // 0.5 load factor, as chunk cache expects
+static const uint32_t CONTAINER_ROUNDS = 2000;
+
+static void bench_hash_indices(json_writer_t& json) {
+    std::vector<uint32_t> storage(HASH_SIZE * 2);
+    hash_indices_t indices = {};
+
+    std::vector<uint32_t> keys(HASH_ENTRIES);
+    std::mt19937 rng(7);
+    for (auto& key : keys) key = uint32_t(rng()) | 1u; // non zero
+
+    double insert_ns = 0.0, find_ns = 0.0, erase_ns = 0.0;
+    uint64_t found = 0;
+    for (uint32_t round = 0; round < CONTAINER_ROUNDS; ++round) {
+        hash::init(&indices, storage.data(), storage.data() + HASH_SIZE, HASH_SIZE);
+
+        auto start = clock_type::now();
+        for (uint32_t i = 0; i < HASH_ENTRIES; ++i) hash::insert(&indices, keys[i], i);
+        insert_ns += elapsed_ns(start);
+
+        start = clock_type::now();
+        for (uint32_t i = 0; i < HASH_ENTRIES; ++i) {
+            auto index = hash::find_index(&indices, keys[i], [i](uint32_t index) { return index == i; });
+            found += (index != ~0u);
+        }
+        find_ns += elapsed_ns(start);
+
+        start = clock_type::now();
+        for (uint32_t i = 0; i < HASH_ENTRIES; ++i) hash::erase_with_index(&indices, keys[i], i);
+        erase_ns += elapsed_ns(start);
+    }
+
+    double op_count = double(CONTAINER_ROUNDS) * HASH_ENTRIES;
+    json.begin_object("hash_indices");
+    json.value("size", uint64_t(HASH_SIZE));
+    json.value("entries", uint64_t(HASH_ENTRIES));
+    json.value("insert_ns", insert_ns / op_count);
+    json.value("find_ns", find_ns / op_count);
+    json.value("erase_ns", erase_ns / op_count);
+    json.value("found", found);
+    json.end_object();
+}
+
+static const uint16_t INDEX_LIST_SIZE = 1024;
+
+static void bench_index_list(json_writer_t& json) {
+    std::vector<index_list_entry_t> entries(INDEX_LIST_SIZE + 1);
+    index_list_t list = {};
+
+    std::vector<uint16_t> order(INDEX_LIST_SIZE);
+    for (uint16_t i = 0; i < INDEX_LIST_SIZE; ++i) order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(3));
+
+    double pop_ns = 0.0, push_ns = 0.0, erase_ns = 0.0;
+    uint64_t checksum = 0;
+    for (uint32_t round = 0; round < CONTAINER_ROUNDS; ++round) {
+        init(&list, entries.data(), INDEX_LIST_SIZE);
+
+        // free list usage: take all, return in random order, then detach random ones
+        auto start = clock_type::now();
+        for (uint16_t i = 0; i < INDEX_LIST_SIZE; ++i) checksum += pop_front(&list);
+        pop_ns += elapsed_ns(start);
+
+        start = clock_type::now();
+        for (auto index : order) push_back(&list, index);
+        push_ns += elapsed_ns(start);
+
+        start = clock_type::now();
+        for (auto index : order) erase(&list, index);
+        erase_ns += elapsed_ns(start);
+    }
+
+    double op_count = double(CONTAINER_ROUNDS) * INDEX_LIST_SIZE;
+    json.begin_object("index_list");
+    json.value("size", uint64_t(INDEX_LIST_SIZE));
+    json.value("pop_front_ns", pop_ns / op_count);
+    json.value("push_back_ns", push_ns / op_count);
+    json.value("erase_ns", erase_ns / op_count);
+    json.value("checksum", checksum);
+    json.end_object();
+}
+
+//
+// offline mixing
+//
+
+static const uint32_t MIX_GROUPS = 256;
+static const uint32_t MIX_AUDIO_SECONDS = 10;
+
+struct mix_result_t {
+    uint32_t voices;
+    double ms_per_audio_second;
+    float avg_load;
+};
+
+static mix_result_t run_mix(uint32_t voices) {
+    auto ctx = create_headless_context();
+
+    bench::generated_bank_info_t bank_info = {};
+    bank_info.group_count = MIX_GROUPS;
+    bank_info.sound_count = 16;
+    bank_info.sound_seconds = 2.0f;
+    bank_info.loop = true;
+    auto bank = load_generated_bank(ctx, bank_info);
+
+    for (uint32_t i = 0; i < voices; ++i) {
+        auto name = bench::play_event_name(i % MIX_GROUPS);
+        hlea_fire_event(ctx, bank, name.c_str(), i / MIX_GROUPS);
+    }
+
+    std::vector<float> period(PERIOD_FRAMES * CHANNELS);
+    hlea_process_frame(ctx);
+    render_periods(ctx, period, 4);
+    hlea_reset_audio_load(ctx);
+
+    const uint32_t period_count = MIX_AUDIO_SECONDS * SAMPLE_RATE / PERIOD_FRAMES;
+    auto start = clock_type::now();
+    for (uint32_t i = 0; i < period_count; ++i) {
+        // client frame every 2 periods (~20ms)
+        if (i % 2 == 0) hlea_process_frame(ctx);
+        render_periods(ctx, period, 1);
+    }
+    double total_ns = elapsed_ns(start);
+
+    hlea_audio_load_t load = {};
+    hlea_get_audio_load(ctx, &load);
+
+    mix_result_t res = {};
+    res.voices = uint32_t(hlea_get_active_groups_count(ctx));
+    res.ms_per_audio_second = total_ns / 1e6 / MIX_AUDIO_SECONDS;
+    res.avg_load = load.avg_load;
+
+    hlea_unload_events_bank(ctx, bank);
+    hlea_destroy(ctx);
+    return res;
+}
+
+static void bench_mix(json_writer_t& json) {
+    auto baseline = run_mix(0);
+
+    json.begin_object("mix");
+    json.value("audio_seconds", uint64_t(MIX_AUDIO_SECONDS));
+    json.value("baseline_ms_per_audio_second", baseline.ms_per_audio_second);
+
+    json.begin_array("voices");
+    for (uint32_t voices : {1u, 16u, 64u, 256u}) {
+        auto res = run_mix(voices);
+
+        json.begin_object();
+        json.value("voices", uint64_t(res.voices));
+        json.value("ms_per_audio_second", res.ms_per_audio_second);
+        json.value("avg_load", double(res.avg_load));
+        if (res.voices) {
+            double per_voice_ms = (res.ms_per_audio_second - baseline.ms_per_audio_second) / res.voices;
+            json.value("us_per_voice_per_audio_second", per_voice_ms * 1000.0);
+        }
+        json.end_object();
+    }
+    json.end_array();
+    json.end_object();
+}
+
+int main(int argc, char** argv) {
+    const char* out_path = nullptr;
+    const char* sounds_path = nullptr;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--out") == 0) out_path = argv[i + 1];
+        else if (strcmp(argv[i], "--sounds") == 0) sounds_path = argv[i + 1];
+        else {
+            fprintf(stderr, "unknown option %s, expected: [--out file.json] [--sounds dir]\n", argv[i]);
+            return 1;
+        }
+    }
+
+    json_writer_t json = {};
+    json.first = true;
+    json.f = out_path ? fopen(out_path, "wb") : stdout;
+    if (!json.f) {
+        fprintf(stderr, "couldn't open %s\n", out_path);
+        return 1;
+    }
+
+    json.begin_object();
+    json.value("sample_rate", uint64_t(SAMPLE_RATE));
+    json.value("period_frames", uint64_t(PERIOD_FRAMES));
+    json.value("kernels", get_audio_kernels().isa_name);
+    json.value("hardware_threads", uint64_t(std::thread::hardware_concurrency()));
+
+    bench_fire_event(json);
+    bench_process_frame(json);
+    bench_decode(json, sounds_path);
+    bench_chunk_cache(json);
+    bench_hash_indices(json);
+    bench_index_list(json);
+    bench_mix(json);
+
+    json.end_object();
+    fprintf(json.f, "\n");
+
+    if (out_path) fclose(json.f);
+    return 0;
+}
@@ -0,0 +1,611 @@
+/**
+ * soak and stress harness, headless runtime is driven by random event traffic for a long time:
+ * play (right away and timed), stop, pause, resume, break loop, bus actions, stop all
+ * and bank unload/load churn, with resident and streamed, direct and faded groups.
+ *
+ * Every minute of rendered audio the traffic is stopped, banks are unloaded and the runtime
+ * is checked at rest:
+ *  - stopped groups are released, sound, group, data source and fade node pools are unused
+ *  - no pending sounds or timed events are left
+ *  - streaming cache chunks are all released (no refcount leaks)
+ *  - live allocations (tracking allocator) don't grow, unless engine groups pool does
+ * Throughput, api call latency, pools usage and audio load are reported per minute,
+ * latency drift is the last minute against the first one.
+ *
+ * usage: benchmark_soak [--minutes N] [--speed X] [--seed S] [--storage S] [--short-reads P] [--out minutes.jsonl]
+ *  --speed: rendered audio seconds per wall second (default 1 - real time, 0 - unpaced)
+ *  --storage: simulated slow storage for all reads: hdd, sd_card, network_drive (default - none)
+ *  --short-reads: probability of a read returning part of requested bytes, overrides storage one
+ *  --out: json object per minute, written when the minute ends
+ * exit code is 1 if any check failed
+ */
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <random>
+#include <filesystem>
+
+#include "hlea/runtime.h"
+#include "hlea/fault_file.h"
+
+#include "default_allocator.h"
+#include "tracking_allocator.h"
+#include "internal_types.h"
+
+#include "generated_bank.h"
+
+namespace fs = std::filesystem;
+
+using namespace hle_audio;
+
+using clock_type = std::chrono::steady_clock;
+
+static const uint32_t CHANNELS = 2;
+static const uint32_t PERIOD_FRAMES = 480; // 10ms
+static const uint32_t PERIODS_PER_CLIENT_FRAME = 2;
+static const uint32_t OBJECT_COUNT = 4;
+static const uint32_t MAX_ACTIONS_PER_FRAME = 4;
+static const uint32_t BANK_CHURN_PERIODS = 300; // 3s
+static const uint32_t STOP_DRAIN_PERIODS = 100; // stopped groups are released in 1s
+static const uint32_t QUIESCE_PERIODS = 300;
+static const double DRIFT_WARNING_RATIO = 1.5;
+
+static double elapsed_ns(clock_type::time_point start) {
+    return std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+}
+
+struct bank_slot_t {
+    const char* name;
+    bench::generated_bank_info_t info;
+    std::string bank_path;
+    std::string stream_path;
+    std::vector<std::string> play_names;
+    std::vector<std::string> stop_names;
+
+    hlea_event_bank_t* bank;
+};
+
+struct latency_t {
+    uint64_t count;
+    double total_ns;
+    double max_ns;
+
+    void add(double ns) {
+        ++count;
+        total_ns += ns;
+        if (max_ns < ns) max_ns = ns;
+    }
+
+    double avg_us() const {
+        return count ? total_ns / count / 1000.0 : 0.0;
+    }
+};
+
+struct minute_report_t {
+    uint32_t minute;
+    double wall_seconds;
+
+    uint64_t events;
+    uint64_t plays;
+    uint64_t bank_loads;
+    uint64_t bank_unloads;
+
+    latency_t fire_event;
+    latency_t process_frame;
+
+    uint32_t peak_active_groups;
+    uint32_t peak_sounds;
+    uint32_t peak_streaming_sources;
+    uint32_t peak_fade_nodes;
+    uint32_t min_cache_free_chunks;
+
+    // stats deltas over the minute
+    uint64_t dropped_events;
+    uint64_t dropped_sounds;
+    uint64_t underruns;
+    uint64_t bytes_read;
+    float read_latency_p99_ms; // since start
+
+    hlea_audio_load_t audio_load;
+
+    // at rest checks
+    uint32_t engine_groups_high_water;
+    int64_t live_allocations;
+    int64_t leaked_allocations; // over the baseline
+    uint32_t failed_checks;
+};
+
+struct soak_state_t {
+    hlea_context_t* ctx;
+    tracking_allocator_t tracking;
+
+    std::vector<bank_slot_t> slots;
+    std::mt19937 rng;
+
+    minute_report_t report;
+    hlea_runtime_stats_t minute_start_stats;
+    uint32_t engine_groups_high_water;
+    std::vector<float> period;
+};
+
+static uint32_t random_below(soak_state_t& state, uint32_t count) {
+    return uint32_t(state.rng() % count);
+}
+
+//
+// banks
+//
+
+static void add_slot(soak_state_t& state, const fs::path& dir, const char* name, const bench::generated_bank_info_t& info) {
+    bank_slot_t slot = {};
+    slot.name = name;
+    slot.info = info;
+    slot.bank_path = (dir / (std::string(name) + ".bank")).string();
+    if (info.stream) slot.stream_path = (dir / (std::string(name) + ".stream")).string();
+
+    slot.info.stream_filename = info.stream ? slot.stream_path.c_str() : nullptr;
+    auto blob = bench::generate_bank(slot.info);
+    slot.info.stream_filename = nullptr;
+
+    FILE* f = fopen(slot.bank_path.c_str(), "wb");
+    if (f) {
+        fwrite(blob.data(), 1, blob.size(), f);
+        fclose(f);
+    }
+
+    for (uint32_t i = 0; i < info.group_count; ++i) {
+        slot.play_names.push_back(bench::play_event_name(i));
+        slot.stop_names.push_back(bench::stop_event_name(i));
+    }
+
+    state.slots.push_back(std::move(slot));
+}
+
+static void generate_banks(soak_state_t& state, const fs::path& dir) {
+    bench::generated_bank_info_t info = {};
+    info.group_count = 32;
+    info.sound_count = 8;
+    info.sound_seconds = 0.3f;
+    add_slot(state, dir, "oneshots", info);
+
+    info = {};
+    info.group_count = 16;
+    info.sound_count = 4;
+    info.sound_seconds = 1.0f;
+    info.loop = true;
+    info.fade = true;
+    add_slot(state, dir, "faded_loops", info);
+
+    info = {};
+    info.group_count = 16;
+    info.sound_count = 8;
+    info.sound_seconds = 3.0f;
+    info.stream = true;
+    add_slot(state, dir, "streamed_oneshots", info);
+
+    info = {};
+    info.group_count = 8;
+    info.sound_count = 4;
+    info.sound_seconds = 4.0f;
+    info.loop = true;
+    info.fade = true;
+    info.stream = true;
+    add_slot(state, dir, "streamed_faded_loops", info);
+}
+
+static void check(soak_state_t& state, bool passed, const char* what, int64_t value);
+
+static void load_slot(soak_state_t& state, bank_slot_t& slot) {
+    if (slot.bank) return;
+
+    const char* stream_path = slot.stream_path.empty() ? nullptr : slot.stream_path.c_str();
+    slot.bank = hlea_load_events_bank(state.ctx, slot.bank_path.c_str(), stream_path);
+    check(state, slot.bank != nullptr, "bank loaded", 0);
+    if (slot.bank) ++state.report.bank_loads;
+}
+
+static void unload_slot(soak_state_t& state, bank_slot_t& slot) {
+    if (!slot.bank) return;
+
+    hlea_unload_events_bank(state.ctx, slot.bank);
+    slot.bank = nullptr;
+    ++state.report.bank_unloads;
+}
+
+//
+// traffic
+//
+
+static void fire_actions(soak_state_t& state, hlea_event_bank_t* bank, hlea_action_type_e type,
+        uint32_t target_index, uint32_t obj_id, float fade_time) {
+    hlea_action_info_t action = {};
+    action.type = type;
+    action.target_index = target_index;
+    action.fade_time = fade_time;
+
+    hlea_fire_event_info_t event_info = {};
+    event_info.bank = bank;
+    event_info.obj_id = obj_id;
+    event_info.actions = &action;
+    event_info.action_count = 1;
+
+    auto start = clock_type::now();
+    hlea_fire_event(state.ctx, &event_info);
+    state.report.fire_event.add(elapsed_ns(start));
+}
+
+static void fire_random_action(soak_state_t& state) {
+    auto& slot = state.slots[random_below(state, uint32_t(state.slots.size()))];
+    if (!slot.bank) return;
+
+    auto ctx = state.ctx;
+    auto group_index = random_below(state, slot.info.group_count);
+    auto obj_id = random_below(state, OBJECT_COUNT);
+    float fade_time = random_below(state, 2) ? 0.1f : 0.0f;
+
+    ++state.report.events;
+
+    auto action = random_below(state, 100);
+    if (action < 45) {
+        auto start = clock_type::now();
+        hlea_fire_event(ctx, slot.bank, slot.play_names[group_index].c_str(), obj_id);
+        state.report.fire_event.add(elapsed_ns(start));
+        ++state.report.plays;
+    } else if (action < 55) {
+        // up to 200ms ahead
+        auto time_pcm = hlea_get_time_pcm(ctx) + random_below(state, hlea_get_sample_rate(ctx) / 5);
+        auto start = clock_type::now();
+        hlea_fire_event_at(ctx, slot.bank, slot.play_names[group_index].c_str(), obj_id, time_pcm);
+        state.report.fire_event.add(elapsed_ns(start));
+        ++state.report.plays;
+    } else if (action < 65) {
+        auto start = clock_type::now();
+        hlea_fire_event(ctx, slot.bank, slot.stop_names[group_index].c_str(), obj_id);
+        state.report.fire_event.add(elapsed_ns(start));
+    } else if (action < 72) {
+        fire_actions(state, slot.bank, hlea_action_type_e::stop, group_index, obj_id, fade_time);
+    } else if (action < 80) {
+        fire_actions(state, slot.bank, hlea_action_type_e::pause, group_index, obj_id, fade_time);
+    } else if (action < 88) {
+        fire_actions(state, slot.bank, hlea_action_type_e::resume, group_index, obj_id, fade_time);
+    } else if (action < 92) {
+        fire_actions(state, slot.bank, hlea_action_type_e::break_loop, group_index, obj_id, 0.0f);
+    } else if (action < 94) {
+        fire_actions(state, slot.bank, hlea_action_type_e::pause_bus, 0, obj_id, fade_time);
+    } else if (action < 97) {
+        fire_actions(state, slot.bank, hlea_action_type_e::resume_bus, 0, obj_id, fade_time);
+    } else if (action < 98) {
+        fire_actions(state, slot.bank, hlea_action_type_e::stop_bus, 0, obj_id, fade_time);
+    } else {
+        fire_actions(state, slot.bank, hlea_action_type_e::stop_all, 0, obj_id, fade_time);
+    }
+}
+
+static void churn_banks(soak_state_t& state) {
+    auto& slot = state.slots[random_below(state, uint32_t(state.slots.size()))];
+    if (slot.bank) unload_slot(state, slot);
+    else load_slot(state, slot);
+}
+
+//
+// frames
+//
+
+static void update_peaks(soak_state_t& state) {
+    hlea_runtime_stats_t stats = {};
+    hlea_get_stats(state.ctx, &stats);
+
+    auto& report = state.report;
+    report.peak_active_groups = std::max(report.peak_active_groups, stats.active_groups.used);
+    report.peak_sounds = std::max(report.peak_sounds, stats.sounds.used);
+    report.peak_streaming_sources = std::max(report.peak_streaming_sources, stats.streaming_sources.used);
+    report.peak_fade_nodes = std::max(report.peak_fade_nodes, stats.fade_nodes.used);
+    report.min_cache_free_chunks = std::min(report.min_cache_free_chunks, stats.cache_free_chunks);
+}
+
+static void process_client_frame(soak_state_t& state) {
+    auto start = clock_type::now();
+    hlea_process_frame(state.ctx);
+    state.report.process_frame.add(elapsed_ns(start));
+}
+
+static void render_period(soak_state_t& state) {
+    hlea_render_pcm(state.ctx, state.period.data(), PERIOD_FRAMES);
+}
+
+//
+// at rest checks
+//
+
+static void check(soak_state_t& state, bool passed, const char* what, int64_t value) {
+    if (passed) return;
+
+    ++state.report.failed_checks;
+    fprintf(stderr, "minute %u: check failed: %s (%lld)\n", state.report.minute, what, (long long)value);
+}
+
+static bool is_at_rest(soak_state_t& state) {
+    hlea_runtime_stats_t stats = {};
+    hlea_get_stats(state.ctx, &stats);
+
+    return !stats.active_groups.used && !state.ctx->pending_sounds_size &&
+        stats.cache_free_chunks == stats.cache_chunk_count &&
+        stats.reads_completed == stats.reads_queued;
+}
+
+static void run_checkpoint(soak_state_t& state, int64_t& allocations_baseline) {
+    auto ctx = state.ctx;
+
+    // timed plays are fired first, so they don't start after stop
+    for (uint32_t i = 0; i < STOP_DRAIN_PERIODS && ctx->timed_events.size; ++i) {
+        if (i % PERIODS_PER_CLIENT_FRAME == 0) process_client_frame(state);
+        render_period(state);
+    }
+
+    // stop everything the way client would, paused groups are stopped too
+    for (uint32_t obj_id = 0; obj_id < OBJECT_COUNT; ++obj_id) {
+        fire_actions(state, nullptr, hlea_action_type_e::stop_all, 0, obj_id, 0.1f);
+    }
+    for (uint32_t i = 0; i < STOP_DRAIN_PERIODS && hlea_get_active_groups_count(ctx); ++i) {
+        if (i % PERIODS_PER_CLIENT_FRAME == 0) process_client_frame(state);
+        render_period(state);
+    }
+    check(state, hlea_get_active_groups_count(ctx) == 0, "stopped groups released", int64_t(hlea_get_active_groups_count(ctx)));
+
+    for (auto& slot : state.slots) unload_slot(state, slot);
+
+    // streaming reads in flight are finished and their chunks released by process frame,
+    // waited in wall time as storage could be slow
+    for (uint32_t i = 0; i < QUIESCE_PERIODS && !is_at_rest(state); ++i) {
+        process_client_frame(state);
+        render_period(state);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    hlea_runtime_stats_t stats = {};
+    hlea_get_stats(ctx, &stats);
+
+    check(state, stats.sounds.used == 0, "sounds released (allocated - recycled)", stats.sounds.used);
+    check(state, stats.active_groups.used == 0, "active groups released", stats.active_groups.used);
+    check(state, stats.engine_groups.used == 0, "engine groups released", stats.engine_groups.used);
+    check(state, stats.streaming_sources.used == 0, "streaming sources released", stats.streaming_sources.used);
+    check(state, stats.buffer_sources.used == 0, "buffer sources released", stats.buffer_sources.used);
+    check(state, stats.fade_nodes.used == 0, "fade nodes released", stats.fade_nodes.used);
+    check(state, ctx->pending_sounds_size == 0, "no pending sounds", ctx->pending_sounds_size);
+    check(state, ctx->timed_events.size == 0, "no timed events", ctx->timed_events.size);
+    check(state, stats.cache_free_chunks == stats.cache_chunk_count, "streaming chunks released",
+        int64_t(stats.cache_chunk_count) - stats.cache_free_chunks);
+    check(state, stats.reads_completed == stats.reads_queued, "streaming reads completed",
+        int64_t(stats.reads_queued - stats.reads_completed));
+
+    // engine groups are kept initialized (allocated) up to their high water,
+    // so the baseline is taken again when it grows
+    auto live_allocations = int64_t(state.tracking.counter);
+    if (allocations_baseline < 0 || state.engine_groups_high_water != stats.engine_groups.high_water) {
+        allocations_baseline = live_allocations;
+        state.engine_groups_high_water = stats.engine_groups.high_water;
+    }
+    state.report.engine_groups_high_water = stats.engine_groups.high_water;
+    state.report.live_allocations = live_allocations;
+    state.report.leaked_allocations = live_allocations - allocations_baseline;
+    check(state, live_allocations <= allocations_baseline, "live allocations", live_allocations - allocations_baseline);
+
+    for (auto& slot : state.slots) load_slot(state, slot);
+}
+
+//
+// report
+//
+
+static void begin_minute(soak_state_t& state, uint32_t minute) {
+    state.report = {};
+    state.report.minute = minute;
+    state.report.min_cache_free_chunks = ~0u;
+    hlea_get_stats(state.ctx, &state.minute_start_stats);
+    hlea_reset_audio_load(state.ctx);
+}
+
+static void end_minute(soak_state_t& state) {
+    hlea_runtime_stats_t stats = {};
+    hlea_get_stats(state.ctx, &stats);
+
+    auto& report = state.report;
+    auto& start = state.minute_start_stats;
+    report.dropped_events = stats.dropped_events - start.dropped_events;
+    report.dropped_sounds = stats.dropped_sounds - start.dropped_sounds;
+    report.underruns = stats.underruns - start.underruns;
+    report.bytes_read = stats.bytes_read - start.bytes_read;
+    report.read_latency_p99_ms = stats.read_latency_p99_ms;
+    hlea_get_audio_load(state.ctx, &report.audio_load);
+}
+
+static void print_minute(const minute_report_t& report, FILE* out) {
+    fprintf(stderr, "minute %3u: %6llu events (%5.1f/s), fire %6.2f us (max %8.2f), frame %6.2f us (max %8.2f), "
+        "groups %3u, sounds %3u, streams %3u, load %.3f (max %.3f), underruns %llu, dropped %llu/%llu, "
+        "allocations %lld (+%lld), failed %u\n",
+        report.minute, (unsigned long long)report.events, report.events / report.wall_seconds,
+        report.fire_event.avg_us(), report.fire_event.max_ns / 1000.0,
+        report.process_frame.avg_us(), report.process_frame.max_ns / 1000.0,
+        report.peak_active_groups, report.peak_sounds, report.peak_streaming_sources,
+        report.audio_load.avg_load, report.audio_load.max_load,
+        (unsigned long long)report.underruns,
+        (unsigned long long)report.dropped_events, (unsigned long long)report.dropped_sounds,
+        (long long)report.live_allocations, (long long)report.leaked_allocations, report.failed_checks);
+
+    if (!out) return;
+
+    fprintf(out, "{\"minute\":%u,\"wall_seconds\":%.3f,\"events\":%llu,\"plays\":%llu,\"bank_loads\":%llu,\"bank_unloads\":%llu,"
+        "\"fire_event_avg_us\":%.3f,\"fire_event_max_us\":%.3f,\"process_frame_avg_us\":%.3f,\"process_frame_max_us\":%.3f,"
+        "\"peak_active_groups\":%u,\"peak_sounds\":%u,\"peak_streaming_sources\":%u,\"peak_fade_nodes\":%u,\"min_cache_free_chunks\":%u,"
+        "\"dropped_events\":%llu,\"dropped_sounds\":%llu,\"underruns\":%llu,\"bytes_read\":%llu,\"read_latency_p99_ms\":%.3f,"
+        "\"audio_load_avg\":%.4f,\"audio_load_max\":%.4f,\"audio_load_p99\":%.4f,"
+        "\"engine_groups_high_water\":%u,\"live_allocations\":%lld,\"leaked_allocations\":%lld,\"failed_checks\":%u}\n",
+        report.minute, report.wall_seconds, (unsigned long long)report.events, (unsigned long long)report.plays,
+        (unsigned long long)report.bank_loads, (unsigned long long)report.bank_unloads,
+        report.fire_event.avg_us(), report.fire_event.max_ns / 1000.0,
+        report.process_frame.avg_us(), report.process_frame.max_ns / 1000.0,
+        report.peak_active_groups, report.peak_sounds, report.peak_streaming_sources, report.peak_fade_nodes,
+        report.min_cache_free_chunks,
+        (unsigned long long)report.dropped_events, (unsigned long long)report.dropped_sounds,
+        (unsigned long long)report.underruns, (unsigned long long)report.bytes_read, report.read_latency_p99_ms,
+        report.audio_load.avg_load, report.audio_load.max_load, report.audio_load.p99_load,
+        report.engine_groups_high_water, (long long)report.live_allocations, (long long)report.leaked_allocations, report.failed_checks);
+    fflush(out);
+}
+
+static double drift_ratio(double first, double last) {
+    return first > 0.0 ? last / first : 0.0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t minutes = 60;
+    double speed = 1.0;
+    uint32_t seed = 1;
+    const char* out_path = nullptr;
+    auto storage = hlea_fault_file_preset_e::none;
+    float short_read_probability = -1.0f;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--minutes") == 0) minutes = uint32_t(atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--speed") == 0) speed = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = uint32_t(atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--out") == 0) out_path = argv[i + 1];
+        else if (strcmp(argv[i], "--storage") == 0 && strcmp(argv[i + 1], "hdd") == 0) storage = hlea_fault_file_preset_e::hdd;
+        else if (strcmp(argv[i], "--storage") == 0 && strcmp(argv[i + 1], "sd_card") == 0) storage = hlea_fault_file_preset_e::sd_card;
+        else if (strcmp(argv[i], "--storage") == 0 && strcmp(argv[i + 1], "network_drive") == 0) storage = hlea_fault_file_preset_e::network_drive;
+        else if (strcmp(argv[i], "--short-reads") == 0) short_read_probability = float(atof(argv[i + 1]));
+        else {
+            fprintf(stderr, "unknown option %s %s, expected: [--minutes N] [--speed X] [--seed S] [--storage hdd|sd_card|network_drive] [--short-reads P] [--out minutes.jsonl]\n", argv[i], argv[i + 1]);
+            return 1;
+        }
+    }
+
+    FILE* out = out_path ? fopen(out_path, "wb") : nullptr;
+    if (out_path && !out) {
+        fprintf(stderr, "couldn't open %s\n", out_path);
+        return 1;
+    }
+
+    soak_state_t state = {};
+    state.rng.seed(seed);
+    state.period.resize(PERIOD_FRAMES * CHANNELS);
+
+    auto dir = fs::temp_directory_path() / "hlea_soak";
+    fs::create_directories(dir);
+    generate_banks(state, dir);
+
+    // live allocations are counted in any build
+    state.tracking.backing_alloc = make_default_allocator();
+    auto allocator = to_allocator(&state.tracking);
+
+    hlea_context_create_info_t info = {};
+    info.allocator_vt = allocator.vt;
+    info.allocator_udata = allocator.udata;
+    info.output_bus_count = 1;
+    info.no_device = true;
+
+    // not tracked, it outlives the context
+    hlea_fault_file_t* fault_file = nullptr;
+    if (storage != hlea_fault_file_preset_e::none || 0.0f < short_read_probability) {
+        hlea_fault_file_create_info_t fault_file_info = {};
+        fault_file_info.settings = hlea_fault_file_preset(storage);
+        if (0.0f <= short_read_probability) fault_file_info.settings.short_read_probability = short_read_probability;
+        fault_file_info.seed = seed;
+        fault_file = hlea_fault_file_create(&fault_file_info);
+
+        info.file_api_vt = hlea_fault_file_api();
+        info.file_sys = fault_file;
+    }
+
+    state.ctx = hlea_create(&info);
+    if (!state.ctx) return 1;
+
+    for (auto& slot : state.slots) load_slot(state, slot);
+    if (state.report.failed_checks) return 1;
+
+    const uint32_t sample_rate = hlea_get_sample_rate(state.ctx);
+    const uint32_t periods_per_minute = 60 * sample_rate / PERIOD_FRAMES;
+    const auto period_duration = std::chrono::duration<double>(double(PERIOD_FRAMES) / sample_rate / (speed > 0.0 ? speed : 1.0));
+
+    int64_t allocations_baseline = -1;
+    uint32_t failed_checks = 0;
+    minute_report_t first_report = {};
+
+    for (uint32_t minute = 0; minute < minutes; ++minute) {
+        begin_minute(state, minute);
+        auto minute_start = clock_type::now();
+
+        for (uint32_t period_index = 0; period_index < periods_per_minute; ++period_index) {
+            if (period_index % PERIODS_PER_CLIENT_FRAME == 0) {
+                auto action_count = random_below(state, MAX_ACTIONS_PER_FRAME);
+                for (uint32_t i = 0; i < action_count; ++i) fire_random_action(state);
+
+                process_client_frame(state);
+                update_peaks(state);
+            }
+            if (period_index % BANK_CHURN_PERIODS == BANK_CHURN_PERIODS - 1) churn_banks(state);
+
+            render_period(state);
+
+            // audio device pace, streaming reads and decoding jobs run meanwhile
+            if (speed > 0.0) {
+                auto period_end = minute_start + std::chrono::duration_cast<clock_type::duration>(period_duration * (period_index + 1));
+                std::this_thread::sleep_until(period_end);
+            }
+        }
+
+        end_minute(state);
+        run_checkpoint(state, allocations_baseline);
+        state.report.wall_seconds = elapsed_ns(minute_start) / 1e9;
+
+        print_minute(state.report, out);
+        failed_checks += state.report.failed_checks;
+        if (minute == 0) first_report = state.report;
+    }
+
+    if (1 < minutes) {
+        auto& last = state.report;
+        auto fire_drift = drift_ratio(first_report.fire_event.avg_us(), last.fire_event.avg_us());
+        auto frame_drift = drift_ratio(first_report.process_frame.avg_us(), last.process_frame.avg_us());
+        auto load_drift = drift_ratio(first_report.audio_load.avg_load, last.audio_load.avg_load);
+
+        fprintf(stderr, "latency drift (last/first minute): fire event %.2fx, process frame %.2fx, audio load %.2fx\n",
+            fire_drift, frame_drift, load_drift);
+        if (DRIFT_WARNING_RATIO < fire_drift || DRIFT_WARNING_RATIO < frame_drift || DRIFT_WARNING_RATIO < load_drift) {
+            fprintf(stderr, "warning: latency drift over %.1fx\n", DRIFT_WARNING_RATIO);
+        }
+        if (out) {
+            fprintf(out, "{\"fire_event_drift\":%.3f,\"process_frame_drift\":%.3f,\"audio_load_drift\":%.3f,\"failed_checks\":%u}\n",
+                fire_drift, frame_drift, load_drift, failed_checks);
+        }
+    }
+
+    for (auto& slot : state.slots) unload_slot(state, slot);
+    hlea_destroy(state.ctx);
+
+    if (fault_file) {
+        hlea_fault_file_stats_t fault_stats = {};
+        hlea_fault_file_get_stats(fault_file, &fault_stats);
+        fprintf(stderr, "storage: %llu reads, %llu bytes, avg delay %.2fms, %llu stalls, %llu short reads\n",
+            (unsigned long long)fault_stats.reads, (unsigned long long)fault_stats.bytes_read,
+            fault_stats.reads ? fault_stats.delay_us / 1000.0 / fault_stats.reads : 0.0,
+            (unsigned long long)fault_stats.stalls, (unsigned long long)fault_stats.short_reads);
+        hlea_fault_file_destroy(fault_file);
+    }
+
+    // everything allocated by runtime is expected to be freed
+    if (state.tracking.counter != 0) {
+        fprintf(stderr, "check failed: %lld allocations not freed after destroy\n", (long long)state.tracking.counter);
+        ++failed_checks;
+    }
+
+    if (out) fclose(out);
+    fs::remove_all(dir);
+
+    fprintf(stderr, "%u minutes, %u failed checks\n", minutes, failed_checks);
+    return failed_checks ? 1 : 0;
+}
@@ -61,6 +61,8 @@ struct file_flow_node_t {
     std::u8string filename;
     bool loop = false;
     bool stream = false;
+    bool cache_decoded = false; // short frequently played sound, decoded once by runtime
+    bool adpcm = false; // wav encoded as ima adpcm on blob save
 };
 
 struct random_flow_node_t {
@@ -70,6 +72,8 @@ struct random_flow_node_t {
 struct fade_flow_node_t {
     float start_time;
     float end_time;
+    rt::fade_curve_t start_curve = {};
+    rt::fade_curve_t end_curve = {};
 };
 
 struct delay_flow_node_t {
@@ -162,14 +166,34 @@ struct audio_file_data_t {
     rt::file_data_t::meta_t meta;
     std::vector<uint8_t> content;
     rt::range_t data_chunk_range;
+    std::vector<rt::seek_point_t> seek_table;
+};
+
+// file node flags merged for all nodes of the file
+struct audio_file_flags_t {
+    bool stream;
+    bool adpcm; // pcm data is asked to be encoded as ima adpcm
 };
 
 class audio_file_data_provider_ti {
 public:
-    virtual audio_file_data_t get_file_data(const char* filename, uint32_t file_index) = 0;
+    virtual audio_file_data_t get_file_data(const char* filename, uint32_t file_index, const audio_file_flags_t& flags) = 0;
 };
 
-std::vector<uint8_t> save_store_blob_buffer(const data_state_t* state, audio_file_data_provider_ti* fdata_provider, const char* streaming_filename = nullptr);
+/**
+ * @brief Compile runtime blob, streamed file data goes to streaming_filename
+ * 
+ * @param stream_part_size_limit when non zero, stream data is split into several files not bigger than the limit
+ *  (unless single sound data is bigger), see stream_part_filename
+ * @return empty buffer if stream data needs more than rt::MAX_STREAM_FILE_PARTS parts
+ */
+std::vector<uint8_t> save_store_blob_buffer(const data_state_t* state, audio_file_data_provider_ti* fdata_provider, 
+        const char* streaming_filename = nullptr, uint64_t stream_part_size_limit = 0);
+
+/**
+ * @return "<streaming_filename>" for the first part, "<streaming_filename>.<part_index>" for others
+ */
+std::string stream_part_filename(const char* streaming_filename, uint32_t part_index);
 
 /**
  * @brief Init data state from Json file
@@ -6,6 +6,8 @@ namespace data {
 const auto KEY_NAME = "name";
 const auto KEY_LOOP = "loop";
 const auto KEY_STREAM = "stream";
+const auto KEY_CACHE_DECODED = "cache_decoded";
+const auto KEY_ADPCM = "adpcm";
 const auto KEY_ACTIONS = "actions";
 const auto KEY_TYPE = "type";
 const auto KEY_TARGET_GROUP_INDEX = "target_group_index";
@@ -28,6 +30,10 @@ const auto KEY_GROUPS = "groups";
 const auto KEY_VOLUME = "volume";
 const auto KEY_START_TIME = "start_time";
 const auto KEY_END_TIME = "end_time";
+const auto KEY_START_CURVE = "start_curve";
+const auto KEY_END_CURVE = "end_curve";
+const auto KEY_CURVE_TYPE = "type";
+const auto KEY_CURVE_POINTS = "points";
 const auto KEY_TIME = "time";
 const auto KEY_FILE = "file";
 
@@ -22,6 +22,24 @@ static const uint32_t CURRENT_VERSION = 3;
 namespace hle_audio {
 namespace data {
 
+static rt::fade_curve_t load_fade_curve(const rapidjson::Value& v, const char* key) {
+    rt::fade_curve_t res = {};
+    if (!v.HasMember(key)) return res;
+
+    auto& curve_v = v[key];
+    res.type = rt::fade_curve_type_from_str(curve_v[KEY_CURVE_TYPE].GetString());
+    if (curve_v.HasMember(KEY_CURVE_POINTS)) {
+        const size_t point_count = sizeof(res.control_points) / sizeof(*res.control_points);
+
+        size_t i = 0;
+        for (auto& point_v : curve_v[KEY_CURVE_POINTS].GetArray()) {
+            if (i == point_count) break;
+            res.control_points[i++] = point_v.GetFloat();
+        }
+    }
+    return res;
+}
+
 static node_id_t load_node(data_state_t* state, const rapidjson::Value& v, size_t group_index) {
     assert(v.IsObject());
     auto node_type = flow_node_type_from_str(v[KEY_TYPE].GetString());
@@ -40,6 +58,8 @@ static node_id_t load_node(data_state_t* state, const rapidjson::Value& v, size_
         node.filename = std::u8string(file_v.GetString(), file_v.GetString() + file_v.GetStringLength());
         node.loop = value_get_opt_bool(v, KEY_LOOP);
         node.stream = value_get_opt_bool(v, KEY_STREAM);
+        node.cache_decoded = value_get_opt_bool(v, KEY_CACHE_DECODED);
+        node.adpcm = value_get_opt_bool(v, KEY_ADPCM);
 
         break;
     }  
@@ -55,6 +75,8 @@ static node_id_t load_node(data_state_t* state, const rapidjson::Value& v, size_
 
         node.start_time = value_get_opt_float(v, KEY_START_TIME);
         node.end_time = value_get_opt_float(v, KEY_END_TIME);
+        node.start_curve = load_fade_curve(v, KEY_START_CURVE);
+        node.end_curve = load_fade_curve(v, KEY_END_CURVE);
 
         break;
     }
@@ -192,6 +214,25 @@ static void write_float(PrettyWriter<FileWriteStream>& writer, float value) {
 
 }
 
+// linear fade is the default, not written
+static void write_fade_curve(PrettyWriter<FileWriteStream>& writer, const char* key, const rt::fade_curve_t& curve) {
+    if (curve.type == rt::fade_curve_type_e::linear) return;
+
+    writer.String(key);
+    writer.StartObject();
+    writer.String(KEY_CURVE_TYPE);
+    writer.String(rt::fade_curve_type_name(curve.type));
+    if (curve.type == rt::fade_curve_type_e::bezier) {
+        writer.String(KEY_CURVE_POINTS);
+        writer.StartArray();
+        for (auto point : curve.control_points) {
+            write_float(writer, point);
+        }
+        writer.EndArray();
+    }
+    writer.EndObject();
+}
+
 static void write_node(PrettyWriter<FileWriteStream>& writer,
         const data_state_t* state, const node_id_t& node_id) {
 
@@ -222,6 +263,14 @@ static void write_node(PrettyWriter<FileWriteStream>& writer,
             writer.String(KEY_STREAM);
             writer.Bool(file_node.stream);
         }
+        if (file_node.cache_decoded) {
+            writer.String(KEY_CACHE_DECODED);
+            writer.Bool(file_node.cache_decoded);
+        }
+        if (file_node.adpcm) {
+            writer.String(KEY_ADPCM);
+            writer.Bool(file_node.adpcm);
+        }
         break;
     }
     case RANDOM_FNODE_TYPE: {
@@ -236,6 +285,8 @@ static void write_node(PrettyWriter<FileWriteStream>& writer,
         write_float(writer, fade_node.start_time);
         writer.String(KEY_END_TIME);
         write_float(writer, fade_node.end_time);
+        write_fade_curve(writer, KEY_START_CURVE, fade_node.start_curve);
+        write_fade_curve(writer, KEY_END_CURVE, fade_node.end_curve);
         break;
     }
     case DELAY_FNODE_TYPE: {
@@ -1,5 +1,6 @@
 #include "data_state.h"
 #include "rt_types.h"
+#include "fade_curve.h"
 #include <vector>
 #include <unordered_map>
 #include <string_view>
@@ -72,6 +73,8 @@ struct save_context_t {
 
     struct file_data_t {
         bool stream;
+        bool cache_decoded;
+        bool adpcm;
         std::u8string_view filename;
     };
     std::vector<file_data_t> sound_file_data;
@@ -84,6 +87,19 @@ struct save_context_t {
     std::vector<saved_node_offset_t> saved_group_nodes;
 };
 
+// linear fades are computed in place by runtime
+static rt::array_view_t<rt::fade_curve_knot_t> write_fade_curve_knots(std::vector<uint8_t>& buf, const rt::fade_curve_t& curve) {
+    if (curve.type == rt::fade_curve_type_e::linear) return {};
+
+    std::vector<rt::fade_curve_knot_t> knots(rt::MAX_FADE_CURVE_KNOTS);
+    auto knot_count = rt::bake_fade_curve_knots(curve, knots.data());
+    assert(knot_count && "curve needs more knots than MAX_FADE_CURVE_KNOTS");
+    if (!knot_count) return {};
+
+    knots.resize(knot_count);
+    return write(buf, knots);
+}
+
 static rt::named_group_t make_named_group(std::vector<uint8_t>& buf, 
         const named_group_t& data_group,
         rt::offset_t first_node_offset) {
@@ -127,6 +143,8 @@ static rt::file_node_t cache_file(std::vector<uint8_t>& buf, save_context_t* ctx
     auto indices_it = ctx->sound_files_indices.find(filename);
     if (indices_it != ctx->sound_files_indices.end()) {
         ctx->sound_file_data[indices_it->second].stream &= file_node.stream;
+        ctx->sound_file_data[indices_it->second].cache_decoded |= file_node.cache_decoded;
+        ctx->sound_file_data[indices_it->second].adpcm |= file_node.adpcm;
         index = indices_it->second;
     } else {
         index = (uint32_t)ctx->sound_file_data.size();
@@ -134,6 +152,8 @@ static rt::file_node_t cache_file(std::vector<uint8_t>& buf, save_context_t* ctx
         
         save_context_t::file_data_t fdata = {};
         fdata.stream = file_node.stream;
+        fdata.cache_decoded = file_node.cache_decoded;
+        fdata.adpcm = file_node.adpcm;
         fdata.filename = filename;
         ctx->sound_file_data.push_back(fdata);
     }
@@ -225,6 +245,8 @@ static rt::offset_t save_node_rec(std::vector<uint8_t>& buf, save_context_t* ctx
         rt::fade_node_t rt_node = {};
         rt_node.start_time = type_data.start_time;
         rt_node.end_time = type_data.end_time;
+        rt_node.start_curve_knots = write_fade_curve_knots(buf, type_data.start_curve);
+        rt_node.end_curve_knots = write_fade_curve_knots(buf, type_data.end_curve);
         auto res = write_single(buf, rt_node);
 
         return res.pos;
@@ -246,7 +268,16 @@ static rt::offset_t save_node_rec(std::vector<uint8_t>& buf, save_context_t* ctx
     return {};
 }
 
-std::vector<uint8_t> save_store_blob_buffer(const data_state_t* state, audio_file_data_provider_ti* fdata_provider, const char* streaming_filename) {
+std::string stream_part_filename(const char* streaming_filename, uint32_t part_index) {
+    std::string res = streaming_filename;
+    if (part_index) {
+        res += "." + std::to_string(part_index);
+    }
+    return res;
+}
+
+std::vector<uint8_t> save_store_blob_buffer(const data_state_t* state, audio_file_data_provider_ti* fdata_provider, 
+        const char* streaming_filename, uint64_t stream_part_size_limit) {
     std::vector<uint8_t> buf;
 
     rt::root_header_t header = {};
@@ -296,13 +327,20 @@ std::vector<uint8_t> save_store_blob_buffer(const data_state_t* state, audio_fil
             streaming_file = fopen(streaming_filename, "wb");
             // expect valid?
         }
+        // track offset explicitly, ftell is limited to 2GB on some platforms
+        uint64_t stream_offset = 0;
+        uint32_t stream_part_index = 0;
 
 
         uint32_t it_index = 0;
         for (auto& sound_file_data : ctx.sound_file_data) {
-            auto fdata = fdata_provider->get_file_data((const char*)sound_file_data.filename.data(), it_index);
             auto stream = sound_file_data.stream;
 
+            audio_file_flags_t flags = {};
+            flags.stream = stream;
+            flags.adpcm = sound_file_data.adpcm;
+            auto fdata = fdata_provider->get_file_data((const char*)sound_file_data.filename.data(), it_index, flags);
+
             // write only data chunk
             auto content_data = fdata.content.data() + fdata.data_chunk_range.offset;
             auto content_data_size = fdata.data_chunk_range.size;
@@ -310,17 +348,31 @@ std::vector<uint8_t> save_store_blob_buffer(const data_state_t* state, audio_fil
             rt::file_data_t rt_fd = {};
             rt_fd.meta = fdata.meta;
             rt_fd.meta.stream = stream ? 1 : 0;
+            rt_fd.meta.cache_decoded = sound_file_data.cache_decoded ? 1 : 0;
+            rt_fd.seek_table = write(buf, fdata.seek_table);
             if (!stream) { 
                 rt_fd.data_buffer = write(buf, content_data, content_data_size);
             } else if (streaming_file) {
-                auto start_offset = ftell(streaming_file);
+                // start next part if the limit is reached
+                if (stream_part_size_limit && stream_offset &&
+                        stream_part_size_limit < stream_offset + content_data_size) {
+                    fclose(streaming_file);
+
+                    ++stream_part_index;
+                    if (rt::MAX_STREAM_FILE_PARTS <= stream_part_index) return {};
+
+                    streaming_file = fopen(stream_part_filename(streaming_filename, stream_part_index).c_str(), "wb");
+                    stream_offset = 0;
+                }
+
                 auto written = fwrite(content_data, content_data_size, 1, streaming_file);
                 assert(written == 1 && "write fully");
 
-                rt::array_view_t<uint8_t> buf_range = {};
-                buf_range.count = content_data_size;
-                buf_range.elements.pos = start_offset;
-                rt_fd.data_buffer = buf_range;
+                rt_fd.stream_range.offset = stream_offset;
+                rt_fd.stream_range.size = content_data_size;
+                rt_fd.stream_file_index = (uint8_t)stream_part_index;
+
+                stream_offset += content_data_size;
             }
             ctx.file_data.push_back(rt_fd);
 
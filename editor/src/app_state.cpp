@@ -239,6 +239,7 @@ static void create_context(app_state_t* state) {
 
     hlea_context_create_info_t ctx_info = {};
     ctx_info.output_bus_count = data_state.output_buses.size();
+    ctx_info.measure_audio_costs = true;
     state->runtime_ctx = hlea_create(&ctx_info);
     bind(state->editor_runtime, state->runtime_ctx);
     
@@ -320,8 +321,12 @@ public:
     rt::editor_runtime_t* editor_rt;
     data::file_data_provider_t fd_prov = {};
 
-    data::audio_file_data_t get_file_data(const char* filename, uint32_t file_index) override {
-        auto res = fd_prov.get_file_data(filename, file_index);
+    data::audio_file_data_t get_file_data(const char* filename, uint32_t file_index, const data::audio_file_flags_t& flags) override {
+        // editor streams the source file as is, so streamed data isn't encoded
+        auto fd_flags = flags;
+        if (fd_flags.stream) fd_flags.adpcm = false;
+
+        auto res = fd_prov.get_file_data(filename, file_index, fd_flags);
 
         cache_audio_file_data(editor_rt, filename, file_index, res.data_chunk_range);
 
@@ -398,6 +403,18 @@ bool process_frame(app_state_t* state) {
         view_state.active_group_infos.push_back(v_info);
     }
 
+    hlea_audio_load_t audio_load = {};
+    hlea_get_audio_load(state->runtime_ctx, &audio_load);
+
+    auto& v_audio_load = view_state.audio_load;
+    v_audio_load.avg = audio_load.avg_load;
+    v_audio_load.max = audio_load.max_load;
+    v_audio_load.p99 = audio_load.p99_load;
+    v_audio_load.overruns = audio_load.overrun_count;
+    v_audio_load.streaming_source_read = audio_load.streaming_source_read_load;
+    v_audio_load.buffer_source_read = audio_load.buffer_source_read_load;
+    v_audio_load.fade_node = audio_load.fade_node_load;
+
     //
     // build up view
     //
@@ -736,6 +753,11 @@ bool process_frame(app_state_t* state) {
         break;
     }
 
+    case view_action_type_e::RUNTIME_RESET_AUDIO_LOAD: {
+        hlea_reset_audio_load(state->runtime_ctx);
+        break;
+    }
+
     case view_action_type_e::NONE:
         break;
     default:
@@ -476,6 +476,20 @@ static void build_selected_group_view(view_state_t& mut_view_state, const data_s
 view_action_type_e build_runtime_view(view_state_t& mut_view_state, const data_state_t& data_state) {
     view_action_type_e action = view_action_type_e::NONE;
 
+    auto& audio_load = mut_view_state.audio_load;
+    ImGui::Text("Audio load: avg %.1f%%, p99 %.0f%%, max %.1f%%",
+        audio_load.avg * 100.0f, audio_load.p99 * 100.0f, audio_load.max * 100.0f);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("reset")) {
+        action = view_action_type_e::RUNTIME_RESET_AUDIO_LOAD;
+    }
+    ImGui::Text("Overruns: %llu, streaming %.1f%%, buffers %.1f%%, fades %.1f%%",
+        (unsigned long long)audio_load.overruns,
+        audio_load.streaming_source_read * 100.0f,
+        audio_load.buffer_source_read * 100.0f,
+        audio_load.fade_node * 100.0f);
+    ImGui::Separator();
+
     size_t index = 0;
     for (auto& bus : data_state.output_buses) {
         ImGui::PushID((void*)(uintptr_t)index);
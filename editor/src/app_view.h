@@ -55,6 +55,7 @@ enum class view_action_type_e {
     RUNTIME_FIRE_GROUP_RESUME,
     RUNTIME_FIRE_GROUP_PAUSE_BUS,
     RUNTIME_FIRE_GROUP_RESUME_BUS,
+    RUNTIME_RESET_AUDIO_LOAD,
     Count
 };
 
@@ -150,6 +151,19 @@ struct view_state_t {
     std::vector<group_info_t> active_group_infos;
     size_t runtime_target_index;
 
+    // share of audio callback period, 1.0 - the whole period
+    struct audio_load_t {
+        float avg;
+        float max;
+        float p99;
+        uint64_t overruns;
+
+        float streaming_source_read;
+        float buffer_source_read;
+        float fade_node;
+    };
+    audio_load_t audio_load = {};
+
     // actions
     node_action_data_t node_action = {};
     size_t action_group_index;
@@ -105,6 +105,27 @@ view_action_type_e build_node_view(const data::file_flow_node_t& file_node, cons
             action = view_action_type_e::NODE_UPDATE;
             desc.out_data->action_data = file_node_copy;
         }
+
+        // streamed sounds aren't cached decoded
+        ImGui::BeginDisabled(file_node.stream);
+        bool cache_state = file_node.stream ? false : file_node.cache_decoded;
+        if (ImGui::Checkbox("cache decoded", &cache_state)) {
+            auto file_node_copy = file_node;
+            file_node_copy.cache_decoded = cache_state;
+
+            action = view_action_type_e::NODE_UPDATE;
+            desc.out_data->action_data = file_node_copy;
+        }
+        ImGui::EndDisabled();
+
+        bool adpcm_state = file_node.adpcm;
+        if (ImGui::Checkbox("adpcm", &adpcm_state)) {
+            auto file_node_copy = file_node;
+            file_node_copy.adpcm = adpcm_state;
+
+            action = view_action_type_e::NODE_UPDATE;
+            desc.out_data->action_data = file_node_copy;
+        }
         ImGui::EndGroup();
     }
     ImGui::SameLine();
@@ -190,6 +211,52 @@ view_action_type_e build_node_view(const data::random_flow_node_t& node, const b
     return action;
 }
 
+/**
+ * @return true if curve is changed (out_curve)
+ */
+static bool build_fade_curve_view(const char* label, const rt::fade_curve_t& curve, float width,
+        imgui_utils::item_state_t* drag_state, rt::fade_curve_t* out_curve) {
+    ImGui::PushID(label);
+
+    bool changed = false;
+    *out_curve = curve;
+
+    ImGui::SetNextItemWidth(width);
+    auto current_index = (int)curve.type;
+    ImGui::Combo(label, &current_index, rt::c_fade_curve_type_names,
+        sizeof(rt::c_fade_curve_type_names) / sizeof(*rt::c_fade_curve_type_names));
+    if (current_index != (int)curve.type) {
+        out_curve->type = (rt::fade_curve_type_e)current_index;
+        changed = true;
+
+        // ease in-out to start editing from
+        if (out_curve->type == rt::fade_curve_type_e::bezier && !curve.control_points[2]) {
+            const rt::fade_curve_t ease_in_out = {rt::fade_curve_type_e::bezier, {0.42f, 0.0f, 0.58f, 1.0f}};
+            *out_curve = ease_in_out;
+        }
+    }
+
+    if (curve.type == rt::fade_curve_type_e::bezier) {
+        static const char* const point_labels[] = {"p1 x", "p1 y", "p2 x", "p2 y"};
+
+        float changed_value;
+        for (size_t i = 0; i < 4; ++i) {
+            ImGui::SetNextItemWidth(width);
+            if (imgui_utils::DragFloatWithState(drag_state, point_labels[i], curve.control_points[i], &changed_value) &&
+                    changed_value != curve.control_points[i]) {
+                // x is kept in [0, 1] for the curve to be a function of time
+                if (i % 2 == 0) changed_value = std::clamp(changed_value, 0.0f, 1.0f);
+
+                out_curve->control_points[i] = changed_value;
+                changed = true;
+            }
+        }
+    }
+
+    ImGui::PopID();
+    return changed;
+}
+
 view_action_type_e build_node_view(const data::fade_flow_node_t& node, const build_node_view_desc_t& desc) {
     const float node_width = ImNodes::GetStyle().GridSpacing * 5.0f - ImNodes::GetStyle().NodePadding.x * 2.0f;
 
@@ -234,6 +301,22 @@ view_action_type_e build_node_view(const data::fade_flow_node_t& node, const bui
             desc.out_data->action_data = node_copy;
         }
 
+        rt::fade_curve_t changed_curve;
+        if (build_fade_curve_view("start curve", node.start_curve, node_width, &drag_state, &changed_curve)) {
+            auto node_copy = node;
+            node_copy.start_curve = changed_curve;
+
+            action = view_action_type_e::NODE_UPDATE;
+            desc.out_data->action_data = node_copy;
+        }
+        if (build_fade_curve_view("end curve", node.end_curve, node_width, &drag_state, &changed_curve)) {
+            auto node_copy = node;
+            node_copy.end_curve = changed_curve;
+
+            action = view_action_type_e::NODE_UPDATE;
+            desc.out_data->action_data = node_copy;
+        }
+
         ImGui::EndGroup();
     }
     ImNodes::EndNode();
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace hle_audio {
+namespace rt {
+
+/**
+ * IMA ADPCM blocks layout (audio_format_type_e::adpcm)
+ *
+ * block: [channel headers][channel codes]...
+ *  - header per channel: int16 predictor, uint8 step index, uint8 reserved
+ *  - codes per channel: ADPCM_BLOCK_FRAMES 4-bit codes, low nibble first
+ *
+ * channels are planar within the block, so every block could be decoded independently,
+ * the last block is padded with silence up to ADPCM_BLOCK_FRAMES
+ */
+
+static const uint32_t ADPCM_BLOCK_FRAMES = 1024;
+static const uint32_t ADPCM_BLOCK_HEADER_SIZE = 4;
+static const uint32_t ADPCM_BLOCK_CODES_SIZE = ADPCM_BLOCK_FRAMES / 2;
+static const uint8_t ADPCM_MAX_CHANNELS = 2;
+
+static size_t adpcm_block_size(uint8_t channels) {
+    return (ADPCM_BLOCK_HEADER_SIZE + ADPCM_BLOCK_CODES_SIZE) * channels;
+}
+
+static const int16_t ADPCM_STEP_TABLE[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t ADPCM_INDEX_TABLE[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+struct adpcm_channel_state_t {
+    int32_t predictor;
+    int32_t step_index;
+};
+
+static int16_t adpcm_decode_sample(adpcm_channel_state_t* state, uint8_t code) {
+    int32_t step = ADPCM_STEP_TABLE[state->step_index];
+
+    int32_t diff = step >> 3;
+    if (code & 1) diff += step >> 2;
+    if (code & 2) diff += step >> 1;
+    if (code & 4) diff += step;
+    if (code & 8) diff = -diff;
+
+    int32_t predictor = state->predictor + diff;
+    predictor = predictor < INT16_MIN ? INT16_MIN : predictor;
+    predictor = INT16_MAX < predictor ? INT16_MAX : predictor;
+    state->predictor = predictor;
+
+    int32_t step_index = state->step_index + ADPCM_INDEX_TABLE[code];
+    step_index = step_index < 0 ? 0 : step_index;
+    step_index = 88 < step_index ? 88 : step_index;
+    state->step_index = step_index;
+
+    return int16_t(predictor);
+}
+
+/**
+ * @brief finds the code closest to the sample, state is updated the same way decoder does
+ */
+static uint8_t adpcm_encode_sample(adpcm_channel_state_t* state, int16_t sample) {
+    int32_t step = ADPCM_STEP_TABLE[state->step_index];
+    int32_t diff = int32_t(sample) - state->predictor;
+
+    uint8_t code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+
+    if (step <= diff) { code |= 4; diff -= step; }
+    step >>= 1;
+    if (step <= diff) { code |= 2; diff -= step; }
+    step >>= 1;
+    if (step <= diff) { code |= 1; }
+
+    adpcm_decode_sample(state, code);
+    return code;
+}
+
+}
+}
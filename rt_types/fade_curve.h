@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cmath>
+#include "rt_types.h"
+
+namespace hle_audio {
+namespace rt {
+
+/**
+ * fade curves are baked into piecewise linear knots over normalized fade time,
+ * so runtime evaluation is a segment lookup and lerp.
+ * Knots are placed adaptively: a segment is split until the lerp is within FADE_CURVE_MAX_ERROR
+ * of the exact curve, steep parts (bezier vertical tangent) get dense knots
+ */
+
+static const float FADE_CURVE_MAX_ERROR = 1e-3f;
+
+// segments narrower are not split (x resolution of 10s fade at 48kHz is 2e-6)
+static const float FADE_CURVE_MIN_SEGMENT = 1e-6f;
+
+static const uint32_t FADE_CURVE_INITIAL_SEGMENTS = 16;
+static const uint32_t MAX_FADE_CURVE_KNOTS = 256; // bezier curves take about 100
+
+static const float FADE_CURVE_PI = 3.14159265358979f;
+
+// exponential curve range, -60 dB at the fade start
+static const float FADE_CURVE_EXP_DECADES = 3.0f;
+
+static float bezier_coord(float t, float c1, float c2) {
+    float it = 1.0f - t;
+    return 3.0f * it * it * t * c1 + 3.0f * it * t * t * c2 + t * t * t;
+}
+
+static float bezier_coord_derivative(float t, float c1, float c2) {
+    float it = 1.0f - t;
+    return 3.0f * it * it * c1 + 6.0f * it * t * (c2 - c1) + 3.0f * t * t * (1.0f - c2);
+}
+
+/**
+ * @brief y of bezier (0, 0), p1, p2, (1, 1) at x, control x is expected in [0, 1] (monotonic x)
+ */
+static float evaluate_bezier_curve(const float control_points[4], float x) {
+    const float p1x = control_points[0];
+    const float p1y = control_points[1];
+    const float p2x = control_points[2];
+    const float p2y = control_points[3];
+
+    // newton steps, bisection keeps t in the bracket when derivative is flat
+    float t_lo = 0.0f;
+    float t_hi = 1.0f;
+    float t = x;
+    for (int i = 0; i < 16; ++i) {
+        float dx = bezier_coord(t, p1x, p2x) - x;
+        if (std::fabs(dx) < 1e-6f) break;
+
+        if (dx < 0.0f) t_lo = t;
+        else t_hi = t;
+
+        float d = bezier_coord_derivative(t, p1x, p2x);
+        bool newton_step = 1e-6f < std::fabs(d) && t_lo < t - dx / d && t - dx / d < t_hi;
+        t = newton_step ? t - dx / d : 0.5f * (t_lo + t_hi);
+    }
+
+    return bezier_coord(t, p1y, p2y);
+}
+
+/**
+ * @brief fade in gain at normalized fade time x
+ */
+static float evaluate_fade_curve(const fade_curve_t& curve, float x) {
+    x = x < 0.0f ? 0.0f : (1.0f < x ? 1.0f : x);
+
+    switch (curve.type) {
+    case fade_curve_type_e::bezier:
+        return evaluate_bezier_curve(curve.control_points, x);
+    case fade_curve_type_e::exponential: {
+        const float floor_gain = std::pow(10.0f, -FADE_CURVE_EXP_DECADES);
+        return (std::pow(10.0f, FADE_CURVE_EXP_DECADES * (x - 1.0f)) - floor_gain) / (1.0f - floor_gain);
+    }
+    case fade_curve_type_e::equal_power:
+        return std::sin(x * 0.5f * FADE_CURVE_PI);
+    default:
+        return x;
+    }
+}
+
+static float lerp_fade_curve_knots(const fade_curve_knot_t& k0, const fade_curve_knot_t& k1, float x) {
+    if (k1.x <= k0.x) return k1.y;
+    return k0.y + (k1.y - k0.y) * (x - k0.x) / (k1.x - k0.x);
+}
+
+/**
+ * @brief max lerp error of [k0, k1] segment, checked at inner quarter points
+ */
+static float fade_curve_segment_error(const fade_curve_t& curve, const fade_curve_knot_t& k0, const fade_curve_knot_t& k1) {
+    float max_error = 0.0f;
+    for (int i = 1; i < 4; ++i) {
+        float x = k0.x + (k1.x - k0.x) * 0.25f * float(i);
+        float error = std::fabs(lerp_fade_curve_knots(k0, k1, x) - evaluate_fade_curve(curve, x));
+        max_error = max_error < error ? error : max_error;
+    }
+    return max_error;
+}
+
+static bool bake_fade_curve_segment(const fade_curve_t& curve, const fade_curve_knot_t& k0, const fade_curve_knot_t& k1,
+        fade_curve_knot_t* knots, uint32_t* knot_count) {
+    // checked points miss the exact max, so with margin
+    if (FADE_CURVE_MIN_SEGMENT < k1.x - k0.x && 0.5f * FADE_CURVE_MAX_ERROR < fade_curve_segment_error(curve, k0, k1)) {
+        float mid_x = 0.5f * (k0.x + k1.x);
+        fade_curve_knot_t mid = {mid_x, evaluate_fade_curve(curve, mid_x)};
+        return bake_fade_curve_segment(curve, k0, mid, knots, knot_count) &&
+            bake_fade_curve_segment(curve, mid, k1, knots, knot_count);
+    }
+
+    if (*knot_count == MAX_FADE_CURVE_KNOTS) return false;
+    knots[(*knot_count)++] = k1;
+    return true;
+}
+
+/**
+ * @brief bakes knots from x 0 to 1 (MAX_FADE_CURVE_KNOTS at most)
+ * @return knot count, 0 if the curve needs more knots
+ */
+static uint32_t bake_fade_curve_knots(const fade_curve_t& curve, fade_curve_knot_t* knots) {
+    uint32_t knot_count = 0;
+    fade_curve_knot_t k0 = {0.0f, evaluate_fade_curve(curve, 0.0f)};
+    knots[knot_count++] = k0;
+
+    for (uint32_t i = 1; i <= FADE_CURVE_INITIAL_SEGMENTS; ++i) {
+        float x = float(i) / float(FADE_CURVE_INITIAL_SEGMENTS);
+        fade_curve_knot_t k1 = {x, evaluate_fade_curve(curve, x)};
+        if (!bake_fade_curve_segment(curve, k0, k1, knots, &knot_count)) return 0;
+        k0 = k1;
+    }
+    return knot_count;
+}
+
+/**
+ * @brief gain at x, segment_hint is the segment of the previous sample (faded x moves monotonically),
+ *  it's updated to the segment of x
+ */
+static float sample_fade_curve_knots(const fade_curve_knot_t* knots, uint32_t knot_count, float x, uint32_t* segment_hint) {
+    assert(2 <= knot_count);
+    if (x <= knots[0].x) return knots[0].y;
+    if (knots[knot_count - 1].x <= x) return knots[knot_count - 1].y;
+
+    uint32_t segment = *segment_hint < knot_count - 1 ? *segment_hint : knot_count - 2;
+    while (x < knots[segment].x) --segment;
+    while (knots[segment + 1].x < x) ++segment;
+    *segment_hint = segment;
+
+    return lerp_fade_curve_knots(knots[segment], knots[segment + 1], x);
+}
+
+}
+}
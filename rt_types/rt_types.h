@@ -33,6 +33,12 @@ struct range_t {
     uint32_t size;
 };
 
+// stream bank files could exceed 4GB, so only the offset is 64-bit
+struct stream_range_t {
+    uint64_t offset;
+    uint32_t size;
+};
+
 static bool is_empty(data_buffer_t buf) {
     return buf.size == 0;
 }
@@ -69,7 +75,7 @@ struct array_view_t {
 // rt blob types
 //
 
-static const uint32_t STORE_BLOB_VERSION = 7;
+static const uint32_t STORE_BLOB_VERSION = 12;
 
 enum class node_type_e : uint8_t {
     FILE,
@@ -95,11 +101,60 @@ struct random_node_t {
     array_view_t<offset_t> nodes;
 };
 
+enum class fade_curve_type_e : uint8_t {
+    linear,
+    bezier,
+    exponential, // linear in dB
+    equal_power
+};
+
+static const char* const c_fade_curve_type_names[] = {
+    "linear",
+    "bezier",
+    "exponential",
+    "equal_power"
+};
+
+static const char* fade_curve_type_name(fade_curve_type_e type) {
+    return c_fade_curve_type_names[(size_t)type];
+}
+
+static fade_curve_type_e fade_curve_type_from_str(const char* str) {
+    int i = 0;
+    for (auto name : c_fade_curve_type_names) {
+        if (strcmp(name, str) == 0) {
+            return (fade_curve_type_e)i;
+        }
+        ++i;
+    }
+    return fade_curve_type_e::linear;
+}
+
+/**
+ * @brief fade in gain shape over normalized fade time, fade out uses it reversed (see fade_curve.h)
+ */
+struct fade_curve_t {
+    fade_curve_type_e type;
+    float control_points[4]; // bezier p1.x, p1.y, p2.x, p2.y, the curve goes from (0, 0) to (1, 1)
+};
+
+/**
+ * baked fade curve point (see fade_curve.h)
+ */
+struct fade_curve_knot_t {
+    float x;
+    float y;
+};
+
 struct fade_node_t {
     node_type_e type = node_type_e::FADE;
 
     float start_time;
     float end_time;
+
+    // curves baked by tool (knots sorted by x, from 0 to 1), empty for linear fades
+    array_view_t<fade_curve_knot_t> start_curve_knots;
+    array_view_t<fade_curve_knot_t> end_curve_knots;
 };
 
 struct delay_node_t {
@@ -174,7 +229,21 @@ enum class audio_format_type_e : uint8_t {
     none,
     pcm,
     mp3,
-    vorbis
+    vorbis,
+    adpcm // ima adpcm blocks, see adpcm.h
+};
+
+// stream data parts limit, bank is not compiled if it needs more
+static const uint8_t MAX_STREAM_FILE_PARTS = 8;
+
+/**
+ * decoding starts from byte_offset, first discard_frames decoded frames are dropped
+ * (warming up mp3 bit reservoir), then output continues from frame_index
+ */
+struct seek_point_t {
+    uint32_t byte_offset; // within file data
+    uint32_t frame_index;
+    uint16_t discard_frames;
 };
 
 struct file_data_t {
@@ -186,10 +255,17 @@ struct file_data_t {
         uint32_t            sample_rate;
         uint8_t             stream; // flag [0|1]
         uint8_t             channels;
+        uint8_t             cache_decoded; // flag [0|1], decoded once and played from runtime cache
     };
 
     meta_t meta;
-    array_view_t<uint8_t> data_buffer;
+    array_view_t<uint8_t> data_buffer; // resident data (meta.stream == 0)
+
+    // streamed data (meta.stream == 1)
+    stream_range_t stream_range;
+    uint8_t stream_file_index; // stream bank file part
+
+    array_view_t<seek_point_t> seek_table; // sorted by frame_index, empty if format has no seek points
 };
 
 struct store_t {
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include "alloc_types.h"
+#include "file_types.h"
+
+/**
+ * file api wrapper simulating slow or unreliable storage for streaming tests (HDD, SD card,
+ * network drive): reads are delayed and occasionally stalled or cut short.
+ * Used as context file api: file_api_vt = hlea_fault_file_api(), file_sys = fault file
+ */
+struct hlea_fault_file_t;
+
+struct hlea_fault_file_settings_t {
+    // read latency is log-normal, median_ms * e^(spread * N(0, 1)) plus uniform [0, jitter_ms]
+    float latency_median_ms;
+    float latency_spread;
+    float jitter_ms;
+
+    // reads are transferred one after another as from a single device (0 - unlimited)
+    uint64_t bandwidth_bytes_per_second;
+
+    // read is delayed by stall_ms more
+    float stall_probability;
+    float stall_ms;
+
+    // read returns random part of requested bytes
+    float short_read_probability;
+};
+
+enum class hlea_fault_file_preset_e {
+    none,
+    hdd,
+    sd_card,
+    network_drive
+};
+
+hlea_fault_file_settings_t hlea_fault_file_preset(hlea_fault_file_preset_e preset);
+
+struct hlea_fault_file_create_info_t {
+    // wrapped files, default (stdio) files if not set
+    const hlea_file_ti* file_api_vt;
+    void* file_sys;
+
+    const hlea_allocator_ti* allocator_vt;
+    void* allocator_udata;
+
+    hlea_fault_file_settings_t settings;
+    uint32_t seed;
+};
+
+hlea_fault_file_t* hlea_fault_file_create(const hlea_fault_file_create_info_t* info);
+void hlea_fault_file_destroy(hlea_fault_file_t* fault_file);
+
+// applied to the next reads, could be called from any thread
+void hlea_fault_file_set_settings(hlea_fault_file_t* fault_file, const hlea_fault_file_settings_t* settings);
+
+const hlea_file_ti* hlea_fault_file_api();
+
+struct hlea_fault_file_stats_t {
+    uint64_t reads;
+    uint64_t bytes_read;
+    uint64_t delay_us; // total of all reads
+    uint64_t stalls;
+    uint64_t short_reads;
+};
+void hlea_fault_file_get_stats(hlea_fault_file_t* fault_file, hlea_fault_file_stats_t* out_stats);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 struct hlea_job_t {
     void (*job_func)(void* udata);
     void* udata;
@@ -7,4 +9,13 @@ struct hlea_job_t {
 
 struct hlea_jobs_ti {
     void (*launch)(void* udata, hlea_job_t job);
+
+    // optional, submits all jobs with a single wakeup (jobs are launched one by one if not set)
+    void (*launch_batch)(void* udata, const hlea_job_t* jobs, uint32_t job_count);
+};
+
+enum class hlea_thread_priority_e {
+    normal,
+    low,
+    high,
 };
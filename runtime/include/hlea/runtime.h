@@ -21,7 +21,56 @@ struct hlea_context_create_info_t {
     const hlea_jobs_ti* jobs_vt;
     void* jobs_udata;
 
+    // built-in work-stealing job pool, used if jobs_vt isn't set (0 - hardware threads - 1)
+    uint8_t job_thread_count;
+    // Windows thread priority, Apple qos class, Linux nice value (high needs CAP_SYS_NICE or RLIMIT_NICE),
+    // failure is reported to stderr and threads keep normal priority
+    hlea_thread_priority_e job_thread_priority;
+    // worker i is pinned to i-th set bit core (0 - no affinity)
+    uint64_t job_thread_affinity_mask;
+
     uint8_t output_bus_count;
+
+    // number of streaming reading threads, stream bank files are spread among them (0 - single thread)
+    uint8_t streaming_read_thread_count;
+
+    // decoders with less decoded audio buffered are decoded in the next batch (0 - default, 60ms)
+    uint16_t decode_watermark_ms;
+
+    // decoded buffers ring depth per decoder, power of 2 (0 - default)
+    uint8_t mp3_output_buffer_count;
+    uint8_t vorbis_output_buffer_count;
+
+    // decoders created upfront per format. Released decoders are always kept for reuse, so
+    // decoders are allocated only till the high water of playing sounds per format is reached
+    // (0 - none upfront, the first plays allocate them)
+    uint16_t mp3_decoder_pool_size;
+    uint16_t vorbis_decoder_pool_size;
+    uint16_t pcm_decoder_pool_size;
+    uint16_t adpcm_decoder_pool_size;
+
+    // decoded (s16) cache of compressed sounds, up to decoded_cache_sound_bytes or flagged in project,
+    // cached sounds are played without decoding (0 - disabled)
+    uint64_t decoded_cache_budget_bytes;
+    uint32_t decoded_cache_sound_bytes;
+    // cacheable sounds are decoded on job threads when bank is loaded, otherwise on the first play
+    bool decode_on_bank_load;
+
+    // timed play/stop/pause events are applied this earlier than their time,
+    // expected to cover hlea_process_frame period (0 - default, 50ms)
+    uint16_t schedule_ahead_ms;
+
+    // hlea_process_frame is run by internal thread with this period, so streaming and group
+    // transitions don't depend on client frame pacing. Api calls are synchronized with it
+    // (0 - no thread, client calls hlea_process_frame)
+    uint16_t update_thread_period_ms;
+
+    // fade nodes and data source reads are timed on audio thread, see hlea_audio_load_t
+    bool measure_audio_costs;
+
+    // no audio device is opened, client renders audio with hlea_render_pcm (48kHz stereo),
+    // e.g. offline rendering and benchmarks
+    bool no_device;
 };
 
 hlea_context_t* hlea_create(hlea_context_create_info_t* info);
@@ -30,11 +79,44 @@ void hlea_destroy(hlea_context_t* ctx);
 void hlea_suspend(hlea_context_t* ctx);
 void hlea_wakeup(hlea_context_t* ctx);
 
+/**
+ * renders frame_count interleaved f32 frames of context without device (see no_device),
+ * audio thread processing is run on the calling thread and counted in audio load
+ */
+void hlea_render_pcm(hlea_context_t* ctx, float* frames_out, uint32_t frame_count);
+
 /**
  * banks
  */
 hlea_event_bank_t* hlea_load_events_bank(hlea_context_t* ctx, const char* bank_filename, const char* stream_bank_filename);
+
+/**
+ * stream data could be split into several files (see hlea_tool stream part size),
+ * files are expected in part order: "<stream_bank>", "<stream_bank>.1", "<stream_bank>.2"...
+ * 8 parts at most (tool doesn't compile more), bank isn't loaded if more are passed
+ */
+struct hlea_events_bank_load_info_t {
+    const char* bank_filename;
+    const char* const* stream_bank_filenames;
+    uint8_t stream_bank_count;
+};
+hlea_event_bank_t* hlea_load_events_bank(hlea_context_t* ctx, const hlea_events_bank_load_info_t* info);
 hlea_event_bank_t* hlea_load_events_bank_from_buffer(hlea_context_t* ctx, const uint8_t* buf, size_t buf_size);
+
+/**
+ * stream bank data embedded into already opened file (e.g. pak archive)
+ * file is opened with context file api (hlea_file_ti) and is not closed on bank unload.
+ * Requires context created with file_api_vt, the load fails otherwise.
+ * The streaming thread seeks the handle, so it shouldn't be read concurrently from the client side
+ */
+struct hlea_stream_bank_region_t {
+    hlea_file_handle_t file;
+    uint64_t base_offset;
+    uint64_t size;
+};
+// 8 regions at most, as stream parts
+hlea_event_bank_t* hlea_load_events_bank_from_buffer(hlea_context_t* ctx, const uint8_t* buf, size_t buf_size, 
+        const hlea_stream_bank_region_t* stream_regions, uint8_t stream_region_count);
 void hlea_unload_events_bank(hlea_context_t* ctx, hlea_event_bank_t* bank);
 
 /**
@@ -72,10 +154,123 @@ struct hlea_fire_event_info_t {
 };
 void hlea_fire_event(hlea_context_t* ctx, const hlea_fire_event_info_t* event_info);
 
+/**
+ * timed events, time is engine time in pcm frames (see hlea_get_time_pcm).
+ * Play, stop and pause actions start at exact time, the rest are fired by hlea_process_frame
+ * once time is reached. Past times are fired right away
+ */
+uint64_t hlea_get_time_pcm(hlea_context_t* ctx);
+uint32_t hlea_get_sample_rate(hlea_context_t* ctx);
+
+void hlea_fire_event_at(hlea_context_t* ctx, hlea_event_bank_t* bank, const char* eventName, uint32_t obj_id, uint64_t time_pcm);
+void hlea_fire_event_at(hlea_context_t* ctx, const hlea_fire_event_info_t* event_info, uint64_t time_pcm);
+void hlea_fire_event_delayed(hlea_context_t* ctx, hlea_event_bank_t* bank, const char* eventName, uint32_t obj_id, float delay);
+
 // volumes
 void hlea_set_main_volume(hlea_context_t* ctx, float volume);
 void hlea_set_bus_volume(hlea_context_t* ctx, uint8_t bus_index, float volume);
 
+/**
+ * runtime stats, counters are totals since context creation
+ */
+struct hlea_pool_stats_t {
+    uint32_t used;
+    uint32_t high_water;
+    uint32_t capacity;
+};
+
+struct hlea_runtime_stats_t {
+    hlea_pool_stats_t sounds;
+    hlea_pool_stats_t active_groups;
+    hlea_pool_stats_t engine_groups;
+    hlea_pool_stats_t streaming_sources;
+    hlea_pool_stats_t buffer_sources;
+    hlea_pool_stats_t fade_nodes;
+
+    // streaming chunks cache
+    uint64_t cache_hits;
+    uint64_t cache_misses;
+    uint64_t cache_evictions; // cached chunk reused for another read
+    uint64_t cache_no_free_chunk; // chunk requests failed, all chunks are in use
+    uint32_t cache_free_chunks;
+    uint32_t cache_chunk_count;
+
+    // streaming file reads, latency is from queueing to read completion
+    uint64_t reads_queued;
+    uint64_t reads_completed;
+    uint64_t bytes_read;
+    float read_latency_p50_ms; // log2 histogram bucket upper bound
+    float read_latency_p95_ms;
+    float read_latency_p99_ms;
+
+    // decoding steps run on job threads
+    uint64_t decode_jobs;
+    uint64_t decode_time_us;
+
+    // sound reads with no decoded or streamed frames ready, audible as gaps
+    uint64_t underruns;
+
+    // plays dropped as group pools are exhausted
+    uint64_t dropped_events;
+    // sounds not started as sound or data source pools are exhausted
+    uint64_t dropped_sounds;
+};
+void hlea_get_stats(hlea_context_t* ctx, hlea_runtime_stats_t* out_stats);
+
+/**
+ * audio callback load, wall time of device callbacks relative to their period duration
+ * (1.0 - the whole period). Measured since context creation or the last reset
+ */
+struct hlea_audio_load_t {
+    uint64_t callback_count;
+    uint64_t overrun_count; // callbacks longer than their period
+
+    float min_load;
+    float avg_load;
+    float max_load;
+    float p99_load; // 1% histogram bucket upper bound
+
+    // load share of fade nodes and data source reads, if measure_audio_costs is set
+    float streaming_source_read_load;
+    float buffer_source_read_load;
+    float fade_node_load;
+};
+void hlea_get_audio_load(hlea_context_t* ctx, hlea_audio_load_t* out_load);
+
+// measurement restarts from the next callback
+void hlea_reset_audio_load(hlea_context_t* ctx);
+
+/**
+ * tracing of file reads, chunk requests, decoding, events and data source reads,
+ * recorded if runtime is built with HLEA_TRACING (calls do nothing otherwise).
+ * Each thread keeps its latest events in own ring buffer
+ */
+enum class hlea_trace_phase_e {
+    begin,
+    end,
+    instant
+};
+
+struct hlea_trace_event_t {
+    const char* name; // static string
+    hlea_trace_phase_e phase;
+    uint64_t time_ns; // steady clock
+    uint64_t value; // instant events, e.g. bytes read
+};
+
+/**
+ * @brief forwards events to external profiler, called on the thread of the event (audio thread included).
+ *  Expected to be set before runtime is created, nullptr resets it
+ */
+typedef void (*hlea_trace_callback_t)(const hlea_trace_event_t* event, void* udata);
+void hlea_set_trace_callback(hlea_trace_callback_t callback, void* udata);
+
+/**
+ * @brief writes recorded events as Chrome trace event json (chrome://tracing, ui.perfetto.dev),
+ *  false if file is not written or tracing is disabled
+ */
+bool hlea_trace_dump(const char* path);
+
 /** 
  * editor api
  * todo: move out of public header to its own implemenation files
@@ -1,5 +1,6 @@
 #include "async_file_reader.h"
 #include "alloc_utils.inl"
+#include "trace.h"
 
 #include <atomic>
 #include <thread>
@@ -10,8 +11,6 @@
 
 #include "miniaudio_public.h"
 
-static const bool ENABLE_DEBUG_READ_DELAY = false;
-static const auto DEBUG_READ_DELAY = std::chrono::milliseconds(2000);
 static const auto REQUESTS_WAIT_TIME = std::chrono::milliseconds(1);
 
 namespace hle_audio {
@@ -19,6 +18,8 @@ namespace rt {
 
 struct async_file_data_t {
     ma_vfs_file file;
+    uint64_t base_offset;
+    uint8_t lane;
 };
 
 struct ring_indices_u32_t {
@@ -30,6 +31,23 @@ struct ring_indices_u32_t {
 static const size_t MAX_OPENED_FILES = 512;
 static const size_t MAX_READ_REQUESTS = 512;
 
+/*
+ * read token layout: [lane:8][request position:24]
+ */
+static const uint32_t TOKEN_POS_BITS = 24;
+static const uint32_t TOKEN_POS_MASK = (1u << TOKEN_POS_BITS) - 1;
+
+struct read_lane_t {
+    std::atomic<uint32_t> read_pos_processed;
+
+    async_read_request_t read_requests[MAX_READ_REQUESTS];
+    std::chrono::steady_clock::time_point queued_times[MAX_READ_REQUESTS]; // latency stats
+    ring_indices_u32_t read_request_indices;
+    std::mutex request_write_mutex;
+    std::condition_variable request_signal;
+    std::thread reading_thread;
+};
+
 struct async_file_reader_t {
     allocator_t allocator;
     ma_vfs* vfs;
@@ -40,13 +58,11 @@ struct async_file_reader_t {
     async_file_handle_t opened_files_freed[MAX_OPENED_FILES];
     size_t opened_files_freed_count;
 
-    std::atomic<uint32_t> read_pos_processed;
+    read_lane_t lanes[MAX_READ_LANES];
+    uint8_t lane_count;
+
+    runtime_counters_t* counters;
 
-    async_read_request_t read_requests[MAX_READ_REQUESTS];
-    ring_indices_u32_t read_request_indices;
-    std::mutex request_write_mutex;
-    std::condition_variable request_signal;
-    std::thread reading_thread;
     std::atomic<bool> stopped;
 };
 
@@ -70,35 +86,58 @@ static uint16_t to_request_index(uint32_t pos) {
     return pos & (MAX_READ_REQUESTS - 1);
 }
 
-static void process_async_reader(async_file_reader_t* reader) {
+static async_read_token_t make_token(uint8_t lane, uint32_t pos) {
+    static_assert(MAX_READ_LANES <= (1u << (32 - TOKEN_POS_BITS)), "lane index should fit token lane bits");
+    static_assert(MAX_READ_REQUESTS < TOKEN_POS_MASK, "queued requests should fit token position bits");
+
+    return async_read_token_t((uint32_t(lane) << TOKEN_POS_BITS) | (pos & TOKEN_POS_MASK));
+}
+
+static void process_async_reader(async_file_reader_t* reader, read_lane_t* lane) {
+    HLEA_TRACE_THREAD_NAME("hlea file reader");
+
     while(!reader->stopped) {
-        if (!can_read(reader->read_request_indices)) {
+        if (!can_read(lane->read_request_indices)) {
             // nothing to read, wait
-            std::unique_lock<std::mutex> lk(reader->request_write_mutex);
-            reader->request_signal.wait(lk, [reader]() {
+            std::unique_lock<std::mutex> lk(lane->request_write_mutex);
+            lane->request_signal.wait(lk, [reader, lane]() {
                 if (reader->stopped) return true;
 
-                return can_read(reader->read_request_indices);
+                return can_read(lane->read_request_indices);
             });
         } else {
-            auto rp = reader->read_request_indices.read_pos.load();
+            auto rp = lane->read_request_indices.read_pos.load();
             auto req_index = to_request_index(rp);
-            
-            async_read_request_t req = reader->read_requests[req_index];
-            reader->read_request_indices.read_pos++;
+
+            async_read_request_t req = lane->read_requests[req_index];
+            auto queued_time = lane->queued_times[req_index];
+            lane->read_request_indices.read_pos++;
 
             // todo: ? sync with start_async_reading ?
-            auto file = reader->opened_files[req.file - 1].file;
+            auto& file_data = reader->opened_files[req.file - 1];
 
-            if (ENABLE_DEBUG_READ_DELAY) {
-                std::this_thread::sleep_for(DEBUG_READ_DELAY);
-            }
-            
-            ma_vfs_seek(reader->vfs, file, req.offset, ma_seek_origin_start);
             size_t read_bytes = {};
-            ma_vfs_read(reader->vfs, file, req.out_buffer.data, req.out_buffer.size, &read_bytes);
+            {
+                HLEA_TRACE_SCOPE("file read");
+                ma_vfs_seek(reader->vfs, file_data.file, (ma_int64)(file_data.base_offset + req.offset), ma_seek_origin_start);
+                // short reads are continued, stopped on the end of file or error
+                while (read_bytes < req.out_buffer.size) {
+                    size_t chunk_read_bytes = {};
+                    ma_vfs_read(reader->vfs, file_data.file, req.out_buffer.data + read_bytes, req.out_buffer.size - read_bytes, &chunk_read_bytes);
+                    if (!chunk_read_bytes) break;
+                    read_bytes += chunk_read_bytes;
+                }
+            }
+            HLEA_TRACE_INSTANT("read bytes", read_bytes);
+
+            if (auto counters = reader->counters) {
+                auto latency = std::chrono::steady_clock::now() - queued_time;
+                count_read_latency(counters, std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+                count(counters->bytes_read, read_bytes);
+                count(counters->reads_completed);
+            }
 
-            reader->read_pos_processed = reader->read_request_indices.read_pos.load();
+            lane->read_pos_processed = lane->read_request_indices.read_pos.load();
         }
     }
 }
@@ -108,22 +147,42 @@ async_file_reader_t* create_async_file_reader(const async_file_reader_create_inf
     res = new(res) async_file_reader_t();
     res->allocator = info.allocator;
     res->vfs = info.vfs;
+    res->counters = info.counters;
 
-    res->reading_thread = std::thread(process_async_reader, res);
+    res->lane_count = info.lane_count ? info.lane_count : 1;
+    if (MAX_READ_LANES < res->lane_count) res->lane_count = MAX_READ_LANES;
+
+    for (uint8_t i = 0; i < res->lane_count; ++i) {
+        res->lanes[i].reading_thread = std::thread(process_async_reader, res, &res->lanes[i]);
+    }
 
     return res;
 }
 
 void destroy(async_file_reader_t* reader) {
     reader->stopped = true;
-    reader->request_signal.notify_one();
-    reader->reading_thread.join();
+    for (uint8_t i = 0; i < reader->lane_count; ++i) {
+        auto& lane = reader->lanes[i];
+        {
+            // avoid lost wakeup between predicate check and wait
+            std::unique_lock<std::mutex> lk(lane.request_write_mutex);
+        }
+        lane.request_signal.notify_one();
+        lane.reading_thread.join();
+    }
 
     reader->~async_file_reader_t();
     deallocate(reader->allocator, reader);
 }
 
-async_file_handle_t start_async_reading(async_file_reader_t* reader, ma_vfs_file f) {
+static bool is_opened(const async_file_reader_t* reader, uint32_t file_index) {
+    for (size_t i = 0; i < reader->opened_files_freed_count; ++i) {
+        if (reader->opened_files_freed[i] == file_index + 1) return false;
+    }
+    return true;
+}
+
+async_file_handle_t start_async_reading(async_file_reader_t* reader, ma_vfs_file f, uint8_t lane, uint64_t base_offset) {
     static std::thread::id this_id = std::this_thread::get_id();
     assert(this_id == std::this_thread::get_id() && "opened_file_count is not atomic");
 
@@ -139,59 +198,82 @@ async_file_handle_t start_async_reading(async_file_reader_t* reader, ma_vfs_file
 
     async_file_data_t fdata = {};
     fdata.file = f;
+    fdata.base_offset = base_offset;
+    fdata.lane = lane % reader->lane_count;
+
+    // keep reads of a shared handle (regions of a single archive) serialized in one lane
+    for (uint32_t i = 0; i < reader->opened_file_count; ++i) {
+        if (i != file_index && reader->opened_files[i].file == f && is_opened(reader, i)) {
+            fdata.lane = reader->opened_files[i].lane;
+            break;
+        }
+    }
+
     reader->opened_files[file_index] = fdata;
 
     return async_file_handle_t(file_index + 1);
 }
 
 void stop_async_reading(async_file_reader_t* reader, async_file_handle_t afile) {
-    // respect queued read requests, wait for all pending reads (too strict now - wait for reads even from other files)
+    // respect queued read requests, wait for all pending reads of the file lane
+    // (too strict now - wait for reads even from other files of the lane)
     // todo: consider non-blocking solution, waiting read per file
-    auto wp = async_read_token_t(reader->read_request_indices.write_pos.load());
-    while (check_request_running(reader, wp)) {
+    auto lane_index = reader->opened_files[afile - 1].lane;
+    auto wp = reader->lanes[lane_index].read_request_indices.write_pos.load();
+    auto token = make_token(lane_index, wp);
+    while (check_request_running(reader, token)) {
         std::this_thread::sleep_for(REQUESTS_WAIT_TIME);
     }
-    
+
     reader->opened_files_freed[reader->opened_files_freed_count++] = afile;
 }
 
 async_read_token_t request_read(async_file_reader_t* reader, const async_read_request_t& request) {
-    
+    HLEA_TRACE_INSTANT("read queued", request.out_buffer.size);
+
     async_read_token_t res = {};
 
+    auto lane_index = reader->opened_files[request.file - 1].lane;
+    auto& lane = reader->lanes[lane_index];
+
     // extra loop to sleep outside locking request_write_mutex
     while (true) {
-        while (!can_write(reader->read_request_indices, MAX_READ_REQUESTS)) {
+        while (!can_write(lane.read_request_indices, MAX_READ_REQUESTS)) {
             // read_requests is full, wait
             std::this_thread::sleep_for(REQUESTS_WAIT_TIME);
             // consider non-blocking solution: return invalid handle or fail code
         }
 
         // lock for potential requests from multiple threads
-        std::unique_lock<std::mutex> lk(reader->request_write_mutex);
+        std::unique_lock<std::mutex> lk(lane.request_write_mutex);
 
-        if (!can_write(reader->read_request_indices, MAX_READ_REQUESTS)) continue;
+        if (!can_write(lane.read_request_indices, MAX_READ_REQUESTS)) continue;
 
-        auto wp = reader->read_request_indices.write_pos.load();
-        reader->read_requests[to_request_index(wp)] = request;
+        auto wp = lane.read_request_indices.write_pos.load();
+        lane.read_requests[to_request_index(wp)] = request;
+        if (reader->counters) lane.queued_times[to_request_index(wp)] = std::chrono::steady_clock::now();
         ++wp;
-        reader->read_request_indices.write_pos.store(wp);
+        lane.read_request_indices.write_pos.store(wp);
 
-        res = async_read_token_t(wp);
+        res = make_token(lane_index, wp);
 
         break;
     }
 
-    reader->request_signal.notify_one();
+    lane.request_signal.notify_one();
+
+    if (reader->counters) count(reader->counters->reads_queued);
 
     return res;
 }
 
 // thread-safe
 bool check_request_running(const async_file_reader_t* reader, async_read_token_t token) {
-    auto last_req = reader->read_request_indices.write_pos.load();
-    uint32_t tok_dist = last_req - uint32_t(token);
-    uint32_t queued_dist = last_req - reader->read_pos_processed;
+    auto& lane = reader->lanes[uint32_t(token) >> TOKEN_POS_BITS];
+
+    auto last_req = lane.read_request_indices.write_pos.load();
+    uint32_t tok_dist = (last_req - uint32_t(token)) & TOKEN_POS_MASK;
+    uint32_t queued_dist = (last_req - lane.read_pos_processed) & TOKEN_POS_MASK;
 
     return tok_dist < queued_dist;
 }
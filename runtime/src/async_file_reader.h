@@ -4,6 +4,7 @@
 #include "internal_alloc_types.h"
 #include "hlea/file_types.h"
 #include "rt_types.h"
+#include "runtime_stats.h"
 
 // forward declare ma_vfs types
 typedef void* ma_handle;
@@ -16,9 +17,16 @@ namespace rt {
 enum async_file_handle_t : uint32_t;
 const async_file_handle_t invalid_async_file_handle = {};
 
+static const uint8_t MAX_READ_LANES = 8;
+
 struct async_file_reader_create_info_t {
     allocator_t allocator;
     ma_vfs* vfs;
+
+    // each lane is a reading thread with its own requests queue (0 is treated as 1)
+    uint8_t lane_count;
+
+    runtime_counters_t* counters; // optional
 };
 
 struct async_file_reader_t;
@@ -26,14 +34,19 @@ struct async_file_reader_t;
 async_file_reader_t* create_async_file_reader(const async_file_reader_create_info_t& info);
 void destroy(async_file_reader_t* reader);
 
-async_file_handle_t start_async_reading(async_file_reader_t* reader, ma_vfs_file f);
+/**
+ * @param lane reading lane hint, files on different devices should use different lanes to be read in parallel
+ *  (the same file handle is always read from a single lane as seek + read is not thread-safe)
+ * @param base_offset added to every request offset, e.g. data embedded into an archive file
+ */
+async_file_handle_t start_async_reading(async_file_reader_t* reader, ma_vfs_file f, uint8_t lane = 0, uint64_t base_offset = 0);
 void stop_async_reading(async_file_reader_t* reader, async_file_handle_t afile);
 
 enum async_read_token_t : uint32_t;
 
 struct async_read_request_t {
     async_file_handle_t file;
-    uint32_t offset;
+    uint64_t offset;
     data_buffer_t out_buffer;
 };
 
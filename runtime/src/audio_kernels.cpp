@@ -0,0 +1,148 @@
+#include "audio_kernels.h"
+#include "audio_kernels_simd.inl"
+
+#if !defined(HLEA_NO_SIMD_KERNELS)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HLEA_SSE2_KERNELS
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define HLEA_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+#endif
+
+namespace hle_audio {
+namespace rt {
+
+// audio_kernels_avx2.cpp, compiled with avx2 enabled (nullptr otherwise)
+const audio_kernels_ti* get_avx2_audio_kernels();
+
+static audio_kernels_ti make_scalar_kernels() {
+    audio_kernels_ti res = {};
+    res.apply_gain_ramp = apply_gain_ramp_scalar;
+    res.apply_gain_envelope = apply_gain_envelope_scalar;
+    res.convert_s16_to_f32 = convert_s16_to_f32_scalar;
+    res.mix_f32 = mix_f32_scalar;
+    res.isa_name = "scalar";
+    return res;
+}
+
+#if defined(HLEA_SSE2_KERNELS)
+
+struct sse2_isa {
+    typedef __m128 vec;
+    static const uint32_t width = 4;
+
+    static vec load(const float* ptr) { return _mm_loadu_ps(ptr); }
+    static void store(float* ptr, vec v) { _mm_storeu_ps(ptr, v); }
+    static vec set1(float v) { return _mm_set1_ps(v); }
+    static vec add(vec a, vec b) { return _mm_add_ps(a, b); }
+    static vec mul(vec a, vec b) { return _mm_mul_ps(a, b); }
+
+    static vec frame_lanes(uint32_t channels) {
+        return channels == 1 ? _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f) : _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+    }
+
+    static vec load_frame_gains(const float* gains, uint32_t channels) {
+        if (channels == 1) return _mm_loadu_ps(gains);
+
+        return _mm_setr_ps(gains[0], gains[0], gains[1], gains[1]);
+    }
+
+    static void convert_s16_x8(float* dst, const int16_t* src) {
+        auto s16 = _mm_loadu_si128((const __m128i*)src);
+
+        // sign extend to 32 bits
+        auto lo = _mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16);
+        auto hi = _mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16);
+
+        const auto scale = _mm_set1_ps(S16_TO_F32_SCALE);
+        _mm_storeu_ps(dst, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+};
+
+static bool cpu_supports_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4] = {};
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return false;
+
+    // avx state is enabled by os
+    __cpuid(regs, 1);
+    const int osxsave_avx_bits = (1 << 27) | (1 << 28);
+    if ((regs[2] & osxsave_avx_bits) != osxsave_avx_bits) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#elif defined(HLEA_NEON_KERNELS)
+
+struct neon_isa {
+    typedef float32x4_t vec;
+    static const uint32_t width = 4;
+
+    static vec load(const float* ptr) { return vld1q_f32(ptr); }
+    static void store(float* ptr, vec v) { vst1q_f32(ptr, v); }
+    static vec set1(float v) { return vdupq_n_f32(v); }
+    static vec add(vec a, vec b) { return vaddq_f32(a, b); }
+    static vec mul(vec a, vec b) { return vmulq_f32(a, b); }
+
+    static vec frame_lanes(uint32_t channels) {
+        static const float mono_lanes[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+        static const float stereo_lanes[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+        return vld1q_f32(channels == 1 ? mono_lanes : stereo_lanes);
+    }
+
+    static vec load_frame_gains(const float* gains, uint32_t channels) {
+        if (channels == 1) return vld1q_f32(gains);
+
+        auto g = vld1_f32(gains);
+        auto zipped = vzip_f32(g, g);
+        return vcombine_f32(zipped.val[0], zipped.val[1]);
+    }
+
+    static void convert_s16_x8(float* dst, const int16_t* src) {
+        auto s16 = vld1q_s16(src);
+
+        auto lo = vmovl_s16(vget_low_s16(s16));
+        auto hi = vmovl_s16(vget_high_s16(s16));
+
+        vst1q_f32(dst, vmulq_n_f32(vcvtq_f32_s32(lo), S16_TO_F32_SCALE));
+        vst1q_f32(dst + 4, vmulq_n_f32(vcvtq_f32_s32(hi), S16_TO_F32_SCALE));
+    }
+};
+
+#endif
+
+static audio_kernels_ti select_kernels() {
+    auto res = make_scalar_kernels();
+
+#if defined(HLEA_SSE2_KERNELS)
+    res = make_simd_kernels<sse2_isa>("sse2");
+
+    auto avx2_kernels = get_avx2_audio_kernels();
+    if (avx2_kernels && cpu_supports_avx2()) res = *avx2_kernels;
+#elif defined(HLEA_NEON_KERNELS)
+    res = make_simd_kernels<neon_isa>("neon");
+#endif
+
+    return res;
+}
+
+const audio_kernels_ti& get_audio_kernels() {
+    static const audio_kernels_ti kernels = select_kernels();
+    return kernels;
+}
+
+}
+}
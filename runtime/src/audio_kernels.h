@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace hle_audio {
+namespace rt {
+
+/**
+ * @brief sample processing kernels, SSE2/AVX2/NEON variant is selected once by cpu features,
+ *  scalar fallback otherwise (or if built with HLEA_NO_SIMD_KERNELS).
+ *  Frames are interleaved f32, no alignment requirements
+ */
+struct audio_kernels_ti {
+    void (*apply_gain_ramp)(float* frames, uint32_t frame_count, uint32_t channels, float gain, float gain_step);
+    void (*apply_gain_envelope)(float* frames, uint32_t frame_count, uint32_t channels, const float* gains);
+    void (*convert_s16_to_f32)(float* dst, const int16_t* src, size_t sample_count);
+    void (*mix_f32)(float* dst, const float* src, size_t sample_count, float gain);
+
+    const char* isa_name;
+};
+
+const audio_kernels_ti& get_audio_kernels();
+
+/**
+ * @brief frame i gain is gain + i * gain_step
+ */
+static void apply_gain_ramp(float* frames, uint32_t frame_count, uint32_t channels, float gain, float gain_step) {
+    get_audio_kernels().apply_gain_ramp(frames, frame_count, channels, gain, gain_step);
+}
+
+/**
+ * @brief per frame gains (frame_count size), e.g. sampled fade curve
+ */
+static void apply_gain_envelope(float* frames, uint32_t frame_count, uint32_t channels, const float* gains) {
+    get_audio_kernels().apply_gain_envelope(frames, frame_count, channels, gains);
+}
+
+static void convert_s16_to_f32(float* dst, const int16_t* src, size_t sample_count) {
+    get_audio_kernels().convert_s16_to_f32(dst, src, sample_count);
+}
+
+/**
+ * @brief dst += src * gain
+ */
+static void mix_f32(float* dst, const float* src, size_t sample_count, float gain) {
+    get_audio_kernels().mix_f32(dst, src, sample_count, gain);
+}
+
+}
+}
@@ -0,0 +1,66 @@
+/**
+ * avx2 variant of audio kernels, the only file compiled with avx2 enabled (see runtime/CMakeLists.txt),
+ * so it is expected to be used after cpu check only
+ */
+#include "audio_kernels.h"
+
+#if defined(__AVX2__) && !defined(HLEA_NO_SIMD_KERNELS)
+
+#include "audio_kernels_simd.inl"
+#include <immintrin.h>
+
+namespace hle_audio {
+namespace rt {
+
+struct avx2_isa {
+    typedef __m256 vec;
+    static const uint32_t width = 8;
+
+    static vec load(const float* ptr) { return _mm256_loadu_ps(ptr); }
+    static void store(float* ptr, vec v) { _mm256_storeu_ps(ptr, v); }
+    static vec set1(float v) { return _mm256_set1_ps(v); }
+    static vec add(vec a, vec b) { return _mm256_add_ps(a, b); }
+    static vec mul(vec a, vec b) { return _mm256_mul_ps(a, b); }
+
+    static vec frame_lanes(uint32_t channels) {
+        return channels == 1 ?
+            _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f) :
+            _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f);
+    }
+
+    static vec load_frame_gains(const float* gains, uint32_t channels) {
+        if (channels == 1) return _mm256_loadu_ps(gains);
+
+        auto g = _mm_loadu_ps(gains);
+        auto lo = _mm_unpacklo_ps(g, g);
+        auto hi = _mm_unpackhi_ps(g, g);
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+    }
+
+    static void convert_s16_x8(float* dst, const int16_t* src) {
+        auto s32 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)src));
+        _mm256_storeu_ps(dst, _mm256_mul_ps(_mm256_cvtepi32_ps(s32), _mm256_set1_ps(S16_TO_F32_SCALE)));
+    }
+};
+
+const audio_kernels_ti* get_avx2_audio_kernels() {
+    static const audio_kernels_ti kernels = make_simd_kernels<avx2_isa>("avx2");
+    return &kernels;
+}
+
+}
+}
+
+#else
+
+namespace hle_audio {
+namespace rt {
+
+const audio_kernels_ti* get_avx2_audio_kernels() {
+    return nullptr;
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "audio_kernels.h"
+
+namespace hle_audio {
+namespace rt {
+
+/**
+ * kernels shared by simd variants, parametrized by isa traits:
+ *  vec, width (floats per vec), load/store/set1/add/mul,
+ *  frame_lanes(channels) - frame index offset of each lane,
+ *  load_frame_gains(gains, channels) - gain of each lane for width / channels frames,
+ *  convert_s16_x8(dst, src) - 8 samples conversion
+ */
+
+static const float S16_TO_F32_SCALE = 1.0f / 32768.0f;
+
+static void apply_gain_ramp_scalar(float* frames, uint32_t frame_count, uint32_t channels, float gain, float gain_step) {
+    for (uint32_t i = 0; i < frame_count; ++i) {
+        float frame_gain = gain + gain_step * float(i);
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            frames[i * channels + ch] *= frame_gain;
+        }
+    }
+}
+
+static void apply_gain_envelope_scalar(float* frames, uint32_t frame_count, uint32_t channels, const float* gains) {
+    for (uint32_t i = 0; i < frame_count; ++i) {
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            frames[i * channels + ch] *= gains[i];
+        }
+    }
+}
+
+static void convert_s16_to_f32_scalar(float* dst, const int16_t* src, size_t sample_count) {
+    for (size_t i = 0; i < sample_count; ++i) {
+        dst[i] = src[i] * S16_TO_F32_SCALE;
+    }
+}
+
+static void mix_f32_scalar(float* dst, const float* src, size_t sample_count, float gain) {
+    for (size_t i = 0; i < sample_count; ++i) {
+        dst[i] += src[i] * gain;
+    }
+}
+
+// mono and stereo frames fit simd lanes evenly, the rest is scalar
+static bool is_simd_layout(uint32_t channels) {
+    return channels == 1 || channels == 2;
+}
+
+template<typename isa>
+static void apply_gain_ramp_simd(float* frames, uint32_t frame_count, uint32_t channels, float gain, float gain_step) {
+    uint32_t i = 0;
+    if (is_simd_layout(channels)) {
+        const uint32_t frames_per_vec = isa::width / channels;
+
+        const auto lanes = isa::frame_lanes(channels);
+        const auto base = isa::set1(gain);
+        const auto step = isa::set1(gain_step);
+        for (; i + frames_per_vec <= frame_count; i += frames_per_vec) {
+            auto frame_gain = isa::add(base, isa::mul(isa::add(isa::set1(float(i)), lanes), step));
+
+            float* ptr = frames + i * channels;
+            isa::store(ptr, isa::mul(isa::load(ptr), frame_gain));
+        }
+    }
+
+    apply_gain_ramp_scalar(frames + i * channels, frame_count - i, channels, gain + gain_step * float(i), gain_step);
+}
+
+template<typename isa>
+static void apply_gain_envelope_simd(float* frames, uint32_t frame_count, uint32_t channels, const float* gains) {
+    uint32_t i = 0;
+    if (is_simd_layout(channels)) {
+        const uint32_t frames_per_vec = isa::width / channels;
+
+        for (; i + frames_per_vec <= frame_count; i += frames_per_vec) {
+            float* ptr = frames + i * channels;
+            isa::store(ptr, isa::mul(isa::load(ptr), isa::load_frame_gains(gains + i, channels)));
+        }
+    }
+
+    apply_gain_envelope_scalar(frames + i * channels, frame_count - i, channels, gains + i);
+}
+
+template<typename isa>
+static void convert_s16_to_f32_simd(float* dst, const int16_t* src, size_t sample_count) {
+    size_t i = 0;
+    for (; i + 8 <= sample_count; i += 8) {
+        isa::convert_s16_x8(dst + i, src + i);
+    }
+
+    convert_s16_to_f32_scalar(dst + i, src + i, sample_count - i);
+}
+
+template<typename isa>
+static void mix_f32_simd(float* dst, const float* src, size_t sample_count, float gain) {
+    const auto g = isa::set1(gain);
+
+    size_t i = 0;
+    for (; i + isa::width <= sample_count; i += isa::width) {
+        isa::store(dst + i, isa::add(isa::load(dst + i), isa::mul(isa::load(src + i), g)));
+    }
+
+    mix_f32_scalar(dst + i, src + i, sample_count - i, gain);
+}
+
+template<typename isa>
+static audio_kernels_ti make_simd_kernels(const char* isa_name) {
+    audio_kernels_ti res = {};
+    res.apply_gain_ramp = apply_gain_ramp_simd<isa>;
+    res.apply_gain_envelope = apply_gain_envelope_simd<isa>;
+    res.convert_s16_to_f32 = convert_s16_to_f32_simd<isa>;
+    res.mix_f32 = mix_f32_simd<isa>;
+    res.isa_name = isa_name;
+    return res;
+}
+
+}
+}
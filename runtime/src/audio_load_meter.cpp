@@ -0,0 +1,75 @@
+#include "audio_load_meter.h"
+
+#include <cmath>
+
+namespace hle_audio {
+namespace rt {
+
+static void reset(audio_load_meter_t* meter) {
+    const auto relaxed = std::memory_order_relaxed;
+
+    meter->callback_count.store(0, relaxed);
+    meter->overrun_count.store(0, relaxed);
+    meter->busy_ns.store(0, relaxed);
+    meter->period_ns.store(0, relaxed);
+    meter->min_load.store(0.0f, relaxed);
+    meter->max_load.store(0.0f, relaxed);
+    for (auto& bucket : meter->load_buckets) bucket.store(0, relaxed);
+    for (auto& cost : meter->cost_ns) cost.store(0, relaxed);
+}
+
+void record_callback(audio_load_meter_t* meter, uint64_t busy_ns, uint64_t period_ns) {
+    const auto relaxed = std::memory_order_relaxed;
+
+    if (meter->reset_requested.load(relaxed)) {
+        meter->reset_requested.store(false, relaxed);
+        reset(meter);
+    }
+    if (!period_ns) return;
+
+    float load = float(busy_ns) / float(period_ns);
+
+    // single writer, so no read-modify-write loops
+    auto count = meter->callback_count.load(relaxed);
+    if (!count || load < meter->min_load.load(relaxed)) meter->min_load.store(load, relaxed);
+    if (meter->max_load.load(relaxed) < load) meter->max_load.store(load, relaxed);
+
+    auto bucket = uint32_t(load * 100.0f);
+    if (AUDIO_LOAD_BUCKETS <= bucket) bucket = AUDIO_LOAD_BUCKETS - 1;
+    meter->load_buckets[bucket].fetch_add(1, relaxed);
+
+    if (period_ns < busy_ns) meter->overrun_count.fetch_add(1, relaxed);
+    meter->busy_ns.fetch_add(busy_ns, relaxed);
+    meter->period_ns.fetch_add(period_ns, relaxed);
+    meter->callback_count.store(count + 1, relaxed);
+}
+
+void request_reset(audio_load_meter_t* meter) {
+    meter->reset_requested.store(true, std::memory_order_relaxed);
+}
+
+float load_percentile(const audio_load_meter_t* meter, float percentile) {
+    uint32_t buckets[AUDIO_LOAD_BUCKETS];
+    uint64_t total = 0;
+    for (uint16_t i = 0; i < AUDIO_LOAD_BUCKETS; ++i) {
+        buckets[i] = meter->load_buckets[i].load(std::memory_order_relaxed);
+        total += buckets[i];
+    }
+    if (!total) return 0.0f;
+
+    // nearest rank
+    auto rank = uint64_t(std::ceil(percentile * float(total)));
+    if (rank < 1) rank = 1;
+
+    uint64_t accumulated = 0;
+    uint16_t bucket = 0;
+    for (; bucket < AUDIO_LOAD_BUCKETS - 1; ++bucket) {
+        accumulated += buckets[bucket];
+        if (rank <= accumulated) break;
+    }
+
+    return float(bucket + 1) / 100.0f;
+}
+
+}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+
+namespace hle_audio {
+namespace rt {
+
+// 1% steps of period, the last one takes 200% and more
+static const uint16_t AUDIO_LOAD_BUCKETS = 201;
+
+enum audio_cost_e : uint8_t {
+    AUDIO_COST_STREAMING_SOURCE_READ,
+    AUDIO_COST_BUFFER_SOURCE_READ,
+    AUDIO_COST_FADE_NODE,
+    AUDIO_COST_COUNT
+};
+
+/**
+ * @brief wall time of audio callbacks relative to their period, written by audio thread only.
+ *  Load of 1.0 is the whole period, above it the device is starved (overrun)
+ */
+struct audio_load_meter_t {
+    // nodes and data sources are timed too, a couple of clock reads per call
+    bool measure_costs;
+
+    // cleared by audio thread on the next callback
+    std::atomic<bool> reset_requested;
+
+    std::atomic<uint64_t> callback_count;
+    std::atomic<uint64_t> overrun_count;
+    std::atomic<uint64_t> busy_ns;
+    std::atomic<uint64_t> period_ns;
+    std::atomic<float> min_load;
+    std::atomic<float> max_load;
+    std::atomic<uint32_t> load_buckets[AUDIO_LOAD_BUCKETS];
+
+    std::atomic<uint64_t> cost_ns[AUDIO_COST_COUNT];
+};
+
+void record_callback(audio_load_meter_t* meter, uint64_t busy_ns, uint64_t period_ns);
+void request_reset(audio_load_meter_t* meter);
+
+// upper bound of 1% bucket the percentile falls into
+float load_percentile(const audio_load_meter_t* meter, float percentile);
+
+/**
+ * @brief adds scope time to cost category, if meter measures costs
+ */
+struct audio_cost_scope_t {
+    audio_load_meter_t* meter;
+    audio_cost_e cost;
+    std::chrono::steady_clock::time_point start;
+
+    audio_cost_scope_t(audio_load_meter_t* in_meter, audio_cost_e in_cost) :
+            meter(in_meter && in_meter->measure_costs ? in_meter : nullptr), cost(in_cost) {
+        if (meter) start = std::chrono::steady_clock::now();
+    }
+
+    ~audio_cost_scope_t() {
+        if (!meter) return;
+
+        auto time = std::chrono::steady_clock::now() - start;
+        auto time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+        meter->cost_ns[cost].fetch_add(uint64_t(time_ns), std::memory_order_relaxed);
+    }
+
+    audio_cost_scope_t(const audio_cost_scope_t&) = delete;
+    audio_cost_scope_t& operator=(const audio_cost_scope_t&) = delete;
+};
+
+}
+}
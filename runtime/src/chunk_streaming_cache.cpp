@@ -7,8 +7,8 @@
 #include "hash_indices.inl"
 #include "hash_utils.inl"
 #include "index_list.inl"
+#include "trace.h"
 
-static const size_t READ_CHUNK_SIZE = 64 * 1024; // 64KB
 static const size_t MAX_SOURCES_COUNT = 512;
 static const size_t MAX_POOL_CHUNKS = 32; // 2MB total
 
@@ -24,6 +24,7 @@ struct index_with_generation_t {
 struct chunk_streaming_cache_t {
     allocator_t allocator;
     async_file_reader_t* async_io;
+    runtime_counters_t* counters;
 
     std::mutex sync_mutex;
 
@@ -35,7 +36,7 @@ struct chunk_streaming_cache_t {
 
     struct chunk_t {
         streaming_source_handle src;
-        uint32_t src_offset;
+        uint64_t src_offset;
 
         uint32_t use_count;
         chunk_status_e status;
@@ -74,8 +75,9 @@ static index_with_generation_t unpack(streaming_source_handle h) {
     return index;
 }
 
-static uint32_t hash_src_pos(streaming_source_handle src, uint32_t src_offset) {
-    uint32_t res = hash_combine(distribute(src_offset), (uint32_t)src);
+static uint32_t hash_src_pos(streaming_source_handle src, uint64_t src_offset) {
+    uint32_t offset_hash = hash_combine(distribute(uint32_t(src_offset)), uint32_t(src_offset >> 32));
+    uint32_t res = hash_combine(offset_hash, (uint32_t)src);
     res += (res == 0) ? 1u : 0u; // zero hash is used as free slot marker
     return res;
 }
@@ -86,6 +88,7 @@ chunk_streaming_cache_t* create_cache(const chunk_streaming_cache_init_info_t& i
 
     cache->allocator = info.allocator;
     cache->async_io = info.async_io;
+    cache->counters = info.counters;
 
     memset(cache->sources, 0, sizeof(cache->sources));
     memset(cache->chunks, 0, sizeof(cache->chunks));
@@ -145,6 +148,7 @@ void deregister_source(chunk_streaming_cache_t* cache, streaming_source_handle s
 }
 
 chunk_request_result_t acquire_chunk(chunk_streaming_cache_t& cache, const chunk_request_t& request) {
+    HLEA_TRACE_SCOPE("acquire_chunk");
     std::unique_lock<std::mutex> lk(cache.sync_mutex);
 
     chunk_request_result_t res = {};
@@ -155,7 +159,7 @@ chunk_request_result_t acquire_chunk(chunk_streaming_cache_t& cache, const chunk
     auto rest_size = request.buffer_block.size - request.block_offset;
     auto buf_size = rest_size < READ_CHUNK_SIZE ? rest_size : READ_CHUNK_SIZE;
 
-    auto req_src_offset = request.buffer_block.offset + request.block_offset;
+    uint64_t req_src_offset = request.buffer_block.offset + request.block_offset;
 
     // try find chunk in cache
     auto req_key_hash = hash_src_pos(request.src, req_src_offset);
@@ -179,12 +183,18 @@ chunk_request_result_t acquire_chunk(chunk_streaming_cache_t& cache, const chunk
         res.index = ch_index;
         res.data = buffer;       
 
+        if (cache.counters) count(cache.counters->cache_hits);
         return res;
     }
 
     // no chunk in cache found, get unused one
     auto free_index = pop_front(&cache.free_chunks);
-    if (free_index == uint16_t(~0u)) return res;
+    if (free_index == uint16_t(~0u)) {
+        HLEA_TRACE_INSTANT("no free chunk", 0);
+        if (cache.counters) count(cache.counters->cache_no_free_chunk);
+        return res;
+    }
+    if (cache.counters) count(cache.counters->cache_misses);
 
     // erase chunk index as new chunk is being prepared
     auto& ch_ref = cache.chunks[free_index];
@@ -193,6 +203,7 @@ chunk_request_result_t acquire_chunk(chunk_streaming_cache_t& cache, const chunk
         auto key_hash = hash_src_pos(ch_ref.src, ch_ref.src_offset);
         
         hash::erase_with_index(&cache.chunk_indices, key_hash, free_index);
+        if (cache.counters) count(cache.counters->cache_evictions);
     }
 
     chunk_streaming_cache_t::chunk_t new_ch = {};
@@ -255,9 +266,24 @@ chunk_status_e chunk_status(chunk_streaming_cache_t& cache, uint32_t chunk_index
     return ch.status;
 }
 
+chunk_streaming_cache_stats_t get_stats(chunk_streaming_cache_t* cache) {
+    std::unique_lock<std::mutex> lk(cache->sync_mutex);
+
+    chunk_streaming_cache_stats_t res = {};
+    res.chunk_count = MAX_POOL_CHUNKS;
+
+    auto entries = cache->free_chunks.entries;
+    for (auto index = entries[HEAD_INDEX].next; index != HEAD_INDEX; index = entries[index].next) {
+        ++res.free_chunks;
+    }
+    return res;
+}
+
 void update_pending_reads(chunk_streaming_cache_t* cache) {
+    HLEA_TRACE_SCOPE("update_pending_reads");
     std::unique_lock<std::mutex> lk(cache->sync_mutex);
 
+    // reads from different lanes could finish out of order, so check every pending read
     uint32_t finished = 0;
     for (uint32_t i = 0; i < cache->pending_reads_count; ++i) {
         auto& read = cache->pending_reads[i];
@@ -265,11 +291,9 @@ void update_pending_reads(chunk_streaming_cache_t* cache) {
             cache->chunks[read.chunk_index].status = chunk_status_e::READY;
             release_chunk_no_lock(*cache, read.chunk_index);
             ++finished;
-        } else break;
-    }
-
-    for (uint32_t i = finished; i < cache->pending_reads_count; ++i) {
-        cache->pending_reads[i - finished] = cache->pending_reads[i];
+        } else if (finished) {
+            cache->pending_reads[i - finished] = read;
+        }
     }
     cache->pending_reads_count -= finished;
 }
@@ -14,9 +14,11 @@ struct chunk_streaming_cache_t;
 */ 
 enum streaming_source_handle : uint32_t;
 
+static const size_t READ_CHUNK_SIZE = 64 * 1024; // 64KB
+
 struct chunk_request_t {
     streaming_source_handle src;
-    range_t buffer_block;
+    stream_range_t buffer_block;
     uint32_t block_offset;
 };
 
@@ -33,6 +35,7 @@ struct chunk_request_result_t {
 struct chunk_streaming_cache_init_info_t {
     allocator_t allocator;
     async_file_reader_t* async_io;
+    runtime_counters_t* counters; // optional
 };
 
 chunk_streaming_cache_t* create_cache(const chunk_streaming_cache_init_info_t& info);
@@ -47,5 +50,11 @@ chunk_request_result_t acquire_chunk(chunk_streaming_cache_t& cache, const chunk
 void release_chunk(chunk_streaming_cache_t& cache, uint32_t chunk_index);
 chunk_status_e chunk_status(chunk_streaming_cache_t& cache, uint32_t chunk_index);
 
+struct chunk_streaming_cache_stats_t {
+    uint32_t free_chunks; // not used by decoders, could still hold cached data
+    uint32_t chunk_count;
+};
+chunk_streaming_cache_stats_t get_stats(chunk_streaming_cache_t* cache);
+
 }
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "miniaudio_public.h"
+#include "rt_types.h"
+#include "adpcm.h"
 
 namespace hle_audio {
 namespace rt {
@@ -20,5 +22,78 @@ static uint8_t get_sample_byte_size(ma_format format) {
     return 0;
 }
 
+/**
+ * @return the last seek point not after frame_index, file start if there is none
+ */
+static seek_point_t find_seek_point(audio_format_type_e coding_format, uint8_t channels,
+        const seek_point_t* points, uint32_t count, uint64_t frame_index) {
+    seek_point_t res = {};
+
+    // seek points are implicit for fixed size frames formats
+    switch (coding_format) {
+    case audio_format_type_e::pcm:
+        res.frame_index = uint32_t(frame_index);
+        res.byte_offset = uint32_t(frame_index * channels * sizeof(int16_t));
+        return res;
+    case audio_format_type_e::adpcm: {
+        auto block_index = frame_index / ADPCM_BLOCK_FRAMES;
+        res.frame_index = uint32_t(block_index * ADPCM_BLOCK_FRAMES);
+        res.byte_offset = uint32_t(block_index * adpcm_block_size(channels));
+        return res;
+    }
+    default:
+        break;
+    }
+
+    // binary search for the first point after frame_index
+    uint32_t first = 0;
+    while (0 < count) {
+        auto step = count / 2;
+        if (points[first + step].frame_index <= frame_index) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+
+    if (first) res = points[first - 1];
+    return res;
+}
+/**
+ * @return input byte offset not needed to decode frames before frame_index, 0 if unknown
+ */
+static uint32_t find_decode_end_offset(audio_format_type_e coding_format, uint8_t channels,
+        const seek_point_t* points, uint32_t count, uint64_t frame_index) {
+    switch (coding_format) {
+    case audio_format_type_e::pcm:
+        return uint32_t(frame_index * channels * sizeof(int16_t));
+    case audio_format_type_e::adpcm: {
+        auto block_count = (frame_index + ADPCM_BLOCK_FRAMES - 1) / ADPCM_BLOCK_FRAMES;
+        return uint32_t(block_count * adpcm_block_size(channels));
+    }
+    default:
+        break;
+    }
+
+    // binary search for the first point not before frame_index
+    uint32_t first = 0;
+    uint32_t rest_count = count;
+    while (0 < rest_count) {
+        auto step = rest_count / 2;
+        if (points[first + step].frame_index < frame_index) {
+            first += step + 1;
+            rest_count -= step + 1;
+        } else {
+            rest_count = step;
+        }
+    }
+
+    // seek points are further apart than decoder warm-up frames,
+    // so decoding from the next point starts past the frame with frame_index - 1
+    if (first + 1 < count) return points[first + 1].byte_offset;
+    return 0;
+}
+
 }
 }
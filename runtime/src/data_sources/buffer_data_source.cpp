@@ -3,70 +3,150 @@
 #include <cstring>
 #include <algorithm>
 #include "data_source_utils.inl"
+#include "audio_kernels.h"
+#include "trace.h"
 
 namespace hle_audio {
 namespace rt {
 
-static ma_result buffer_data_source_read(ma_data_source* data_source, void* frames_out, ma_uint64 frame_count, ma_uint64* frames_read) {
-    buffer_data_source_t* src = (buffer_data_source_t*)data_source;
-
-    uint8_t channels = src->meta.channels;
-    const auto sample_byte_size = get_sample_byte_size(src->format);
+/**
+ * @brief compile-time specialized frames reader, no decoder vtable dispatch for resident pcm
+ */
+template<typename decoder_type>
+struct buffer_reader;
 
-    // acquire ready output buffer
-    if (is_empty(src->read_buffer) || (src->read_buffer.size == src->read_bytes)) {
-        src->read_bytes = 0;
-        src->read_buffer = next_output(src->decoder, src->read_buffer);
+template<>
+struct buffer_reader<decoder_t> {
+    static void start(buffer_data_source_t* ds) {
+        queue_input(ds->decoder, ds->buffer, true);
     }
 
-    if (is_empty(src->read_buffer)) {
-        if (src->read_cursor == src->meta.length_in_samples) return MA_SUCCESS;
-        // still has something to read, but no buffer ready
-        else return MA_BUSY;
-    }
+    static ma_result read(buffer_data_source_t* src, void* frames_out, ma_uint64 frame_count, ma_uint64* frames_read) {
+        uint8_t channels = src->meta.channels;
+        const auto sample_byte_size = get_sample_byte_size(src->format);
+
+        // decoders could output trailing frames past the stream length (vorbis pushdata)
+        frame_count = std::min(frame_count, ma_uint64(src->meta.length_in_samples - src->read_cursor));
+        if (frame_count == 0) return MA_SUCCESS;
+
+        bool output_consumed = is_empty(src->read_buffer) || (src->read_buffer.size == src->read_bytes);
+
+        // decoded straight into frames_out, the output buffer is for seeking and decoders without decode_into
+        if (output_consumed && !src->skip_read_bytes && can_decode_into(src->decoder)) {
+            auto frames_decoded = decode_into(src->decoder, frames_out, frame_count);
+            if (frames_decoded) {
+                *frames_read = frames_decoded;
+                src->read_cursor += frames_decoded;
+
+                assert(src->read_cursor <= src->meta.length_in_samples);
+                return MA_SUCCESS;
+            }
+        }
+
+        // acquire ready output buffer
+        if (output_consumed) {
+            src->read_bytes = 0;
+            src->read_buffer = next_output(src->decoder, src->read_buffer);
+        }
+
+        if (is_empty(src->read_buffer)) {
+            if (src->read_cursor == src->meta.length_in_samples) return MA_SUCCESS;
+            // still has something to read, but no buffer ready
+            else return MA_BUSY;
+        }
+
+        if (0 < src->skip_read_bytes) {
+            auto skipped_read_bytes = std::min(src->skip_read_bytes, static_cast<uint64_t>(src->read_buffer.size));
+            src->read_bytes += skipped_read_bytes;
+            src->skip_read_bytes -= skipped_read_bytes;
+            if (src->read_buffer.size == src->read_bytes) return MA_BUSY;
+        }
+
+        uint64_t frames_in_bytes = frame_count * sample_byte_size * channels;
 
-    if (0 < src->skip_read_bytes) {
-        auto skipped_read_bytes = std::min(src->skip_read_bytes, static_cast<uint64_t>(src->read_buffer.size));
-        src->read_bytes += skipped_read_bytes;
-        src->skip_read_bytes -= skipped_read_bytes;
-        if (src->read_buffer.size == src->read_bytes) return MA_BUSY;
+        uint64_t bytes_consumed = std::min(src->read_buffer.size - src->read_bytes, frames_in_bytes);
+        memcpy(frames_out, (uint8_t*)src->read_buffer.data + src->read_bytes, size_t(bytes_consumed));
+        src->read_bytes += bytes_consumed;
+
+        // request next read buffer, decode_into one is requested with the next read
+        if (src->read_buffer.size == src->read_bytes && !can_decode_into(src->decoder)) {
+            src->read_bytes = 0;
+            src->read_buffer = next_output(src->decoder, src->read_buffer);
+        }
+
+        *frames_read = bytes_consumed / (sample_byte_size * channels);
+
+        src->read_cursor += *frames_read;
+
+        assert(src->read_cursor <= src->meta.length_in_samples);
+
+        return MA_SUCCESS;
     }
 
-    uint64_t frames_in_bytes = frame_count * sample_byte_size * channels;
+    static ma_result seek(buffer_data_source_t* ds, ma_uint64 frameIndex) {
+        uint8_t channels = ds->meta.channels;
+        const auto sample_byte_size = get_sample_byte_size(ds->format);
 
-    uint64_t bytes_consumed = std::min(src->read_buffer.size - src->read_bytes, frames_in_bytes);
-    memcpy(frames_out, (uint8_t*)src->read_buffer.data + src->read_bytes, size_t(bytes_consumed));
-    src->read_bytes += bytes_consumed;
+        // start decoding from the nearest seek point, file start if no seek table
+        auto point = find_seek_point(ds->meta.coding_format, channels, ds->seek_points, ds->seek_point_count, frameIndex);
 
-    // request next read buffer
-    if (src->read_buffer.size == src->read_bytes) {
-        src->read_bytes = 0;
-        src->read_buffer = next_output(src->decoder, src->read_buffer);
+        flush(ds->decoder);
+        queue_input(ds->decoder, advance(ds->buffer, point.byte_offset), true);
+        ds->read_buffer = {};
+        ds->read_bytes = 0;
+        ds->read_cursor = frameIndex;
+        ds->skip_read_bytes = (point.discard_frames + frameIndex - point.frame_index) * sample_byte_size * channels;
+
+        return MA_SUCCESS;
     }
+};
 
-    *frames_read = bytes_consumed / (sample_byte_size * channels);
+/**
+ * resident s16 pcm frames (bank data or decoded cache) are converted to f32 right into frames_out,
+ * so miniaudio has no format conversion pass
+ */
+template<>
+struct buffer_reader<direct_pcm_t> {
+    static void start(buffer_data_source_t* ds) {}
 
-    src->read_cursor += *frames_read;
+    static ma_result read(buffer_data_source_t* src, void* frames_out, ma_uint64 frame_count, ma_uint64* frames_read) {
+        const uint64_t channels = src->meta.channels;
 
-    assert(src->read_cursor <= src->meta.length_in_samples);
+        frame_count = std::min(frame_count, ma_uint64(src->meta.length_in_samples - src->read_cursor));
+        auto frames = (const int16_t*)src->buffer.data + src->read_cursor * channels;
+        convert_s16_to_f32((float*)frames_out, frames, size_t(frame_count * channels));
 
-    return MA_SUCCESS;
-}
+        *frames_read = frame_count;
+        src->read_cursor += frame_count;
 
-static ma_result buffer_data_source_seek(ma_data_source* data_source, ma_uint64 frameIndex) {
-    buffer_data_source_t* ds = (buffer_data_source_t*)data_source;
+        return MA_SUCCESS;
+    }
 
-    uint8_t channels = ds->meta.channels;
-    const auto sample_byte_size = get_sample_byte_size(ds->format);
+    static ma_result seek(buffer_data_source_t* ds, ma_uint64 frameIndex) {
+        if (ds->meta.length_in_samples < frameIndex) return MA_INVALID_ARGS;
 
-    flush(ds->decoder);
-    queue_input(ds->decoder, ds->buffer, true);
-    ds->read_buffer = {};
-    ds->read_bytes = 0;
-    ds->read_cursor = frameIndex;
-    ds->skip_read_bytes = frameIndex * sample_byte_size * channels;
-    
-    return MA_SUCCESS;
+        ds->read_cursor = frameIndex;
+        return MA_SUCCESS;
+    }
+};
+
+template<typename decoder_type>
+static ma_result buffer_data_source_read(ma_data_source* data_source, void* frames_out, ma_uint64 frame_count, ma_uint64* frames_read) {
+    auto ds = (buffer_data_source_t*)data_source;
+    HLEA_TRACE_SCOPE("buffer_data_source_read");
+    audio_cost_scope_t cost(ds->counters ? &ds->counters->audio_load : nullptr, AUDIO_COST_BUFFER_SOURCE_READ);
+
+    auto res = buffer_reader<decoder_type>::read(ds, frames_out, frame_count, frames_read);
+    if (res == MA_BUSY) {
+        if (ds->counters) count(ds->counters->underruns);
+        HLEA_TRACE_INSTANT("underrun", frame_count);
+    }
+    return res;
+}
+
+template<typename decoder_type>
+static ma_result buffer_data_source_seek(ma_data_source* data_source, ma_uint64 frameIndex) {
+    return buffer_reader<decoder_type>::seek((buffer_data_source_t*)data_source, frameIndex);
 }
 
 static ma_result buffer_data_source_get_data_format(
@@ -103,19 +183,24 @@ static ma_result buffer_data_source_get_length(ma_data_source* data_source, ma_u
     return MA_SUCCESS;
 }
 
-static ma_data_source_vtable g_buffer_data_source_vtable = {
-    buffer_data_source_read,
-    buffer_data_source_seek,
-    buffer_data_source_get_data_format,
-    buffer_data_source_get_cursor,
-    buffer_data_source_get_length
-};
+template<typename decoder_type>
+static ma_data_source_vtable* buffer_data_source_vtable() {
+    static ma_data_source_vtable vtable = {
+        buffer_data_source_read<decoder_type>,
+        buffer_data_source_seek<decoder_type>,
+        buffer_data_source_get_data_format,
+        buffer_data_source_get_cursor,
+        buffer_data_source_get_length
+    };
+    return &vtable;
+}
 
-ma_result buffer_data_source_init(buffer_data_source_t* data_source, const buffer_data_source_init_info_t& info) {
+template<typename decoder_type>
+static ma_result buffer_data_source_init(buffer_data_source_t* data_source, const buffer_data_source_init_info_t& info) {
     ma_data_source_config baseConfig;
 
     baseConfig = ma_data_source_config_init();
-    baseConfig.vtable = &g_buffer_data_source_vtable;
+    baseConfig.vtable = buffer_data_source_vtable<decoder_type>();
 
     *data_source = {};
     ma_result result = ma_data_source_init(&baseConfig, &data_source->base);
@@ -127,12 +212,24 @@ ma_result buffer_data_source_init(buffer_data_source_t* data_source, const buffe
     data_source->format = info.format;
     data_source->meta = info.meta;
     data_source->buffer = info.buffer;
+    data_source->seek_points = info.seek_points;
+    data_source->seek_point_count = info.seek_point_count;
+    data_source->counters = info.counters;
 
-    queue_input(data_source->decoder, data_source->buffer, true);
+    buffer_reader<decoder_type>::start(data_source);
 
     return MA_SUCCESS;
 }
 
+ma_result buffer_data_source_init(buffer_data_source_t* data_source, const buffer_data_source_init_info_t& info) {
+    if (is_direct_pcm(info.meta)) {
+        assert(info.format == ma_format_f32);
+        return buffer_data_source_init<direct_pcm_t>(data_source, info);
+    }
+
+    return buffer_data_source_init<decoder_t>(data_source, info);
+}
+
 void buffer_data_source_uninit(buffer_data_source_t* data_source) {
     assert(!is_running(data_source->decoder) && "decoder should have released its inputs");
 
@@ -3,10 +3,20 @@
 #include "miniaudio_public.h"
 #include "rt_types.h"
 #include "decoder.h"
+#include "runtime_stats.h"
 
 namespace hle_audio {
 namespace rt {
 
+/**
+ * @brief resident pcm is read without decoder (see buffer_reader<direct_pcm_t>)
+ */
+struct direct_pcm_t {};
+
+static bool is_direct_pcm(const file_data_t::meta_t& meta) {
+    return !meta.stream && meta.coding_format == audio_format_type_e::pcm;
+}
+
 struct buffer_data_source_t {
     ma_data_source_base base;
 
@@ -14,6 +24,8 @@ struct buffer_data_source_t {
     ma_format format;
     file_data_t::meta_t meta;
     data_buffer_t buffer;
+    const seek_point_t* seek_points;
+    uint32_t seek_point_count;
 
     ma_uint64 read_cursor;
 
@@ -22,14 +34,20 @@ struct buffer_data_source_t {
     uint64_t read_bytes;
 
     ma_uint64 skip_read_bytes;
+
+    runtime_counters_t* counters;
 };
 
 
 struct buffer_data_source_init_info_t {
-    decoder_t decoder;
+    decoder_t decoder; // not used for direct pcm
     ma_format format;
     file_data_t::meta_t meta;
     data_buffer_t buffer;
+    const seek_point_t* seek_points;
+    uint32_t seek_point_count;
+
+    runtime_counters_t* counters; // optional, underruns
 };
 
 ma_result buffer_data_source_init(buffer_data_source_t* ds, const buffer_data_source_init_info_t& info);
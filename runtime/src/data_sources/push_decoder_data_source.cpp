@@ -6,8 +6,22 @@
 namespace hle_audio {
 namespace rt {
 
+static const uint32_t INVALID_CHUNK_ID = ~0u;
+
 static bool prepare_next_chunk(push_decoder_data_source_t& src);
 
+static void start_input_segment(push_decoder_data_source_t& src, uint8_t segment_index) {
+    auto& segment = src.segments[segment_index];
+    assert(segment.block_offset < segment.block_end);
+
+    src.input_segment_index = segment_index;
+    src.input_segment_started = false;
+
+    // keep chunks aligned to share them with other sources of the same file
+    src.input_block_offset = segment.block_offset - segment.block_offset % READ_CHUNK_SIZE;
+    src.input_skip_bytes = segment.block_offset - src.input_block_offset;
+}
+
 void init(push_decoder_data_source_t& src, const push_decoder_data_source_init_info_t& iinfo) {
     src = {};
 
@@ -15,24 +29,38 @@ void init(push_decoder_data_source_t& src, const push_decoder_data_source_init_i
     src.input_src = iinfo.input_src;
     src.buffer_block = iinfo.buffer_block;
     src.decoder = iinfo.decoder;
+    src.pinned_chunk_id = INVALID_CHUNK_ID;
+
+    src.segments[0] = iinfo.first_segment;
+    src.segment_count = 1;
+    start_input_segment(src, 0);
 
     // prepare first chunk
     prepare_next_chunk(src);
 }
 
-void deinit(push_decoder_data_source_t& src) {
-    assert(!is_running(src.decoder) && "decoder should have released its inputs");
-
+static void release_inputs(push_decoder_data_source_t& src) {
     for (size_t i = 0; i < src.input_count; ++i) {
         release_chunk(*src.streaming_cache, src.inputs[i].chunk_id);
     }
     src.input_count = 0;
 }
 
+void deinit(push_decoder_data_source_t& src) {
+    assert(!is_running(src.decoder) && "decoder should have released its inputs");
+
+    release_inputs(src);
+
+    if (has_pinned_chunk(src)) {
+        release_chunk(*src.streaming_cache, src.pinned_chunk_id);
+        src.pinned_chunk_id = INVALID_CHUNK_ID;
+    }
+}
+
 /**
- * @brief 
- * 
- * @param src 
+ * @brief
+ *
+ * @param src
  * @return true if has more chunks
  * @return false when last is reached
  */
@@ -40,9 +68,12 @@ static bool prepare_next_chunk(push_decoder_data_source_t& src) {
     // got enough inputs already
     if (src.input_count == MAX_DS_INPUTS) return true;
 
-    // check if reached the last chunk
-    if (src.input_block_offset == src.buffer_block.size) {
-        return false;
+    // check if reached the last chunk of the segment
+    if (src.segments[src.input_segment_index].block_end <= src.input_block_offset) {
+        // next segment isn't planned (yet)
+        if (src.input_segment_index + 1 == src.segment_count) return false;
+
+        start_input_segment(src, src.input_segment_index + 1);
     }
 
     chunk_request_t req = {};
@@ -64,19 +95,138 @@ static bool prepare_next_chunk(push_decoder_data_source_t& src) {
     return true;
 }
 
+static void queue_chunk_buffer(push_decoder_data_source_t& src) {
+    auto& segment = src.segments[src.input_segment_index];
+
+    auto chunk_end = src.input_block_offset + src.chunk_buffer.size;
+    bool last_chunk = segment.block_end <= chunk_end;
+
+    auto input_buffer = src.chunk_buffer;
+    if (last_chunk) input_buffer.size -= chunk_end - segment.block_end;
+    input_buffer = advance(input_buffer, src.input_skip_bytes);
+
+    if (!src.input_segment_started) {
+        src.input_segment_started = true;
+        start_segment(src.decoder, segment.skip_frames, segment.frame_count);
+    }
+    queue_input(src.decoder, input_buffer, last_chunk);
+    src.input_skip_bytes = 0;
+
+    src.input_block_offset += uint32_t(src.chunk_buffer.size);
+    src.chunk_buffer = {};
+}
+
+void seek(push_decoder_data_source_t& src, const decode_segment_t& segment) {
+    flush(src.decoder);
+    src.read_buffer = {};
+    src.read_bytes = 0;
+
+    src.segments[0] = segment;
+    src.segment_count = 1;
+    src.input_segment_index = 0;
+    src.segment_read_frames = 0;
+
+    src.seek_pending = true;
+}
+
 /**
- * @brief 
- * 
- * @param src 
- * @param channels 
+ * @return false while decoder job could be still using input chunks
+ */
+static bool apply_pending_seek(push_decoder_data_source_t& src) {
+    if (!src.seek_pending) return true;
+
+    if (is_running(src.decoder)) return false;
+
+    release_inputs(src);
+    src.chunk_buffer = {};
+
+    start_input_segment(src, 0);
+    src.seek_pending = false;
+
+    prepare_next_chunk(src);
+
+    return true;
+}
+
+bool needs_next_segment(const push_decoder_data_source_t& src) {
+    return !src.seek_pending &&
+        src.input_segment_index + 1 == src.segment_count &&
+        src.segments[src.input_segment_index].block_end <= src.input_block_offset;
+}
+
+const decode_segment_t& last_segment(const push_decoder_data_source_t& src) {
+    assert(src.segment_count);
+    return src.segments[src.segment_count - 1];
+}
+
+void queue_segment(push_decoder_data_source_t& src, const decode_segment_t& segment) {
+    assert(src.segment_count < MAX_DS_SEGMENTS);
+    src.segments[src.segment_count++] = segment;
+}
+
+void pin_chunk(push_decoder_data_source_t& src, uint32_t block_offset) {
+    assert(!has_pinned_chunk(src));
+
+    chunk_request_t req = {};
+    req.src = src.input_src;
+    req.buffer_block = src.buffer_block;
+    req.block_offset = block_offset - block_offset % READ_CHUNK_SIZE;
+    src.pinned_chunk_id = acquire_chunk(*src.streaming_cache, req).index;
+}
+
+bool has_pinned_chunk(const push_decoder_data_source_t& src) {
+    return src.pinned_chunk_id != INVALID_CHUNK_ID;
+}
+
+uint64_t read_cursor(const push_decoder_data_source_t& src) {
+    return src.segments[0].first_frame + src.segment_read_frames;
+}
+
+/**
+ * @brief switch to the next segment when the current one is read completely
+ */
+static void update_read_segment(push_decoder_data_source_t& src) {
+    auto& segment = src.segments[0];
+    if (segment.frame_count == SEGMENT_UNLIMITED_FRAMES) return;
+    if (src.segment_read_frames < segment.frame_count) return;
+
+    // next segment outputs could exist only if it is being queued
+    if (src.input_segment_index == 0) return;
+
+    for (uint8_t i = 1; i < src.segment_count; ++i) {
+        src.segments[i - 1] = src.segments[i];
+    }
+    --src.segment_count;
+    --src.input_segment_index;
+    src.segment_read_frames = 0;
+}
+
+/**
+ * @brief decoder outputs frame_count of the segment at most, the rest is of the next segment
+ */
+static uint64_t segment_frames_left(const push_decoder_data_source_t& src, uint64_t frame_count) {
+    auto& segment = src.segments[0];
+    if (segment.frame_count != SEGMENT_UNLIMITED_FRAMES && src.segment_read_frames < segment.frame_count) {
+        frame_count = std::min(frame_count, segment.frame_count - src.segment_read_frames);
+    }
+    return frame_count;
+}
+
+/**
+ * @brief
+ *
+ * @param src
+ * @param channels
  * @param frame_out output frame array (frame_count size)
  * @param frame_count number of frames to read
  * @param frames_read out
  * @return true when read successfully (frames_read is 0 when source end is reached)
  * @return false if there is still some data to read, but no data ready (data starvation case)
  */
-bool read_decoded(push_decoder_data_source_t& src, uint8_t channels, uint8_t sample_byte_size, 
+bool read_decoded(push_decoder_data_source_t& src, uint8_t channels, uint8_t sample_byte_size,
         void* frame_out, uint64_t frame_count, uint64_t* frames_read) {
+    if (!apply_pending_seek(src)) return false;
+
     // deque ready output
     auto processed_inputs_count = release_consumed_inputs(src.decoder);
     if (processed_inputs_count) {
@@ -91,15 +241,11 @@ bool read_decoded(push_decoder_data_source_t& src, uint8_t channels, uint8_t sam
     }
 
     // finished reading file chunk
-    if (!is_empty(src.chunk_buffer) && 
-            src.input_count && 
+    if (!is_empty(src.chunk_buffer) &&
+            src.input_count &&
             chunk_status(*src.streaming_cache, src.inputs[src.input_count - 1].chunk_id) == chunk_status_e::READY) {
         // queue ready to decode buffer
-        bool last_chunk = src.input_block_offset + src.chunk_buffer.size == src.buffer_block.size;
-        queue_input(src.decoder, src.chunk_buffer, last_chunk);
-
-        src.input_block_offset += src.chunk_buffer.size;
-        src.chunk_buffer = {};
+        queue_chunk_buffer(src);
     }
 
     bool has_more_inputs = src.input_count > 0;
@@ -110,8 +256,22 @@ bool read_decoded(push_decoder_data_source_t& src, uint8_t channels, uint8_t sam
         has_more_inputs |= has_more_chunks;
     }
 
+    bool output_consumed = src.read_buffer.size == src.read_bytes;
+
+    // decoded straight into frame_out, the output buffer is for seeking and decoders without decode_into
+    if (output_consumed && can_decode_into(src.decoder)) {
+        update_read_segment(src);
+
+        auto frames_decoded = decode_into(src.decoder, frame_out, segment_frames_left(src, frame_count));
+        if (frames_decoded) {
+            *frames_read = frames_decoded;
+            src.segment_read_frames += frames_decoded;
+            return true;
+        }
+    }
+
     // acquire ready output buffer
-    if (src.read_buffer.size == src.read_bytes) {
+    if (output_consumed) {
         src.read_bytes = 0;
         src.read_buffer = next_output(src.decoder, src.read_buffer);
     }
@@ -121,19 +281,24 @@ bool read_decoded(push_decoder_data_source_t& src, uint8_t channels, uint8_t sam
         return false;
     }
 
-    uint64_t frames_in_bytes = frame_count * sample_byte_size * channels;
+    update_read_segment(src);
+
+    const uint64_t frame_size = sample_byte_size * channels;
+
+    uint64_t frames_in_bytes = segment_frames_left(src, frame_count) * frame_size;
 
     uint64_t bytes_consumed = std::min(src.read_buffer.size - src.read_bytes, frames_in_bytes);
     memcpy(frame_out, (uint8_t*)src.read_buffer.data + src.read_bytes, size_t(bytes_consumed));
     src.read_bytes += bytes_consumed;
 
-    // request next read buffer
-    if (src.read_buffer.size == src.read_bytes) {
+    // request next read buffer, decode_into one is requested with the next read
+    if (src.read_buffer.size == src.read_bytes && !can_decode_into(src.decoder)) {
         src.read_bytes = 0;
         src.read_buffer = next_output(src.decoder, src.read_buffer);
     }
 
-    *frames_read = bytes_consumed / (sample_byte_size * channels);
+    *frames_read = bytes_consumed / frame_size;
+    src.segment_read_frames += *frames_read;
 
     return true;
 }
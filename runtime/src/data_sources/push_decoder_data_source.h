@@ -12,13 +12,32 @@ struct input_chunk_t {
 };
 
 static const size_t MAX_DS_INPUTS = 2;//MAX_INPUT_BUFFERS;
+static const size_t MAX_DS_SEGMENTS = 4;
+
+/**
+ * @brief decoded part of the stream: block bytes [block_offset, block_end) are decoded,
+ *  skip_frames are dropped and frame_count frames are output at most (see decoder_ti::start_segment)
+ */
+struct decode_segment_t {
+    uint32_t block_offset;
+    uint32_t block_end;
+    uint64_t skip_frames;
+    uint64_t frame_count;
+    uint64_t first_frame; // stream frame index of the first output frame
+};
 
 struct push_decoder_data_source_t {
     chunk_streaming_cache_t* streaming_cache;
 
     decoder_t decoder;
     streaming_source_handle input_src;
-    range_t buffer_block;
+    stream_range_t buffer_block;
+
+    // segments: [0] is being read, [input_segment_index] is being queued to decoder, the rest are planned
+    decode_segment_t segments[MAX_DS_SEGMENTS];
+    uint8_t segment_count;
+    uint8_t input_segment_index;
+    bool input_segment_started;
 
     // inputs
     input_chunk_t inputs[MAX_DS_INPUTS];
@@ -26,24 +45,56 @@ struct push_decoder_data_source_t {
 
     // pending input
     uint32_t input_block_offset;
+    uint32_t input_skip_bytes; // of the first segment chunk
     data_buffer_t chunk_buffer;
     async_read_token_t read_token;
 
+    // chunk kept in cache to start the next segment without waiting for a read
+    uint32_t pinned_chunk_id;
+
     // outpus
     data_buffer_t read_buffer;
     uint64_t read_bytes;
+    uint64_t segment_read_frames; // of segments[0]
+
+    // seek
+    bool seek_pending;
 };
 
 struct push_decoder_data_source_init_info_t {
     chunk_streaming_cache_t* streaming_cache;
     streaming_source_handle input_src;
-    range_t buffer_block;
+    stream_range_t buffer_block;
     decoder_t decoder;
+    decode_segment_t first_segment;
 };
 
 void init(push_decoder_data_source_t& src, const push_decoder_data_source_init_info_t& iinfo);
 void deinit(push_decoder_data_source_t& src);
 
+/**
+ * @brief restarts decoding from the segment, planned segments are dropped
+ */
+void seek(push_decoder_data_source_t& src, const decode_segment_t& segment);
+
+/**
+ * @brief true when all planned segments are queued to decoder, so the next one could be planned
+ */
+bool needs_next_segment(const push_decoder_data_source_t& src);
+const decode_segment_t& last_segment(const push_decoder_data_source_t& src);
+void queue_segment(push_decoder_data_source_t& src, const decode_segment_t& segment);
+
+/**
+ * @brief keeps the chunk of block_offset in streaming cache till deinit
+ */
+void pin_chunk(push_decoder_data_source_t& src, uint32_t block_offset);
+bool has_pinned_chunk(const push_decoder_data_source_t& src);
+
+/**
+ * @return stream frame index of the next read frame
+ */
+uint64_t read_cursor(const push_decoder_data_source_t& src);
+
 bool read_decoded(push_decoder_data_source_t& src, uint8_t channels, uint8_t sample_byte_size,
         void* frame_out, uint64_t frame_count, uint64_t* frames_read);
 
@@ -1,31 +1,92 @@
 #include "streaming_data_source.h"
 
 #include "data_source_utils.inl"
+#include "trace.h"
 
 namespace hle_audio {
 namespace rt {
 
+/**
+ * @brief decoded segment from first_frame, limited by loop end to continue with the loop head gapless
+ */
+static decode_segment_t make_segment(const streaming_data_source_t* ds, uint64_t first_frame, bool till_loop_end) {
+    // start reading from the nearest seek point, file start if no seek table
+    auto point = find_seek_point(ds->coding_format, uint8_t(ds->channels), ds->seek_points, ds->seek_point_count, first_frame);
+
+    decode_segment_t res = {};
+    res.block_offset = point.byte_offset;
+    res.block_end = ds->block_size;
+    res.skip_frames = point.discard_frames + first_frame - point.frame_index;
+    res.first_frame = first_frame;
+    res.frame_count = SEGMENT_UNLIMITED_FRAMES;
+
+    if (till_loop_end) {
+        res.frame_count = ds->loop_end - first_frame;
+
+        auto end_offset = find_decode_end_offset(ds->coding_format, uint8_t(ds->channels), ds->seek_points, ds->seek_point_count, ds->loop_end);
+        if (res.block_offset < end_offset && end_offset < res.block_end) res.block_end = end_offset;
+    }
+
+    return res;
+}
+
+static bool is_looping(const streaming_data_source_t* ds) {
+    return ma_data_source_is_looping(&ds->base);
+}
+
+/**
+ * @brief plans what follows the loop end segment: the loop head again if looping, the rest of stream otherwise.
+ *  decided when the segment inputs are queued, so breaking the loop takes effect with some latency
+ */
+static void plan_next_segment(streaming_data_source_t* ds) {
+    auto& reader = ds->decoder_reader;
+    if (!needs_next_segment(reader)) return;
+
+    auto& last = last_segment(reader);
+    if (last.frame_count == SEGMENT_UNLIMITED_FRAMES || last.first_frame + last.frame_count != ds->loop_end) return;
+
+    if (is_looping(ds)) {
+        queue_segment(reader, make_segment(ds, ds->loop_start, true));
+    } else if (ds->loop_end < ds->length_in_samples) {
+        queue_segment(reader, make_segment(ds, ds->loop_end, false));
+    }
+}
+
 static ma_result streaming_data_source_read(ma_data_source* pDataSource, void* pFramesOut, ma_uint64 frameCount, ma_uint64* pFramesRead) {
     streaming_data_source_t* ds = (streaming_data_source_t*)pDataSource;
+    HLEA_TRACE_SCOPE("streaming_data_source_read");
+    audio_cost_scope_t cost(ds->counters ? &ds->counters->audio_load : nullptr, AUDIO_COST_STREAMING_SOURCE_READ);
+
+    // decoders could output trailing frames past the stream length (vorbis pushdata)
+    auto frames_left = ds->length_in_samples - read_cursor(ds->decoder_reader);
+    if (frames_left < frameCount) frameCount = frames_left;
+    if (frameCount == 0) return MA_AT_END;
+
+    if (is_looping(ds) && !has_pinned_chunk(ds->decoder_reader)) {
+        // loop head input is ready when the loop end is reached
+        pin_chunk(ds->decoder_reader, make_segment(ds, ds->loop_start, true).block_offset);
+    }
+    plan_next_segment(ds);
 
     auto res = read_decoded(ds->decoder_reader, ds->channels, get_sample_byte_size(ds->format), pFramesOut, frameCount, pFramesRead);
     if (!res) {
         // todo: handle starvation?
-        // assert(streaming_ds->read_cursor == 0);
+        if (ds->counters) count(ds->counters->underruns);
+        HLEA_TRACE_INSTANT("underrun", frameCount);
         return MA_BUSY;
     }
 
-    ds->read_cursor += *pFramesRead;
+    if (*pFramesRead == 0) return MA_AT_END;
 
     return MA_SUCCESS;
 }
 
 static ma_result streaming_data_source_seek(ma_data_source* pDataSource, ma_uint64 frameIndex) {
-    assert(false);
-    
-    // Seek to a specific PCM frame here. Return MA_NOT_IMPLEMENTED if seeking is not supported.
-    // ma_resource_manager_data_stream_seek_to_pcm_frame
-    return MA_NOT_IMPLEMENTED;
+    streaming_data_source_t* ds = (streaming_data_source_t*)pDataSource;
+
+    seek(ds->decoder_reader, make_segment(ds, frameIndex, frameIndex < ds->loop_end));
+
+    return MA_SUCCESS;
 }
 
 static ma_result streaming_data_source_get_data_format(
@@ -48,7 +109,7 @@ static ma_result streaming_data_source_get_data_format(
 static ma_result streaming_data_source_get_cursor(ma_data_source* pDataSource, ma_uint64* pCursor) {
     streaming_data_source_t* ds = (streaming_data_source_t*)pDataSource;
 
-    *pCursor = ds->read_cursor;
+    *pCursor = read_cursor(ds->decoder_reader);
 
     return MA_SUCCESS;
 }
@@ -67,7 +128,9 @@ static ma_data_source_vtable g_streaming_data_source_vtable = {
     streaming_data_source_seek,
     streaming_data_source_get_data_format,
     streaming_data_source_get_cursor,
-    streaming_data_source_get_length
+    streaming_data_source_get_length,
+    NULL, // onSetLooping
+    MA_DATA_SOURCE_SELF_MANAGED_RANGE_AND_LOOP_POINT // loop end is decoded gapless with loop head
 };
 
 ma_result streaming_data_source_init(streaming_data_source_t* data_source, const streaming_data_source_init_info_t& info) {
@@ -82,12 +145,30 @@ ma_result streaming_data_source_init(streaming_data_source_t* data_source, const
         return result;
     }
 
-    init(data_source->decoder_reader, info.decoder_reader_info);
-
     data_source->format = info.format;
     data_source->length_in_samples = info.meta.length_in_samples;
     data_source->channels = info.meta.channels;
     data_source->sample_rate = info.meta.sample_rate;
+    data_source->coding_format = info.meta.coding_format;
+    data_source->block_size = info.decoder_reader_info.buffer_block.size;
+    data_source->seek_points = info.seek_points;
+    data_source->seek_point_count = info.seek_point_count;
+    data_source->counters = info.counters;
+
+    data_source->loop_start = 0;
+    data_source->loop_end = info.meta.length_in_samples;
+    if (info.meta.loop_start < info.meta.loop_end && info.meta.loop_end <= info.meta.length_in_samples) {
+        data_source->loop_start = info.meta.loop_start;
+        data_source->loop_end = info.meta.loop_end;
+    }
+
+    // loop point is used by engine to seek when the loop end segment was planned without looping
+    ma_data_source_set_loop_point_in_pcm_frames(&data_source->base, data_source->loop_start, data_source->loop_end);
+
+    // the first segment is limited by loop end, as looping is set after init
+    auto reader_info = info.decoder_reader_info;
+    reader_info.first_segment = make_segment(data_source, 0, true);
+    init(data_source->decoder_reader, reader_info);
 
     return MA_SUCCESS;
 }
@@ -2,6 +2,7 @@
 
 #include "miniaudio_public.h"
 #include "push_decoder_data_source.h"
+#include "runtime_stats.h"
 
 namespace hle_audio {
 namespace rt {
@@ -15,16 +16,29 @@ struct streaming_data_source_t {
     ma_uint64 length_in_samples;
     ma_uint32 channels;
     ma_uint32 sample_rate;
+    audio_format_type_e coding_format;
+    uint32_t block_size;
 
-    ma_uint64 read_cursor;
+    const seek_point_t* seek_points;
+    uint32_t seek_point_count;
+
+    // loop region, the whole stream if not specified
+    ma_uint64 loop_start;
+    ma_uint64 loop_end;
+
+    runtime_counters_t* counters;
 };
 
 
 struct streaming_data_source_init_info_t {
     ma_format format;
     file_data_t::meta_t meta;
+    const seek_point_t* seek_points;
+    uint32_t seek_point_count;
 
     push_decoder_data_source_init_info_t decoder_reader_info;
+
+    runtime_counters_t* counters; // optional, underruns
 };
 
 ma_result streaming_data_source_init(streaming_data_source_t* pDataSource, const streaming_data_source_init_info_t& info);
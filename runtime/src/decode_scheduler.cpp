@@ -0,0 +1,334 @@
+#include "decode_scheduler.h"
+
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <chrono>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <climits>
+#elif defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#else
+#include <semaphore.h>
+#include <cerrno>
+#endif
+
+#include "alloc_utils.inl"
+#include "jobs_utils.inl"
+#include "trace.h"
+
+namespace hle_audio {
+namespace rt {
+
+/**
+ * platform semaphore, post never blocks so it's safe on audio thread
+ */
+struct launch_signal_t {
+#if defined(_WIN32)
+    HANDLE handle;
+#elif defined(__APPLE__)
+    dispatch_semaphore_t handle;
+#else
+    sem_t handle;
+#endif
+};
+
+static void init(launch_signal_t& signal) {
+#if defined(_WIN32)
+    signal.handle = CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr);
+#elif defined(__APPLE__)
+    signal.handle = dispatch_semaphore_create(0);
+#else
+    sem_init(&signal.handle, 0, 0);
+#endif
+}
+
+static void deinit(launch_signal_t& signal) {
+#if defined(_WIN32)
+    CloseHandle(signal.handle);
+#elif defined(__APPLE__)
+    dispatch_release(signal.handle);
+#else
+    sem_destroy(&signal.handle);
+#endif
+}
+
+static void post(launch_signal_t& signal) {
+#if defined(_WIN32)
+    ReleaseSemaphore(signal.handle, 1, nullptr);
+#elif defined(__APPLE__)
+    dispatch_semaphore_signal(signal.handle);
+#else
+    sem_post(&signal.handle);
+#endif
+}
+
+static void wait(launch_signal_t& signal) {
+#if defined(_WIN32)
+    WaitForSingleObject(signal.handle, INFINITE);
+#elif defined(__APPLE__)
+    dispatch_semaphore_wait(signal.handle, DISPATCH_TIME_FOREVER);
+#else
+    while (sem_wait(&signal.handle) == -1 && errno == EINTR) {}
+#endif
+}
+
+// batch jobs could take longer than audio quantum, so the next batch is launched with not running tasks
+static const size_t MAX_DECODE_BATCHES = 4;
+
+struct decode_batch_t;
+
+struct decode_batch_entry_t {
+    decode_task_t task;
+    decode_batch_t* batch;
+};
+
+/**
+ * each task step is a job, so steps are spread among job threads.
+ * Batch is filled on audio thread and launched on launcher thread
+ */
+struct decode_batch_t {
+    decode_batch_entry_t entries[MAX_DECODE_TASKS];
+    hlea_job_t jobs[MAX_DECODE_TASKS];
+    uint32_t task_count;
+    std::atomic<uint32_t> running_count;
+    std::atomic<bool> launch_pending;
+    runtime_counters_t* counters;
+};
+
+/**
+ * registered task, slots are claimed without locks:
+ * audio thread holds a slot (scheduling) only while calling the task,
+ * unregister waits for that, so the audio thread never waits
+ */
+enum task_slot_state_e : uint32_t {
+    TASK_SLOT_FREE,
+    TASK_SLOT_WRITING,
+    TASK_SLOT_ACTIVE,
+    TASK_SLOT_SCHEDULING
+};
+
+struct task_slot_t {
+    decode_task_t task;
+    std::atomic<uint32_t> state;
+};
+
+struct decode_scheduler_t {
+    allocator_t allocator;
+    jobs_t jobs;
+    uint32_t watermark_ms;
+    runtime_counters_t* counters;
+
+    task_slot_t task_slots[MAX_DECODE_TASKS];
+    std::atomic<uint32_t> task_slot_count; // used slots high water
+
+    struct candidate_t {
+        uint32_t buffered_time_ms;
+        uint32_t slot_index;
+        void* task_state;
+    };
+    candidate_t candidates[MAX_DECODE_TASKS];
+
+    decode_batch_t batches[MAX_DECODE_BATCHES];
+
+    // batches are launched off audio thread, job system could lock or wake threads
+    launch_signal_t launch_signal;
+    std::atomic<bool> stopped;
+    std::thread launcher_thread;
+};
+
+static void launch_pending_batches(decode_scheduler_t* sched) {
+    for (auto& batch : sched->batches) {
+        if (!batch.launch_pending.exchange(false)) continue;
+
+        // single wakeup for the whole batch
+        launch_batch(sched->jobs, batch.jobs, batch.task_count);
+    }
+}
+
+static void run_launcher(decode_scheduler_t* sched) {
+    HLEA_TRACE_THREAD_NAME("hlea decode launcher");
+
+    while (true) {
+        wait(sched->launch_signal);
+
+        // pending batches are launched before stop, their tasks wait for them
+        launch_pending_batches(sched);
+        if (sched->stopped) break;
+    }
+}
+
+decode_scheduler_t* create_decode_scheduler(const decode_scheduler_create_info_t& info) {
+    auto sched = allocate<decode_scheduler_t>(info.allocator);
+    sched = new(sched) decode_scheduler_t(); // init c++ members
+
+    sched->allocator = info.allocator;
+    sched->jobs = info.jobs;
+    sched->watermark_ms = info.watermark_ms ? info.watermark_ms : DEFAULT_DECODE_WATERMARK_MS;
+    sched->counters = info.counters;
+
+    init(sched->launch_signal);
+    sched->launcher_thread = std::thread(run_launcher, sched);
+
+    return sched;
+}
+
+void stop(decode_scheduler_t* sched) {
+    if (!sched->launcher_thread.joinable()) return;
+
+    sched->stopped = true;
+    post(sched->launch_signal);
+    sched->launcher_thread.join();
+}
+
+void destroy(decode_scheduler_t* sched) {
+    stop(sched);
+    deinit(sched->launch_signal);
+
+    for (auto& batch : sched->batches) {
+        assert(!batch.launch_pending);
+        assert(!batch.running_count && "launched jobs should be finished first");
+    }
+
+    sched->~decode_scheduler_t();
+    deallocate(sched->allocator, sched);
+}
+
+void register_task(decode_scheduler_t* sched, const decode_task_t& task) {
+    for (uint32_t i = 0; i < MAX_DECODE_TASKS; ++i) {
+        auto& slot = sched->task_slots[i];
+
+        uint32_t expected = TASK_SLOT_FREE;
+        if (!slot.state.compare_exchange_strong(expected, TASK_SLOT_WRITING)) continue;
+
+        slot.task = task;
+
+        auto slot_count = sched->task_slot_count.load();
+        while (slot_count <= i && !sched->task_slot_count.compare_exchange_weak(slot_count, i + 1)) {}
+
+        slot.state = TASK_SLOT_ACTIVE;
+        return;
+    }
+
+    assert(false && "decode tasks overflow");
+}
+
+void unregister_task(decode_scheduler_t* sched, void* task_state) {
+    const auto slot_count = sched->task_slot_count.load();
+    for (uint32_t i = 0; i < slot_count; ++i) {
+        auto& slot = sched->task_slots[i];
+
+        auto state = slot.state.load();
+        if (state != TASK_SLOT_ACTIVE && state != TASK_SLOT_SCHEDULING) continue;
+        if (slot.task.state != task_state) continue;
+
+        // the audio thread is calling the task, it's released shortly
+        uint32_t expected = TASK_SLOT_ACTIVE;
+        while (!slot.state.compare_exchange_weak(expected, TASK_SLOT_FREE)) {
+            if (expected == TASK_SLOT_SCHEDULING) std::this_thread::yield();
+            expected = TASK_SLOT_ACTIVE;
+        }
+        return;
+    }
+}
+
+static bool acquire_slot(task_slot_t& slot) {
+    uint32_t expected = TASK_SLOT_ACTIVE;
+    return slot.state.compare_exchange_strong(expected, TASK_SLOT_SCHEDULING);
+}
+
+static void release_slot(task_slot_t& slot) {
+    slot.state = TASK_SLOT_ACTIVE;
+}
+
+static void decode_step_jobfunc(void* udata) {
+    auto entry = (decode_batch_entry_t*)udata;
+
+    auto counters = entry->batch->counters;
+    if (counters) {
+        auto start = std::chrono::steady_clock::now();
+        entry->task.vt->run_step(entry->task.state);
+
+        auto step_time = std::chrono::steady_clock::now() - start;
+        count(counters->decode_time_us, std::chrono::duration_cast<std::chrono::microseconds>(step_time).count());
+    } else {
+        entry->task.vt->run_step(entry->task.state);
+    }
+
+    --entry->batch->running_count;
+}
+
+static decode_batch_t* find_free_batch(decode_scheduler_t* sched) {
+    for (auto& batch : sched->batches) {
+        if (!batch.running_count && !batch.launch_pending) return &batch;
+    }
+    return nullptr;
+}
+
+void process_decode_tasks(decode_scheduler_t* sched) {
+    auto batch = find_free_batch(sched);
+    if (!batch) return;
+
+    uint32_t candidate_count = 0;
+    const auto slot_count = sched->task_slot_count.load();
+    for (uint32_t i = 0; i < slot_count; ++i) {
+        auto& slot = sched->task_slots[i];
+        if (!acquire_slot(slot)) continue;
+
+        auto task = slot.task;
+        auto buffered_time_ms = task.vt->buffered_time_ms(task.state);
+        release_slot(slot);
+
+        if (sched->watermark_ms <= buffered_time_ms) continue;
+
+        auto& candidate = sched->candidates[candidate_count++];
+        candidate.buffered_time_ms = buffered_time_ms;
+        candidate.slot_index = i;
+        candidate.task_state = task.state;
+    }
+    if (!candidate_count) return;
+
+    // the most urgent first
+    std::sort(sched->candidates, sched->candidates + candidate_count,
+        [](const decode_scheduler_t::candidate_t& a, const decode_scheduler_t::candidate_t& b) {
+            return a.buffered_time_ms < b.buffered_time_ms;
+        });
+
+    batch->task_count = 0;
+    for (uint32_t i = 0; i < candidate_count; ++i) {
+        auto& candidate = sched->candidates[i];
+        auto& slot = sched->task_slots[candidate.slot_index];
+        if (!acquire_slot(slot)) continue;
+
+        // unregistered since, slot could be taken by another task
+        auto task = slot.task;
+        bool started = task.state == candidate.task_state && task.vt->begin_step(task.state);
+        release_slot(slot);
+        if (!started) continue;
+
+        auto& entry = batch->entries[batch->task_count];
+        entry.task = task;
+        entry.batch = batch;
+
+        auto& job = batch->jobs[batch->task_count];
+        job.job_func = decode_step_jobfunc;
+        job.udata = &entry;
+
+        ++batch->task_count;
+    }
+    if (!batch->task_count) return;
+
+    batch->running_count = batch->task_count;
+    batch->counters = sched->counters;
+    if (sched->counters) count(sched->counters->decode_jobs, batch->task_count);
+
+    batch->launch_pending = true;
+    post(sched->launch_signal);
+}
+
+}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include "internal_alloc_types.h"
+#include "internal_jobs_types.h"
+#include "runtime_stats.h"
+
+namespace hle_audio {
+namespace rt {
+
+/**
+ * @brief decoding step of async decoder, steps are batched by decode_scheduler_t
+ */
+struct decode_task_ti {
+    // decoded output not read yet
+    uint32_t (*buffered_time_ms)(void* state);
+
+    // called on scheduling (audio) thread, marks decoder running, false if there is nothing to decode
+    bool (*begin_step)(void* state);
+
+    // called on job thread, resets running state when finished
+    void (*run_step)(void* state);
+};
+
+struct decode_task_t {
+    const decode_task_ti* vt;
+    void* state;
+};
+
+struct decode_scheduler_t;
+
+static const uint16_t DEFAULT_DECODE_WATERMARK_MS = 60;
+
+// a step job per task at most is queued
+static const uint32_t MAX_DECODE_TASKS = 1024; // MAX_SOUNDS
+
+struct decode_scheduler_create_info_t {
+    allocator_t allocator;
+    jobs_t jobs;
+
+    // tasks with more buffered output are not scheduled
+    uint16_t watermark_ms;
+
+    runtime_counters_t* counters; // optional
+};
+
+decode_scheduler_t* create_decode_scheduler(const decode_scheduler_create_info_t& info);
+
+/**
+ * @brief launches pending batches and stops launcher thread, no batches are launched after.
+ *  Expected after audio thread is stopped, launched jobs could still run
+ */
+void stop(decode_scheduler_t* sched);
+
+/**
+ * @brief jobs launched by scheduler are expected to be finished (job system drained)
+ */
+void destroy(decode_scheduler_t* sched);
+
+void register_task(decode_scheduler_t* sched, const decode_task_t& task);
+
+/**
+ * @brief task is not started after the call, the step started before could be still running.
+ *  Lock-free, could spin while audio thread calls the task
+ */
+void unregister_task(decode_scheduler_t* sched, void* task_state);
+
+/**
+ * @brief prepares a batch of jobs decoding all tasks below watermark, the most urgent first.
+ *  Expected to be called once per audio quantum, lock-free: batch is launched by scheduler thread
+ */
+void process_decode_tasks(decode_scheduler_t* sched);
+
+}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "decoder.h"
+
+namespace hle_audio {
+namespace rt {
+
+/**
+ * @brief decoded frames window of the current decoder segment (see decoder_ti::start_segment)
+ */
+struct segment_window_t {
+    uint64_t skip_frames;
+    uint64_t frames_left;
+};
+
+static segment_window_t make_segment_window(uint64_t skip_frames, uint64_t max_frames) {
+    segment_window_t res = {};
+    res.skip_frames = skip_frames;
+    res.frames_left = max_frames;
+    return res;
+}
+
+static segment_window_t unlimited_segment_window() {
+    return make_segment_window(0, SEGMENT_UNLIMITED_FRAMES);
+}
+
+static bool is_complete(const segment_window_t& window) {
+    return window.frames_left == 0;
+}
+
+/**
+ * @brief trims decoded [frame_offset, frame_count) range to the window and advances it
+ */
+static void trim_frames(segment_window_t& window, int* frame_offset, int* frame_count) {
+    uint64_t frames = *frame_count - *frame_offset;
+
+    uint64_t skipped = window.skip_frames < frames ? window.skip_frames : frames;
+    window.skip_frames -= skipped;
+    frames -= skipped;
+    *frame_offset += int(skipped);
+
+    if (window.frames_left < frames) frames = window.frames_left;
+    if (window.frames_left != SEGMENT_UNLIMITED_FRAMES) window.frames_left -= frames;
+    *frame_count = *frame_offset + int(frames);
+}
+
+}
+}
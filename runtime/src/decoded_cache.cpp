@@ -0,0 +1,260 @@
+#include "decoded_cache.h"
+
+#include <atomic>
+#include <thread>
+#include <cassert>
+
+#include "decoders/decoder_mp3.h"
+#include "decoders/decoder_vorbis.h"
+#include "decoders/decoder_adpcm.h"
+
+#include "alloc_utils.inl"
+#include "jobs_utils.inl"
+#include "trace.h"
+
+namespace hle_audio {
+namespace rt {
+
+enum class entry_state_e : uint8_t {
+    UNUSED,
+    DECODING,
+    READY,
+    FAILED
+};
+
+struct decoded_entry_t {
+    decoded_cache_key_t key;
+    std::atomic<entry_state_e> state;
+
+    // job input
+    allocator_t allocator;
+    file_data_t::meta_t meta;
+    data_buffer_t encoded;
+
+    data_buffer_t frames; // s16
+
+    uint32_t ref_count;
+    uint64_t last_use;
+};
+
+struct decoded_cache_t {
+    allocator_t allocator;
+    jobs_t jobs;
+    uint64_t budget_bytes;
+    uint32_t max_sound_bytes;
+
+    decoded_entry_t entries[MAX_DECODED_ENTRIES];
+    uint64_t used_bytes;
+    uint64_t use_counter;
+};
+
+static uint64_t decoded_size(const file_data_t::meta_t& meta) {
+    return meta.length_in_samples * meta.channels * sizeof(int16_t);
+}
+
+static uint32_t to_entry_id(uint32_t entry_index) {
+    return entry_index + 1;
+}
+
+static decoded_entry_t& get_entry(decoded_cache_t* cache, uint32_t entry_id) {
+    assert(entry_id && entry_id <= MAX_DECODED_ENTRIES);
+    return cache->entries[entry_id - 1];
+}
+
+decoded_cache_t* create_decoded_cache(const decoded_cache_create_info_t& info) {
+    auto cache = allocate<decoded_cache_t>(info.allocator);
+    cache = new(cache) decoded_cache_t(); // init c++ members
+    cache->allocator = info.allocator;
+    cache->jobs = info.jobs;
+    cache->budget_bytes = info.budget_bytes;
+    cache->max_sound_bytes = info.max_sound_bytes;
+
+    return cache;
+}
+
+static void wait_decoding(decoded_entry_t& entry) {
+    // rare (unload) case, so no blocking primitives
+    while (entry.state == entry_state_e::DECODING) {
+        std::this_thread::yield();
+    }
+}
+
+static void free_entry(decoded_cache_t* cache, decoded_entry_t& entry) {
+    assert(!entry.ref_count && "decoded sound is still played");
+    wait_decoding(entry);
+
+    deallocate(cache->allocator, entry.frames.data);
+    cache->used_bytes -= entry.frames.size;
+
+    entry.frames = {};
+    entry.key = {};
+    entry.state = entry_state_e::UNUSED;
+}
+
+void destroy(decoded_cache_t* cache) {
+    for (auto& entry : cache->entries) {
+        if (entry.state != entry_state_e::UNUSED) free_entry(cache, entry);
+    }
+
+    cache->~decoded_cache_t();
+    deallocate(cache->allocator, cache);
+}
+
+bool is_cacheable(const decoded_cache_t* cache, const file_data_t::meta_t& meta) {
+    if (!cache->budget_bytes || meta.stream) return false;
+
+    switch (meta.coding_format) {
+    case audio_format_type_e::mp3:
+    case audio_format_type_e::vorbis:
+    case audio_format_type_e::adpcm:
+        break;
+    default:
+        // pcm is played from bank data as is
+        return false;
+    }
+
+    auto size = decoded_size(meta);
+    if (cache->budget_bytes < size) return false;
+
+    return meta.cache_decoded || size <= cache->max_sound_bytes;
+}
+
+static decoded_entry_t* find_entry(decoded_cache_t* cache, const decoded_cache_key_t& key) {
+    for (auto& entry : cache->entries) {
+        if (entry.state == entry_state_e::UNUSED) continue;
+        if (entry.key.owner == key.owner && entry.key.file_index == key.file_index) return &entry;
+    }
+    return nullptr;
+}
+
+static decoded_entry_t* find_unused(decoded_cache_t* cache) {
+    for (auto& entry : cache->entries) {
+        if (entry.state == entry_state_e::UNUSED) return &entry;
+    }
+    return nullptr;
+}
+
+/**
+ * @return least recently used decoded entry not in use, nullptr if there is none
+ */
+static decoded_entry_t* find_evictable(decoded_cache_t* cache) {
+    decoded_entry_t* res = nullptr;
+    for (auto& entry : cache->entries) {
+        auto state = entry.state.load();
+        if (state == entry_state_e::UNUSED || state == entry_state_e::DECODING || entry.ref_count) continue;
+
+        if (!res || entry.last_use < res->last_use) res = &entry;
+    }
+    return res;
+}
+
+static void decode_entry_jobfunc(void* udata) {
+    HLEA_TRACE_SCOPE("decode cached sound");
+
+    auto entry = (decoded_entry_t*)udata;
+    auto& meta = entry->meta;
+
+    auto frames_out = (int16_t*)entry->frames.data;
+    uint64_t frame_count = meta.length_in_samples;
+
+    uint64_t frames_written = 0;
+    switch (meta.coding_format) {
+    case audio_format_type_e::mp3:
+        frames_written = mp3_decode_buffer_s16(entry->encoded, meta.channels, frames_out, frame_count);
+        break;
+    case audio_format_type_e::vorbis:
+        frames_written = vorbis_decode_buffer_s16(entry->allocator, entry->encoded, meta.channels, frames_out, frame_count);
+        break;
+    case audio_format_type_e::adpcm:
+        frames_written = adpcm_decode_buffer_s16(entry->encoded, meta.channels, frames_out, frame_count);
+        break;
+    default:
+        break;
+    }
+
+    entry->state = frames_written == frame_count ? entry_state_e::READY : entry_state_e::FAILED;
+}
+
+static decoded_entry_t* start_decoding(decoded_cache_t* cache, const decoded_cache_key_t& key,
+        const file_data_t::meta_t& meta, const data_buffer_t& encoded) {
+    auto size = decoded_size(meta);
+
+    // free space evicting least recently used entries
+    while (cache->budget_bytes < cache->used_bytes + size) {
+        auto evicted = find_evictable(cache);
+        if (!evicted) return nullptr;
+
+        free_entry(cache, *evicted);
+    }
+
+    auto entry = find_unused(cache);
+    if (!entry) {
+        entry = find_evictable(cache);
+        if (!entry) return nullptr;
+
+        free_entry(cache, *entry);
+    }
+
+    entry->key = key;
+    entry->allocator = cache->allocator;
+    entry->meta = meta;
+    entry->encoded = encoded;
+    entry->frames.data = (uint8_t*)allocate(cache->allocator, size_t(size), alignof(int16_t));
+    entry->frames.size = size;
+    entry->ref_count = 0;
+    entry->last_use = ++cache->use_counter;
+    cache->used_bytes += size;
+
+    entry->state = entry_state_e::DECODING;
+
+    hlea_job_t job = {};
+    job.job_func = decode_entry_jobfunc;
+    job.udata = entry;
+    launch(cache->jobs, job);
+
+    return entry;
+}
+
+void prefetch(decoded_cache_t* cache, const decoded_cache_key_t& key,
+        const file_data_t::meta_t& meta, const data_buffer_t& encoded) {
+    if (find_entry(cache, key)) return;
+
+    start_decoding(cache, key, meta, encoded);
+}
+
+decoded_sound_t acquire(decoded_cache_t* cache, const decoded_cache_key_t& key,
+        const file_data_t::meta_t& meta, const data_buffer_t& encoded) {
+    decoded_sound_t res = {};
+
+    auto entry = find_entry(cache, key);
+    if (!entry) {
+        // played with decoder this time
+        start_decoding(cache, key, meta, encoded);
+        return res;
+    }
+
+    entry->last_use = ++cache->use_counter;
+    if (entry->state != entry_state_e::READY) return res;
+
+    ++entry->ref_count;
+    res.entry_id = to_entry_id(uint32_t(entry - cache->entries));
+    res.frames = entry->frames;
+    return res;
+}
+
+void release(decoded_cache_t* cache, uint32_t entry_id) {
+    auto& entry = get_entry(cache, entry_id);
+    assert(entry.ref_count);
+    --entry.ref_count;
+}
+
+void release_owner(decoded_cache_t* cache, const void* owner) {
+    for (auto& entry : cache->entries) {
+        if (entry.state == entry_state_e::UNUSED || entry.key.owner != owner) continue;
+
+        free_entry(cache, entry);
+    }
+}
+
+}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include "internal_alloc_types.h"
+#include "internal_jobs_types.h"
+#include "rt_types.h"
+
+namespace hle_audio {
+namespace rt {
+
+// a decoding job per entry at most is queued
+static const uint32_t MAX_DECODED_ENTRIES = 256;
+
+/**
+ * @brief decoded s16 frames of short/frequently played compressed sounds, LRU with bytes budget.
+ *  Sounds are decoded once on job threads and played through pcm decoder then
+ */
+struct decoded_cache_t;
+
+struct decoded_cache_create_info_t {
+    allocator_t allocator;
+    jobs_t jobs;
+
+    // decoded data total size, entries not in use are evicted (least recently used first)
+    uint64_t budget_bytes;
+
+    // sounds with decoded size up to the threshold are cached (file_data_t::meta_t::cache_decoded are always)
+    uint32_t max_sound_bytes;
+};
+
+struct decoded_cache_key_t {
+    const void* owner; // e.g. bank
+    uint32_t file_index;
+};
+
+struct decoded_sound_t {
+    uint32_t entry_id; // 0 - not cached (yet)
+    data_buffer_t frames;
+};
+
+decoded_cache_t* create_decoded_cache(const decoded_cache_create_info_t& info);
+void destroy(decoded_cache_t* cache);
+
+bool is_cacheable(const decoded_cache_t* cache, const file_data_t::meta_t& meta);
+
+/**
+ * @brief decoding job is started if sound isn't cached yet
+ * @param encoded is expected to be valid till release_owner
+ */
+void prefetch(decoded_cache_t* cache, const decoded_cache_key_t& key,
+    const file_data_t::meta_t& meta, const data_buffer_t& encoded);
+
+/**
+ * @brief returns decoded frames kept in cache till release, starts decoding (see prefetch) on miss
+ */
+decoded_sound_t acquire(decoded_cache_t* cache, const decoded_cache_key_t& key,
+    const file_data_t::meta_t& meta, const data_buffer_t& encoded);
+void release(decoded_cache_t* cache, uint32_t entry_id);
+
+/**
+ * @brief drops all owner entries, waits for their decoding jobs to finish
+ */
+void release_owner(decoded_cache_t* cache, const void* owner);
+
+}
+}
@@ -5,6 +5,8 @@
 namespace hle_audio {
 namespace rt {
 
+static const uint64_t SEGMENT_UNLIMITED_FRAMES = ~0ull;
+
 struct decoder_ti {
     size_t (*release_consumed_inputs)(void* state);
     bool (*queue_input)(void* state, const data_buffer_t& buf, bool last_input);
@@ -16,6 +18,22 @@ struct decoder_ti {
      */
     void (*flush)(void* state);
 
+    /**
+     * @brief the next queued input starts a new segment: decoder state is reset there,
+     *  skip_frames decoded frames are dropped, max_frames are output at most
+     *  and the rest of segment inputs (till the last_input one) is consumed without output
+     */
+    void (*start_segment)(void* state, uint64_t skip_frames, uint64_t max_frames);
+
+    /**
+     * @brief optional, decodes straight into frames_out (no intermediate output copy),
+     *  expected to be called instead of next_output when the current output is read completely.
+     *  Set by synchronous decoders only (adpcm), mp3 and vorbis are decoded ahead on job threads
+     *  into the output ring, as decoding into frames_out would run them on the audio thread
+     * @return frames written, frame_count at most, 0 when no input is ready
+     */
+    uint64_t (*decode_into)(void* state, void* frames_out, uint64_t frame_count);
+
     // destructor, todo: move out lifecycle management out of api
     void (*destroy)(void* state);
 };
@@ -37,8 +55,9 @@ static data_buffer_t next_output(decoder_t& dec, const data_buffer_t& current_bu
     return dec.vt->next_output(dec.state, current_buf);
 }
 
+// not set decoder (e.g. direct pcm) is never running
 static bool is_running(decoder_t& dec) {
-    return dec.vt->is_running(dec.state);
+    return dec.vt && dec.vt->is_running(dec.state);
 }
 
 static void flush(decoder_t& dec) {
@@ -46,6 +65,20 @@ static void flush(decoder_t& dec) {
     dec.vt->flush(dec.state);
 }
 
+static void start_segment(decoder_t& dec, uint64_t skip_frames, uint64_t max_frames = SEGMENT_UNLIMITED_FRAMES) {
+    assert(dec.vt->start_segment);
+    dec.vt->start_segment(dec.state, skip_frames, max_frames);
+}
+
+static bool can_decode_into(const decoder_t& dec) {
+    return dec.vt && dec.vt->decode_into;
+}
+
+static uint64_t decode_into(decoder_t& dec, void* frames_out, uint64_t frame_count) {
+    assert(can_decode_into(dec));
+    return dec.vt->decode_into(dec.state, frames_out, frame_count);
+}
+
 static void destroy(decoder_t& dec) {
     assert(dec.vt->destroy);
     dec.vt->destroy(dec.state);
@@ -0,0 +1,407 @@
+#include "decoder_adpcm.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "adpcm.h"
+
+#include "alloc_utils.inl"
+#include "decode_segment.inl"
+
+namespace hle_audio {
+namespace rt {
+
+/**
+ * @brief IMA ADPCM decoder (see adpcm.h for blocks layout)
+ *  decodes synchronously in next_output, no jobs are launched.
+ *  Frames requested by reader are decoded straight into its frames (decode_into),
+ *  a block could be decoded partially, channel states are kept to continue it with the next read.
+ *  Blocks crossing input buffers (streaming) are gathered into block_staging first
+ */
+
+static const size_t MAX_INPUT_BUFFERS = 2;
+static const size_t MAX_OUTPUT_BLOCKS = 2;
+
+struct input_buffer_t {
+    data_buffer_t buffer;
+    bool last;
+    bool segment_start;
+    segment_window_t segment;
+};
+
+/**
+ * block being decoded, [frame_pos, frame_end) frames are left
+ */
+struct block_cursor_t {
+    const uint8_t* block; // nullptr if no block in progress
+    adpcm_channel_state_t states[ADPCM_MAX_CHANNELS];
+    uint32_t frame_pos;
+    uint32_t frame_end;
+};
+
+struct adpcm_decoder_t {
+    allocator_t allocator;
+    uint8_t channels;
+    size_t block_size;
+
+    input_buffer_t inputs[MAX_INPUT_BUFFERS];
+    uint8_t input_count;
+    uint8_t consumed_input_count;
+    size_t input_read_bytes; // of inputs[consumed_input_count]
+
+    uint8_t block_staging[(ADPCM_BLOCK_HEADER_SIZE + ADPCM_BLOCK_CODES_SIZE) * ADPCM_MAX_CHANNELS];
+    size_t block_staging_size;
+
+    block_cursor_t cursor;
+
+    segment_window_t segment;
+    bool segment_pending;
+    segment_window_t pending_segment;
+
+    int16_t output[MAX_OUTPUT_BLOCKS * ADPCM_BLOCK_FRAMES * ADPCM_MAX_CHANNELS];
+};
+
+adpcm_decoder_t* create_decoder(const adpcm_decoder_create_info_t& info) {
+    auto dec = allocate<adpcm_decoder_t>(info.allocator);
+    *dec = {};
+    dec->allocator = info.allocator;
+    dec->segment = unlimited_segment_window();
+    set_channels(dec, info.channels);
+    return dec;
+}
+
+void set_channels(adpcm_decoder_t* dec, uint8_t channels) {
+    assert(channels && channels <= ADPCM_MAX_CHANNELS);
+
+    dec->channels = channels;
+    dec->block_size = adpcm_block_size(channels);
+}
+
+void destroy(adpcm_decoder_t* dec) {
+    deallocate(dec->allocator, dec);
+}
+
+void reset(adpcm_decoder_t* dec) {
+    dec->input_count = 0;
+    dec->consumed_input_count = 0;
+    dec->input_read_bytes = 0;
+    dec->block_staging_size = 0;
+    dec->cursor = {};
+    dec->segment = unlimited_segment_window();
+    dec->segment_pending = false;
+}
+
+static void init_block_states(const uint8_t* block, uint8_t channels, adpcm_channel_state_t* states) {
+    for (uint8_t ch = 0; ch < channels; ++ch) {
+        const uint8_t* header = block + ADPCM_BLOCK_HEADER_SIZE * ch;
+
+        int16_t predictor;
+        memcpy(&predictor, header, sizeof(predictor));
+
+        states[ch] = {};
+        states[ch].predictor = predictor;
+        states[ch].step_index = header[2] < 88 ? header[2] : 88;
+    }
+}
+
+/**
+ * @brief decodes [frame_begin, frame_end) block frames continuing channel states,
+ *  frames are only skipped (states advanced) if out_frames is not set
+ */
+static void decode_block_frames(const uint8_t* block, uint8_t channels, adpcm_channel_state_t* states,
+        uint32_t frame_begin, uint32_t frame_end, int16_t* out_frames) {
+    const uint8_t* codes = block + ADPCM_BLOCK_HEADER_SIZE * channels;
+
+    for (uint8_t ch = 0; ch < channels; ++ch) {
+        auto& state = states[ch];
+        const uint8_t* channel_codes = codes + ADPCM_BLOCK_CODES_SIZE * ch;
+
+        uint32_t frame = frame_begin;
+        int16_t* out = out_frames ? out_frames + ch : nullptr;
+
+        // odd start frame is the high nibble
+        if (frame < frame_end && (frame & 1)) {
+            auto sample = adpcm_decode_sample(&state, channel_codes[frame / 2] >> 4);
+            if (out) { out[0] = sample; out += channels; }
+            ++frame;
+        }
+        for (; frame + 2 <= frame_end; frame += 2) {
+            uint8_t code_pair = channel_codes[frame / 2];
+            auto sample0 = adpcm_decode_sample(&state, code_pair & 0xf);
+            auto sample1 = adpcm_decode_sample(&state, code_pair >> 4);
+            if (out) {
+                out[0] = sample0;
+                out[channels] = sample1;
+                out += 2 * channels;
+            }
+        }
+        if (frame < frame_end) {
+            auto sample = adpcm_decode_sample(&state, channel_codes[frame / 2] & 0xf);
+            if (out) out[0] = sample;
+        }
+    }
+}
+
+static void decode_block(const uint8_t* block, uint8_t channels, int16_t* out_frames) {
+    adpcm_channel_state_t states[ADPCM_MAX_CHANNELS];
+    init_block_states(block, channels, states);
+    decode_block_frames(block, channels, states, 0, ADPCM_BLOCK_FRAMES, out_frames);
+}
+
+static const uint8_t* next_block(adpcm_decoder_t* dec) {
+    while (dec->consumed_input_count < dec->input_count) {
+        auto& input = dec->inputs[dec->consumed_input_count];
+        if (input.segment_start) {
+            input.segment_start = false;
+            dec->segment = input.segment;
+            dec->block_staging_size = 0;
+        }
+
+        // the rest of segment inputs is not decoded
+        if (is_complete(dec->segment)) {
+            dec->input_read_bytes = 0;
+            ++dec->consumed_input_count;
+            continue;
+        }
+
+        auto rest = advance(input.buffer, dec->input_read_bytes);
+
+        const uint8_t* block = nullptr;
+        if (dec->block_staging_size == 0 && dec->block_size <= rest.size) {
+            // whole block within the input
+            block = rest.data;
+            dec->input_read_bytes += dec->block_size;
+        } else {
+            auto copy_size = dec->block_size - dec->block_staging_size;
+            copy_size = copy_size < rest.size ? copy_size : rest.size;
+            memcpy(&dec->block_staging[dec->block_staging_size], rest.data, copy_size);
+            dec->block_staging_size += copy_size;
+            dec->input_read_bytes += copy_size;
+
+            if (dec->block_staging_size == dec->block_size) {
+                dec->block_staging_size = 0;
+                block = dec->block_staging;
+            }
+        }
+
+        if (dec->input_read_bytes == input.buffer.size) {
+            // truncated block of the last input is dropped
+            if (input.last) dec->block_staging_size = 0;
+
+            dec->input_read_bytes = 0;
+            ++dec->consumed_input_count;
+        }
+
+        if (block) return block;
+    }
+
+    return nullptr;
+}
+
+static size_t release_consumed_inputs(adpcm_decoder_t* dec) {
+    auto consumed_input_count = dec->consumed_input_count;
+
+    if (consumed_input_count) {
+        for (auto i = consumed_input_count; i < dec->input_count; ++i) {
+            dec->inputs[i - consumed_input_count] = dec->inputs[i];
+        }
+        dec->input_count -= consumed_input_count;
+        dec->consumed_input_count = 0;
+    }
+
+    return consumed_input_count;
+}
+
+static bool queue_input(adpcm_decoder_t* dec, const data_buffer_t& buf, bool last_input) {
+    // should not be the case ever, ?assert?
+    if (dec->input_count == MAX_INPUT_BUFFERS) return false;
+
+    input_buffer_t input = {};
+    input.buffer = buf;
+    input.last = last_input;
+    input.segment_start = dec->segment_pending;
+    input.segment = dec->pending_segment;
+    dec->inputs[dec->input_count++] = input;
+
+    dec->segment_pending = false;
+
+    return true;
+}
+
+/**
+ * @brief starts the next block, segment window is applied to its frames
+ * @return false if no block input is ready
+ */
+static bool start_block(adpcm_decoder_t* dec) {
+    auto& cursor = dec->cursor;
+
+    auto consumed_input_count = dec->consumed_input_count;
+    auto block = next_block(dec);
+    if (!block) return false;
+
+    // block of consumed input could be released before it's decoded completely
+    if (block != dec->block_staging && consumed_input_count != dec->consumed_input_count) {
+        memcpy(dec->block_staging, block, dec->block_size);
+        block = dec->block_staging;
+    }
+
+    int block_frame_offset = 0;
+    int block_frame_count = ADPCM_BLOCK_FRAMES;
+    trim_frames(dec->segment, &block_frame_offset, &block_frame_count);
+
+    cursor.block = block;
+    cursor.frame_pos = uint32_t(block_frame_offset);
+    cursor.frame_end = uint32_t(block_frame_count);
+    init_block_states(block, dec->channels, cursor.states);
+    decode_block_frames(block, dec->channels, cursor.states, 0, cursor.frame_pos, nullptr);
+    return true;
+}
+
+/**
+ * @brief decodes up to max_frames continuing the current block, stops at the segment end
+ * @return frames written
+ */
+static uint64_t decode_frames(adpcm_decoder_t* dec, int16_t* frames_out, uint64_t max_frames) {
+    const size_t channels = dec->channels;
+    auto& cursor = dec->cursor;
+
+    uint64_t frame_count = 0;
+    while (frame_count < max_frames) {
+        if (!cursor.block && !start_block(dec)) break;
+
+        auto frames = uint32_t(std::min<uint64_t>(cursor.frame_end - cursor.frame_pos, max_frames - frame_count));
+        decode_block_frames(cursor.block, dec->channels, cursor.states,
+            cursor.frame_pos, cursor.frame_pos + frames, &frames_out[frame_count * channels]);
+        cursor.frame_pos += frames;
+        frame_count += frames;
+
+        if (cursor.frame_pos == cursor.frame_end) {
+            cursor.block = nullptr;
+
+            // the next segment frames are read separately
+            if (is_complete(dec->segment)) break;
+        }
+    }
+
+    return frame_count;
+}
+
+static data_buffer_t next_output(adpcm_decoder_t* dec, const data_buffer_t& output_buf) {
+    // previous output is released by decoding over it
+    assert(!output_buf.size || output_buf.data == (uint8_t*)dec->output);
+
+    auto frame_count = decode_frames(dec, dec->output, MAX_OUTPUT_BLOCKS * ADPCM_BLOCK_FRAMES);
+
+    data_buffer_t res = {};
+    if (frame_count) {
+        res.data = (uint8_t*)dec->output;
+        res.size = size_t(frame_count * dec->channels * sizeof(int16_t));
+    }
+    return res;
+}
+
+static uint64_t decode_into(adpcm_decoder_t* dec, void* frames_out, uint64_t frame_count) {
+    return decode_frames(dec, (int16_t*)frames_out, frame_count);
+}
+
+static void flush(adpcm_decoder_t* dec) {
+    reset(dec);
+}
+
+static void start_segment(adpcm_decoder_t* dec, uint64_t skip_frames, uint64_t max_frames) {
+    dec->segment_pending = true;
+    dec->pending_segment = make_segment_window(skip_frames, max_frames);
+}
+
+
+//
+// decoder_ti vtable
+//
+
+static size_t adpcm_dec_release_consumed_inputs(void* state) {
+    auto dec = (adpcm_decoder_t*)state;
+    return release_consumed_inputs(dec);
+}
+
+static bool adpcm_dec_queue_input(void* state, const data_buffer_t& buf, bool last_input) {
+    auto dec = (adpcm_decoder_t*)state;
+    return queue_input(dec, buf, last_input);
+}
+
+static data_buffer_t adpcm_dec_next_output(void* state, const data_buffer_t& current_buf) {
+    auto dec = (adpcm_decoder_t*)state;
+    return next_output(dec, current_buf);
+}
+
+static bool adpcm_dec_is_running(void* state) {
+    // decoded synchronously
+    return false;
+}
+
+static void adpcm_dec_flush(void* state) {
+    auto dec = (adpcm_decoder_t*)state;
+    flush(dec);
+}
+
+static void adpcm_dec_start_segment(void* state, uint64_t skip_frames, uint64_t max_frames) {
+    auto dec = (adpcm_decoder_t*)state;
+    start_segment(dec, skip_frames, max_frames);
+}
+
+static uint64_t adpcm_dec_decode_into(void* state, void* frames_out, uint64_t frame_count) {
+    auto dec = (adpcm_decoder_t*)state;
+    return decode_into(dec, frames_out, frame_count);
+}
+
+static void adpcm_dec_destroy(void* state) {
+    auto dec = (adpcm_decoder_t*)state;
+    destroy(dec);
+}
+
+static const decoder_ti g_adpcm_decoder_vt = []() {
+    decoder_ti vt = {};
+    vt.release_consumed_inputs = adpcm_dec_release_consumed_inputs;
+    vt.queue_input = adpcm_dec_queue_input;
+    vt.next_output = adpcm_dec_next_output;
+    vt.is_running = adpcm_dec_is_running;
+    vt.flush = adpcm_dec_flush;
+    vt.start_segment = adpcm_dec_start_segment;
+    vt.decode_into = adpcm_dec_decode_into;
+    vt.destroy = adpcm_dec_destroy;
+
+    return vt;
+}();
+
+decoder_t cast_to_decoder(adpcm_decoder_t* dec) {
+    decoder_t res = {};
+    res.vt = &g_adpcm_decoder_vt;
+    res.state = dec;
+    return res;
+}
+
+uint64_t adpcm_decode_buffer_s16(const data_buffer_t& input, uint8_t channels, int16_t* frames_out, uint64_t frame_count) {
+    const auto block_size = adpcm_block_size(channels);
+
+    int16_t block_frames[ADPCM_BLOCK_FRAMES * ADPCM_MAX_CHANNELS];
+
+    uint64_t frames_written = 0;
+    for (size_t offset = 0; offset + block_size <= input.size && frames_written < frame_count; offset += block_size) {
+        auto frames_left = frame_count - frames_written;
+
+        // the last block is decoded into the temp buffer, as it's usually partially used
+        if (frames_left < ADPCM_BLOCK_FRAMES) {
+            decode_block(input.data + offset, channels, block_frames);
+            memcpy(frames_out + frames_written * channels, block_frames, size_t(frames_left * channels * sizeof(int16_t)));
+            frames_written += frames_left;
+            break;
+        }
+
+        decode_block(input.data + offset, channels, frames_out + frames_written * channels);
+        frames_written += ADPCM_BLOCK_FRAMES;
+    }
+
+    return frames_written;
+}
+
+}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "decoder.h"
+#include "internal_alloc_types.h"
+
+namespace hle_audio {
+namespace rt {
+
+struct adpcm_decoder_t;
+
+struct adpcm_decoder_create_info_t {
+    allocator_t allocator;
+    uint8_t channels;
+};
+
+adpcm_decoder_t* create_decoder(const adpcm_decoder_create_info_t& info);
+void destroy(adpcm_decoder_t* dec);
+
+void reset(adpcm_decoder_t* dec);
+void set_channels(adpcm_decoder_t* dec, uint8_t channels); // not running decoder only
+
+/**
+ * @brief decodes whole adpcm blocks data into s16 frames
+ * @return number of frames written, frame_count at most
+ */
+uint64_t adpcm_decode_buffer_s16(const data_buffer_t& input, uint8_t channels, int16_t* frames_out, uint64_t frame_count);
+decoder_t cast_to_decoder(adpcm_decoder_t* dec);
+
+}
+}
@@ -7,47 +7,35 @@
 
 #include "rt_types.h"
 #include "hlea/runtime.h"
+#include "trace.h"
 
 #include <atomic>
 #include <cassert>
 #include <cstdio>
+#include <algorithm>
 
-#include "jobs_utils.inl"
 #include "alloc_utils.inl"
+#include "ring_indices.inl"
+#include "decode_segment.inl"
 
 namespace hle_audio {
 namespace rt {
 
 static const size_t MAX_INPUT_BUFFERS = 2;
-static const size_t MAX_OUTPUT_BUFFERS = 4;
 
 struct output_buffer_t {
     float pcm[MINIMP3_MAX_SAMPLES_PER_FRAME];
     int frame_offset;
     int frame_count;
     int channels;
+    int sample_rate;
 };
 
 struct input_buffer_t {
     data_buffer_t buffer;
     bool last;
-};
-
-template<typename T, size_t ring_indices_range>
-struct ring_indices {
-    using indices_type = T;
-    static const size_t range_size = ring_indices_range;
-
-    std::atomic<indices_type> read_pos;
-    std::atomic<indices_type> write_pos;
-
-    void reset() {
-        read_pos = write_pos = {};
-    }
-
-    bool can_write() const {
-        return write_pos.load() != indices_type(read_pos.load() + range_size);
-    }
+    bool segment_start;
+    segment_window_t segment;
 };
 
 // ~10 mp3 frames
@@ -56,7 +44,7 @@ static const size_t MIN_DATA_CHUNK_SIZE = 16384;
 struct mp3_decoder_t {
     // todo: consider moving these upper level refs to specific function context parameters
     allocator_t allocator;
-    jobs_t jobs_sys;
+    decode_scheduler_t* scheduler;
 
     input_buffer_t inputs[MAX_INPUT_BUFFERS];
     uint8_t input_count;
@@ -64,51 +52,73 @@ struct mp3_decoder_t {
 
     bool reset_state;
 
+    bool segment_pending;
+    segment_window_t pending_segment;
+
     struct job_state_t {
         mp3dec_t mp3d;
 
         input_buffer_t input;
         bool not_enough_input_data;
 
+        segment_window_t segment;
+
         uint8_t aux_input_buf[MIN_DATA_CHUNK_SIZE];
         size_t aux_input_size;
         data_buffer_t aux_input;
 
-        output_buffer_t outputs[MAX_OUTPUT_BUFFERS];
-        ring_indices<uint8_t, MAX_OUTPUT_BUFFERS> output_indices;
+        output_buffer_t* outputs;
+        ring_indices<uint8_t> output_indices;
         std::atomic<bool> running;
         std::atomic<bool> stop_requested;
     } job_state;
 };
 
+static void init_job_state(mp3_decoder_t::job_state_t* state, output_buffer_t* outputs, uint8_t output_count) {
+    state->outputs = outputs;
+    state->output_indices.init(output_count);
+
+    mp3dec_init(&state->mp3d);
+    state->segment = unlimited_segment_window();
+}
+
 mp3_decoder_t* create_decoder(const mp3_decoder_create_info_t& info) {
     auto dec = allocate<mp3_decoder_t>(info.allocator);
     new(dec) mp3_decoder_t(); // init c++ stuff
     dec->allocator = info.allocator;
-    dec->jobs_sys = info.jobs;
+    dec->scheduler = info.scheduler;
+
+    uint8_t output_count = info.output_buffer_count ? info.output_buffer_count : DEFAULT_MP3_OUTPUT_BUFFERS;
+    auto outputs = (output_buffer_t*)allocate(info.allocator, output_count * sizeof(output_buffer_t), alignof(output_buffer_t));
+    init_job_state(&dec->job_state, outputs, output_count);
 
-    mp3dec_init(&dec->job_state.mp3d);
+    register_task(dec->scheduler, cast_to_decode_task(dec));
     
     return dec;
 }
 
 void destroy(mp3_decoder_t* dec) {
+    unregister_task(dec->scheduler, dec);
+    deallocate(dec->allocator, dec->job_state.outputs);
+
     dec->~mp3_decoder_t();
     deallocate(dec->allocator, dec);
 }
 
 void reset(mp3_decoder_t* dec) {
     auto alloc = dec->allocator;
-    auto jobs = dec->jobs_sys;
+    auto scheduler = dec->scheduler;
+    auto outputs = dec->job_state.outputs;
+    auto output_count = dec->job_state.output_indices.range_size;
 
     // destroy + create witout allocation
     // todo: fix duplication | use destroy -> create_decoder on upper level, too heavy?
     dec->~mp3_decoder_t();
     new(dec) mp3_decoder_t(); // init c++ stuff
     dec->allocator = alloc;
-    dec->jobs_sys = jobs;
+    dec->scheduler = scheduler;
 
-    mp3dec_init(&dec->job_state.mp3d);
+    init_job_state(&dec->job_state, outputs, output_count);
 }
 
 //---------------------------------------------------------------------------------------
@@ -127,7 +137,17 @@ static void consume_rest_input(mp3_decoder_t::job_state_t* state) {
     state->not_enough_input_data = true;
 }
 
+static void drop_rest_input(mp3_decoder_t::job_state_t* state) {
+    state->aux_input_size = 0;
+    state->aux_input = {};
+
+    state->input = {};
+    state->not_enough_input_data = true;
+}
+
 static void decode_mp3(mp3_decoder_t::job_state_t* state) {
+    HLEA_TRACE_SCOPE("decode_mp3");
+
     /*
         todo: check if input is less than MIN_DATA_CHUNK_SIZE;
 
@@ -154,7 +174,13 @@ static void decode_mp3(mp3_decoder_t::job_state_t* state) {
         }
     }
     
-    while(state->output_indices.can_write()) {
+    while(state->output_indices.can_write() && !state->stop_requested) {
+
+        // the rest of segment inputs is not decoded
+        if (is_complete(state->segment)) {
+            drop_rest_input(state);
+            break;
+        }
 
         if (is_empty(state->input.buffer)) {
             consume_rest_input(state);
@@ -164,17 +190,18 @@ static void decode_mp3(mp3_decoder_t::job_state_t* state) {
         auto input_ptr = state->aux_input.data ? &state->aux_input : &state->input.buffer;
 
         auto wp = state->output_indices.write_pos.load();
-        auto& output = state->outputs[wp & (MAX_OUTPUT_BUFFERS - 1)];
+        auto& output = state->outputs[state->output_indices.index(wp)];
 
         mp3dec_frame_info_t info;
         output.frame_offset = 0;
         output.frame_count = mp3dec_decode_frame(&state->mp3d, input_ptr->data, input_ptr->size, output.pcm, &info);
         output.channels = info.channels;
+        output.sample_rate = info.hz;
 
-        // Insufficient data
-        assert(output.frame_count);
+        // no frames left (e.g. trailing tags), skip the rest
+        auto processed_bytes = info.frame_bytes ? info.frame_bytes : input_ptr->size;
 
-        *input_ptr = advance(*input_ptr, info.frame_bytes);
+        *input_ptr = advance(*input_ptr, processed_bytes);
         if (state->aux_input.data) {
             auto aux_processed_bytes = state->aux_input.data - state->aux_input_buf;
             // use current input when processed aux buffer from previous input
@@ -188,7 +215,12 @@ static void decode_mp3(mp3_decoder_t::job_state_t* state) {
             }
         }
 
-        state->output_indices.write_pos.store(++wp);
+        trim_frames(state->segment, &output.frame_offset, &output.frame_count);
+
+        // frames without bit reservoir data (first frames after seek) have no output
+        if (output.frame_offset < output.frame_count) {
+            state->output_indices.write_pos.store(++wp);
+        }
 
         // consume input if less than 5 mp3 frames data left
         if (is_empty(state->input.buffer) ||
@@ -203,16 +235,12 @@ static void decode_mp3(mp3_decoder_t::job_state_t* state) {
     state->running = false;
 }
 
-static void decode_mp3_jobfunc(void* udata) {
-    auto state = (mp3_decoder_t::job_state_t*)udata;
-    decode_mp3(state);
-}
-
 // job
 //---------------------------------------------------------------------------------------
 
 static size_t release_consumed_inputs(mp3_decoder_t* dec) {
-    if (!dec->job_state.running) {
+    // inputs consumed before flush are dropped already
+    if (!dec->job_state.running && !dec->reset_state) {
         if (dec->job_state.not_enough_input_data) {
             dec->job_state.not_enough_input_data = false;
 
@@ -244,44 +272,74 @@ static void reset_inputs(mp3_decoder_t::job_state_t* state) {
     state->aux_input = {};
 
     state->not_enough_input_data = false;
+    state->stop_requested = false;
 
     mp3dec_init(&state->mp3d);
+    state->segment = unlimited_segment_window();
 }
 
-static void kick_decoding_job(mp3_decoder_t* dec) {
+static void start_input_segment(mp3_decoder_t::job_state_t* state) {
+    state->aux_input_size = 0;
+    state->aux_input = {};
+
+    mp3dec_init(&state->mp3d);
+    state->segment = state->input.segment;
+}
+
+static void apply_pending_reset(mp3_decoder_t* dec) {
     if (dec->job_state.running) return;
 
     if (dec->reset_state) {
         dec->reset_state = false;
         reset_inputs(&dec->job_state);
     }
+}
+
+/**
+ * @brief prepares decoding job input, decoding is launched by scheduler in batch with other decoders
+ */
+static bool begin_decoding_step(mp3_decoder_t* dec) {
+    if (dec->job_state.running) return false;
+
+    apply_pending_reset(dec);
 
     if (dec->job_state.not_enough_input_data) {
         // wait till release_consumed_inputs
         // todo: ?consume here?
-        return;
+        return false;
     }
 
     // do not launch if has no input
     bool has_inputs = dec->consumed_input_count < dec->input_count;
-    if (!has_inputs) return;
+    if (!has_inputs) return false;
 
     // or outputs
-    if (!dec->job_state.output_indices.can_write()) return;
+    if (!dec->job_state.output_indices.can_write()) return false;
 
     if (is_empty(dec->job_state.input.buffer)) {
         dec->job_state.input = dec->inputs[dec->consumed_input_count];
+        if (dec->job_state.input.segment_start) start_input_segment(&dec->job_state);
     }
 
     assert(dec->job_state.input.buffer.size);
 
-    // launch decoder job
     dec->job_state.running = true;
+    return true;
+}
 
-    hlea_job_t job  = {};
-    job.job_func = decode_mp3_jobfunc;
-    job.udata = &dec->job_state;
-    launch(dec->jobs_sys, job);
+static uint32_t buffered_time_ms(const mp3_decoder_t* dec) {
+    // outputs are dropped on reset
+    if (dec->reset_state) return 0;
+
+    auto& indices = dec->job_state.output_indices;
+    auto wp = indices.write_pos.load();
+
+    uint32_t res = 0;
+    for (auto pos = indices.read_pos.load(); pos != wp; ++pos) {
+        auto& output = dec->job_state.outputs[indices.index(pos)];
+        res += uint32_t((output.frame_count - output.frame_offset) * 1000 / output.sample_rate);
+    }
+    return res;
 }
 
 static bool queue_input(mp3_decoder_t* state, const data_buffer_t& buf, bool last_input) {
@@ -291,10 +349,11 @@ static bool queue_input(mp3_decoder_t* state, const data_buffer_t& buf, bool las
     input_buffer_t input = {};
     input.buffer = buf;
     input.last = last_input;
+    input.segment_start = state->segment_pending;
+    input.segment = state->pending_segment;
     state->inputs[state->input_count++] = input;
 
-    // launch job 
-    kick_decoding_job(state);
+    state->segment_pending = false;
 
     return true;
 }
@@ -307,14 +366,10 @@ static bool contains(const output_buffer_t& out_buf, const void* ptr) {
 static void release_output(mp3_decoder_t* dec, data_buffer_t output_buf) {
     if (output_buf.size) {
         auto rp = dec->job_state.output_indices.read_pos.load();
-        assert(contains(dec->job_state.outputs[(rp & MAX_OUTPUT_BUFFERS - 1)], output_buf.data));
+        assert(contains(dec->job_state.outputs[dec->job_state.output_indices.index(rp)], output_buf.data));
         
+        // vacant output buffer is decoded into with the next scheduled batch
         dec->job_state.output_indices.read_pos.store(++rp);
-
-        // we now have one vacant output buffer to decode into
-        // todo: here it is possible to get into condition where job is almost finished, but running flag is still true
-        // launch decoding job
-        kick_decoding_job(dec);
     }
 }
 
@@ -330,7 +385,11 @@ static data_buffer_t get_frames_output_buffer(const output_buffer_t& output) {
 }
 
 static data_buffer_t next_output(mp3_decoder_t* dec, const data_buffer_t& current_buf) {
-    
+    // outputs decoded before flush are dropped
+    if (dec->reset_state) {
+        apply_pending_reset(dec);
+        if (dec->reset_state) return {};
+    }
 
     // release previous buffer
     release_output(dec, current_buf);
@@ -343,7 +402,7 @@ static data_buffer_t next_output(mp3_decoder_t* dec, const data_buffer_t& curren
         return {};
     }
 
-    uint8_t read_buf_index = rp & (MAX_OUTPUT_BUFFERS - 1);
+    uint8_t read_buf_index = dec->job_state.output_indices.index(rp);
 
     return get_frames_output_buffer(dec->job_state.outputs[read_buf_index]);
 }
@@ -353,12 +412,22 @@ static bool is_running(const mp3_decoder_t* dec) {
 }
 
 static void flush(mp3_decoder_t* dec) {
+    dec->consumed_input_count = 0;
+    dec->input_count = 0;
+    dec->segment_pending = false;
+
     if (dec->job_state.running) {
+        // reset when the job is finished
         dec->job_state.stop_requested = true;
+        dec->reset_state = true;
+    } else {
+        reset_inputs(&dec->job_state);
     }
-    dec->reset_state = true;
-    dec->consumed_input_count = 0;
-    dec->input_count = 0;
+}
+
+static void start_segment(mp3_decoder_t* dec, uint64_t skip_frames, uint64_t max_frames) {
+    dec->segment_pending = true;
+    dec->pending_segment = make_segment_window(skip_frames, max_frames);
 }
 
 //
@@ -390,6 +459,11 @@ static void mp3dec_flush(void* state) {
     flush(dec);
 }
 
+static void mp3dec_start_segment(void* state, uint64_t skip_frames, uint64_t max_frames) {
+    auto dec = (mp3_decoder_t*)state;
+    start_segment(dec, skip_frames, max_frames);
+}
+
 static void mp3dec_destroy(void* state) {
     auto dec = (mp3_decoder_t*)state;
     destroy(dec);
@@ -402,11 +476,47 @@ static const decoder_ti g_mp3_decoder_vt = []() {
     vt.next_output = mp3dec_next_output;
     vt.is_running = mp3dec_is_running;
     vt.flush = mp3dec_flush;
+    vt.start_segment = mp3dec_start_segment;
     vt.destroy = mp3dec_destroy;
 
     return vt;
 }();
 
+//
+// decode_task_ti vtable
+//
+
+static uint32_t mp3dec_buffered_time_ms(void* state) {
+    auto dec = (mp3_decoder_t*)state;
+    return buffered_time_ms(dec);
+}
+
+static bool mp3dec_begin_step(void* state) {
+    auto dec = (mp3_decoder_t*)state;
+    return begin_decoding_step(dec);
+}
+
+static void mp3dec_run_step(void* state) {
+    auto dec = (mp3_decoder_t*)state;
+    decode_mp3(&dec->job_state);
+}
+
+static const decode_task_ti g_mp3_decode_task_vt = []() {
+    decode_task_ti vt = {};
+    vt.buffered_time_ms = mp3dec_buffered_time_ms;
+    vt.begin_step = mp3dec_begin_step;
+    vt.run_step = mp3dec_run_step;
+
+    return vt;
+}();
+
+decode_task_t cast_to_decode_task(mp3_decoder_t* dec) {
+    decode_task_t res = {};
+    res.vt = &g_mp3_decode_task_vt;
+    res.state = dec;
+    return res;
+}
+
 decoder_t cast_to_decoder(mp3_decoder_t* dec) {
     decoder_t res = {};
     res.vt = &g_mp3_decoder_vt;
@@ -414,5 +524,31 @@ decoder_t cast_to_decoder(mp3_decoder_t* dec) {
     return res;
 }
 
+uint64_t mp3_decode_buffer_s16(const data_buffer_t& input, uint8_t channels, int16_t* frames_out, uint64_t frame_count) {
+    mp3dec_t mp3d;
+    mp3dec_init(&mp3d);
+
+    float pcm[MINIMP3_MAX_SAMPLES_PER_FRAME];
+
+    uint64_t frames_written = 0;
+    auto rest = input;
+    while (!is_empty(rest) && frames_written < frame_count) {
+        mp3dec_frame_info_t info;
+        int frames = mp3dec_decode_frame(&mp3d, rest.data, int(rest.size), pcm, &info);
+
+        // no frames left (e.g. trailing tags)
+        if (!info.frame_bytes) break;
+        rest = advance(rest, info.frame_bytes);
+
+        if (!frames || info.channels != channels) continue;
+
+        auto frames_to_write = std::min(uint64_t(frames), frame_count - frames_written);
+        mp3dec_f32_to_s16(pcm, frames_out + frames_written * channels, int(frames_to_write * channels));
+        frames_written += frames_to_write;
+    }
+
+    return frames_written;
+}
+
 }
 }
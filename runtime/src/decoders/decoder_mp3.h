@@ -2,16 +2,21 @@
 
 #include "decoder.h"
 #include "internal_alloc_types.h"
-#include "internal_jobs_types.h"
+#include "decode_scheduler.h"
 
 namespace hle_audio {
 namespace rt {
 
 struct mp3_decoder_t;
 
+static const uint8_t DEFAULT_MP3_OUTPUT_BUFFERS = 4;
+
 struct mp3_decoder_create_info_t {
     allocator_t allocator;
-    jobs_t jobs;
+    decode_scheduler_t* scheduler;
+
+    // decoded frames ring depth, power of 2 (0 - default)
+    uint8_t output_buffer_count;
 };
 
 mp3_decoder_t* create_decoder(const mp3_decoder_create_info_t& info);
@@ -20,5 +25,14 @@ void destroy(mp3_decoder_t* dec);
 void reset(mp3_decoder_t* dec);
 decoder_t cast_to_decoder(mp3_decoder_t* dec);
 
+// registered in scheduler on create
+decode_task_t cast_to_decode_task(mp3_decoder_t* dec);
+
+/**
+ * @brief decodes whole mp3 data synchronously (e.g. on job thread) into s16 frames
+ * @return number of frames written, frame_count at most
+ */
+uint64_t mp3_decode_buffer_s16(const data_buffer_t& input, uint8_t channels, int16_t* frames_out, uint64_t frame_count);
+
 }
 }
@@ -1,37 +1,51 @@
 #include "decoder_pcm.h"
 
 #include "alloc_utils.inl"
+#include "decode_segment.inl"
 
 namespace hle_audio {
 namespace rt {
 
 /**
- * @brief pcm decoder
- * todo:
- *  - support streaming data source (multiple inputs)
+ * @brief pcm (s16) decoder, inputs are output as is, trimmed to the segment window
  */
 
 static const size_t MAX_INPUT_BUFFERS = 2;
 
+struct input_buffer_t {
+    data_buffer_t buffer;
+    bool segment_start;
+    segment_window_t segment;
+};
+
 struct pcm_decoder_t {
     allocator_t allocator;
+    size_t frame_size;
 
-    data_buffer_t inputs[MAX_INPUT_BUFFERS];
+    input_buffer_t inputs[MAX_INPUT_BUFFERS];
     uint8_t input_count;
     uint8_t consumed_input_count;
-};
 
-using hle_audio::rt::data_buffer_t;
+    data_buffer_t output; // trimmed inputs[consumed_input_count]
+    segment_window_t segment;
 
-static const data_buffer_t empty_data_buffer = {};
+    bool segment_pending;
+    segment_window_t pending_segment;
+};
 
 pcm_decoder_t* create_decoder(const pcm_decoder_create_info_t& info) {
     auto dec = allocate<pcm_decoder_t>(info.allocator);
     *dec = {};
     dec->allocator = info.allocator;
+    dec->segment = unlimited_segment_window();
+    set_channels(dec, info.channels);
     return dec;
 }
 
+void set_channels(pcm_decoder_t* dec, uint8_t channels) {
+    dec->frame_size = (channels ? channels : 1) * sizeof(int16_t);
+}
+
 void destroy(pcm_decoder_t* dec) {
     deallocate(dec->allocator, dec);
 }
@@ -39,6 +53,9 @@ void destroy(pcm_decoder_t* dec) {
 void reset(pcm_decoder_t* dec) {
     dec->input_count = 0;
     dec->consumed_input_count = 0;
+    dec->output = {};
+    dec->segment = unlimited_segment_window();
+    dec->segment_pending = false;
 }
 
 static size_t release_consumed_inputs(pcm_decoder_t* dec) {
@@ -59,7 +76,13 @@ static bool queue_input(pcm_decoder_t* dec, const data_buffer_t& buf, bool last_
     // should not be the case ever, ?assert?
     if (dec->input_count == MAX_INPUT_BUFFERS) return false;
 
-    dec->inputs[dec->input_count++] = buf;
+    input_buffer_t input = {};
+    input.buffer = buf;
+    input.segment_start = dec->segment_pending;
+    input.segment = dec->pending_segment;
+    dec->inputs[dec->input_count++] = input;
+
+    dec->segment_pending = false;
 
     return true;
 }
@@ -68,9 +91,10 @@ static void release_output(pcm_decoder_t* dec, data_buffer_t output_buf) {
     if (!output_buf.size) return;
 
     assert(dec->input_count);
-    assert(dec->inputs[dec->consumed_input_count].data == output_buf.data);
-    assert(dec->inputs[dec->consumed_input_count].size == output_buf.size);
+    assert(dec->output.data == output_buf.data);
+    assert(dec->output.size == output_buf.size);
 
+    dec->output = {};
     ++dec->consumed_input_count;
 }
 
@@ -78,12 +102,34 @@ static data_buffer_t next_output(pcm_decoder_t* dec, const data_buffer_t& output
     // release previous buffer
     release_output(dec, output_buf);
 
-    return dec->consumed_input_count < dec->input_count ? dec->inputs[dec->consumed_input_count] : empty_data_buffer;
+    while (is_empty(dec->output) && dec->consumed_input_count < dec->input_count) {
+        auto& input = dec->inputs[dec->consumed_input_count];
+        if (input.segment_start) {
+            input.segment_start = false;
+            dec->segment = input.segment;
+        }
+
+        int frame_offset = 0;
+        int frame_count = int(input.buffer.size / dec->frame_size);
+        trim_frames(dec->segment, &frame_offset, &frame_count);
+
+        dec->output.data = input.buffer.data + frame_offset * dec->frame_size;
+        dec->output.size = (frame_count - frame_offset) * dec->frame_size;
+
+        // the whole input is out of the segment window
+        if (is_empty(dec->output)) ++dec->consumed_input_count;
+    }
+
+    return dec->output;
 }
 
 static void flush(pcm_decoder_t* dec) {
-    dec->consumed_input_count = 0;
-    dec->input_count = 0;
+    reset(dec);
+}
+
+static void start_segment(pcm_decoder_t* dec, uint64_t skip_frames, uint64_t max_frames) {
+    dec->segment_pending = true;
+    dec->pending_segment = make_segment_window(skip_frames, max_frames);
 }
 
 
@@ -116,6 +162,11 @@ static void pcm_dec_flush(void* state) {
     flush(dec);
 }
 
+static void pcm_dec_start_segment(void* state, uint64_t skip_frames, uint64_t max_frames) {
+    auto dec = (pcm_decoder_t*)state;
+    start_segment(dec, skip_frames, max_frames);
+}
+
 static void pcm_dec_destroy(void* state) {
     auto dec = (pcm_decoder_t*)state;
     destroy(dec);
@@ -128,6 +179,7 @@ static const decoder_ti g_wav_decoder_vt = []() {
     vt.next_output = pcm_dec_next_output;
     vt.is_running = pcm_dec_is_running;
     vt.flush = pcm_dec_flush;
+    vt.start_segment = pcm_dec_start_segment;
     vt.destroy = pcm_dec_destroy;
 
     return vt;
@@ -10,12 +10,14 @@ struct pcm_decoder_t;
 
 struct pcm_decoder_create_info_t {
     allocator_t allocator;
+    uint8_t channels;
 };
 
 pcm_decoder_t* create_decoder(const pcm_decoder_create_info_t& info);
 void destroy(pcm_decoder_t* dec);
 
 void reset(pcm_decoder_t* dec);
+void set_channels(pcm_decoder_t* dec, uint8_t channels); // not running decoder only
 decoder_t cast_to_decoder(pcm_decoder_t* dec);
 
 }
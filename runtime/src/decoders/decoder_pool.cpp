@@ -0,0 +1,171 @@
+#include "decoder_pool.h"
+
+#include <cassert>
+
+#include "decoder_mp3.h"
+#include "decoder_vorbis.h"
+#include "decoder_pcm.h"
+#include "decoder_adpcm.h"
+
+#include "alloc_utils.inl"
+
+namespace hle_audio {
+namespace rt {
+
+/**
+ * @brief released decoders per format, stack fits all decoders of the format in use
+ */
+struct format_pool_t {
+    decoder_t* free_decoders;
+    uint16_t free_count;
+};
+
+struct decoder_pool_t {
+    allocator_t allocator;
+    decode_scheduler_t* scheduler;
+
+    uint8_t mp3_output_buffer_count;
+    uint8_t vorbis_output_buffer_count;
+
+    format_pool_t formats[DECODER_FORMAT_COUNT];
+};
+
+static decoder_t create_format_decoder(decoder_pool_t* pool, audio_format_type_e format, uint8_t channels) {
+    switch (format) {
+    case audio_format_type_e::mp3: {
+        mp3_decoder_create_info_t info = {};
+        info.allocator = pool->allocator;
+        info.scheduler = pool->scheduler;
+        info.output_buffer_count = pool->mp3_output_buffer_count;
+        return cast_to_decoder(create_decoder(info));
+    }
+    case audio_format_type_e::vorbis: {
+        vorbis_decoder_create_info_t info = {};
+        info.allocator = pool->allocator;
+        info.scheduler = pool->scheduler;
+        info.output_buffer_count = pool->vorbis_output_buffer_count;
+        return cast_to_decoder(create_decoder(info));
+    }
+    case audio_format_type_e::pcm: {
+        pcm_decoder_create_info_t info = {};
+        info.allocator = pool->allocator;
+        info.channels = channels;
+        return cast_to_decoder(create_decoder(info));
+    }
+    case audio_format_type_e::adpcm: {
+        adpcm_decoder_create_info_t info = {};
+        info.allocator = pool->allocator;
+        info.channels = channels;
+        return cast_to_decoder(create_decoder(info));
+    }
+    default:
+        assert(false && "not supported format");
+        break;
+    }
+    return {};
+}
+
+/**
+ * @brief pooled decoders are idle, they aren't scheduled for decoding
+ */
+static void reset_for_pool(decoder_pool_t* pool, audio_format_type_e format, const decoder_t& decoder) {
+    switch (format) {
+    case audio_format_type_e::mp3:
+        unregister_task(pool->scheduler, decoder.state);
+        reset((mp3_decoder_t*)decoder.state);
+        break;
+    case audio_format_type_e::vorbis:
+        unregister_task(pool->scheduler, decoder.state);
+        reset((vorbis_decoder_t*)decoder.state);
+        break;
+    case audio_format_type_e::pcm:
+        reset((pcm_decoder_t*)decoder.state);
+        break;
+    case audio_format_type_e::adpcm:
+        reset((adpcm_decoder_t*)decoder.state);
+        break;
+    default:
+        break;
+    }
+}
+
+static void reuse_pooled(decoder_pool_t* pool, audio_format_type_e format, const decoder_t& decoder, uint8_t channels) {
+    switch (format) {
+    case audio_format_type_e::mp3:
+        register_task(pool->scheduler, cast_to_decode_task((mp3_decoder_t*)decoder.state));
+        break;
+    case audio_format_type_e::vorbis:
+        register_task(pool->scheduler, cast_to_decode_task((vorbis_decoder_t*)decoder.state));
+        break;
+    case audio_format_type_e::pcm:
+        set_channels((pcm_decoder_t*)decoder.state, channels);
+        break;
+    case audio_format_type_e::adpcm:
+        set_channels((adpcm_decoder_t*)decoder.state, channels);
+        break;
+    default:
+        break;
+    }
+}
+
+decoder_pool_t* create_decoder_pool(const decoder_pool_create_info_t& info) {
+    auto pool = allocate<decoder_pool_t>(info.allocator);
+    *pool = {};
+    pool->allocator = info.allocator;
+    pool->scheduler = info.scheduler;
+    pool->mp3_output_buffer_count = info.mp3_output_buffer_count;
+    pool->vorbis_output_buffer_count = info.vorbis_output_buffer_count;
+
+    for (uint8_t i = 0; i < DECODER_FORMAT_COUNT; ++i) {
+        auto format = audio_format_type_e(i);
+        auto& format_pool = pool->formats[i];
+
+        if (format == audio_format_type_e::none) continue;
+
+        format_pool.free_decoders = (decoder_t*)allocate(info.allocator,
+            MAX_POOLED_DECODERS * sizeof(decoder_t), alignof(decoder_t));
+
+        // fill upfront, so the first acquires don't allocate
+        auto pool_size = info.pool_sizes[i] < MAX_POOLED_DECODERS ? info.pool_sizes[i] : MAX_POOLED_DECODERS;
+        for (uint16_t j = 0; j < pool_size; ++j) {
+            auto decoder = create_format_decoder(pool, format, 1);
+            reset_for_pool(pool, format, decoder);
+            format_pool.free_decoders[format_pool.free_count++] = decoder;
+        }
+    }
+
+    return pool;
+}
+
+void destroy(decoder_pool_t* pool) {
+    for (auto& format_pool : pool->formats) {
+        for (uint16_t i = 0; i < format_pool.free_count; ++i) {
+            destroy(format_pool.free_decoders[i]);
+        }
+        if (format_pool.free_decoders) deallocate(pool->allocator, format_pool.free_decoders);
+    }
+
+    deallocate(pool->allocator, pool);
+}
+
+decoder_t acquire_decoder(decoder_pool_t* pool, audio_format_type_e format, uint8_t channels) {
+    auto& format_pool = pool->formats[uint8_t(format)];
+    if (!format_pool.free_count) return create_format_decoder(pool, format, channels);
+
+    auto decoder = format_pool.free_decoders[--format_pool.free_count];
+    reuse_pooled(pool, format, decoder, channels);
+    return decoder;
+}
+
+void release_decoder(decoder_pool_t* pool, audio_format_type_e format, decoder_t decoder) {
+    assert(!is_running(decoder));
+
+    auto& format_pool = pool->formats[uint8_t(format)];
+    assert(format_pool.free_count < MAX_POOLED_DECODERS);
+
+    reset_for_pool(pool, format, decoder);
+    format_pool.free_decoders[format_pool.free_count++] = decoder;
+}
+
+}
+}
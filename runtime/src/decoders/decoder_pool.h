@@ -0,0 +1,44 @@
+#pragma once
+
+#include "decoder.h"
+#include "internal_alloc_types.h"
+#include "decode_scheduler.h"
+#include "rt_types.h"
+
+namespace hle_audio {
+namespace rt {
+
+static const uint8_t DECODER_FORMAT_COUNT = uint8_t(audio_format_type_e::adpcm) + 1;
+
+// a decoder per sound at most
+static const uint16_t MAX_POOLED_DECODERS = 1024; // MAX_SOUNDS
+
+struct decoder_pool_create_info_t {
+    allocator_t allocator;
+    decode_scheduler_t* scheduler;
+
+    uint8_t mp3_output_buffer_count;
+    uint8_t vorbis_output_buffer_count;
+
+    // decoders created upfront, per audio_format_type_e
+    uint16_t pool_sizes[DECODER_FORMAT_COUNT];
+};
+
+struct decoder_pool_t;
+
+decoder_pool_t* create_decoder_pool(const decoder_pool_create_info_t& info);
+void destroy(decoder_pool_t* pool);
+
+/**
+ * @brief reuses released decoder of the format, new one is created if pool is empty,
+ *  so decoders are allocated only till the pool reaches the high water of decoders in use
+ */
+decoder_t acquire_decoder(decoder_pool_t* pool, audio_format_type_e format, uint8_t channels);
+
+/**
+ * @brief decoder is expected to be not running, it's reset and kept for reuse (till pool is destroyed)
+ */
+void release_decoder(decoder_pool_t* pool, audio_format_type_e format, decoder_t decoder);
+
+}
+}
@@ -0,0 +1,687 @@
+#include "decoder_vorbis.h"
+
+// implementation is compiled in rt_libs
+#define STB_VORBIS_HEADER_ONLY
+#include "stb_vorbis.c"
+
+#include "rt_types.h"
+#include "hlea/runtime.h"
+#include "trace.h"
+
+#include <atomic>
+#include <cassert>
+#include <algorithm>
+
+#include "alloc_utils.inl"
+#include "ring_indices.inl"
+#include "decode_segment.inl"
+
+namespace hle_audio {
+namespace rt {
+
+/**
+ * @brief push mode ogg vorbis decoder (stb_vorbis pushdata api), same design as mp3_decoder_t:
+ *  inputs queue -> decoding step (batched by decode_scheduler_t) -> outputs ring
+ *
+ * stb_vorbis expects the whole packet in a single data block, so packets crossing
+ * input buffers boundary are decoded from aux buffer (rest of previous input + head of next one)
+ */
+
+static const size_t MAX_INPUT_BUFFERS = 2;
+
+static const int MAX_VORBIS_CHANNELS = 2;
+static const int OUTPUT_BUFFER_FRAMES = 1024; // typical long block output
+
+// stb_vorbis setup + temp memory, ~150KB max usage reported for stb test files
+static const size_t VORBIS_ALLOC_BUFFER_SIZE = 256 * 1024;
+
+// libvorbis pages are ~4-8KB, keep enough room for the packet crossing inputs boundary
+static const size_t AUX_INPUT_BUF_SIZE = 32768;
+
+struct output_buffer_t {
+    float pcm[OUTPUT_BUFFER_FRAMES * MAX_VORBIS_CHANNELS];
+    int frame_offset;
+    int frame_count;
+    int channels;
+    int sample_rate;
+};
+
+struct input_buffer_t {
+    data_buffer_t buffer;
+    bool last;
+    bool segment_start;
+    segment_window_t segment;
+};
+
+struct vorbis_decoder_t {
+    allocator_t allocator;
+    decode_scheduler_t* scheduler;
+
+    input_buffer_t inputs[MAX_INPUT_BUFFERS];
+    uint8_t input_count;
+    uint8_t consumed_input_count;
+
+    bool reset_state;
+
+    bool segment_pending;
+    segment_window_t pending_segment;
+
+    struct job_state_t {
+        stb_vorbis* vorbis;
+        stb_vorbis_alloc vorbis_alloc;
+        int sample_rate;
+        bool stream_failed;
+
+        input_buffer_t input;
+        bool not_enough_input_data;
+
+        segment_window_t segment;
+
+        uint8_t aux_input_buf[AUX_INPUT_BUF_SIZE];
+        size_t aux_input_size; // rest of the previous input at aux_input_buf start
+        data_buffer_t aux_input;
+
+        // decoded packet frames not yet copied into outputs (owned by stb_vorbis till the next decode call)
+        float** packet_pcm;
+        int packet_channels;
+        int packet_frame_offset;
+        int packet_frame_count;
+
+        output_buffer_t* outputs;
+        ring_indices<uint8_t> output_indices;
+        std::atomic<bool> running;
+        std::atomic<bool> stop_requested;
+    } job_state;
+};
+
+static void init_job_state(vorbis_decoder_t* dec, char* alloc_buffer, output_buffer_t* outputs, uint8_t output_count) {
+    dec->job_state.vorbis_alloc.alloc_buffer = alloc_buffer;
+    dec->job_state.vorbis_alloc.alloc_buffer_length_in_bytes = VORBIS_ALLOC_BUFFER_SIZE;
+    dec->job_state.segment = unlimited_segment_window();
+
+    dec->job_state.outputs = outputs;
+    dec->job_state.output_indices.init(output_count);
+}
+
+vorbis_decoder_t* create_decoder(const vorbis_decoder_create_info_t& info) {
+    auto dec = allocate<vorbis_decoder_t>(info.allocator);
+    new(dec) vorbis_decoder_t(); // init c++ stuff
+    dec->allocator = info.allocator;
+    dec->scheduler = info.scheduler;
+
+    uint8_t output_count = info.output_buffer_count ? info.output_buffer_count : DEFAULT_VORBIS_OUTPUT_BUFFERS;
+    auto outputs = (output_buffer_t*)allocate(info.allocator, output_count * sizeof(output_buffer_t), alignof(output_buffer_t));
+
+    // stb_vorbis allocates everything from this buffer, so no allocations happen on job threads
+    init_job_state(dec, (char*)allocate(info.allocator, VORBIS_ALLOC_BUFFER_SIZE), outputs, output_count);
+
+    register_task(dec->scheduler, cast_to_decode_task(dec));
+
+    return dec;
+}
+
+static void close_vorbis(vorbis_decoder_t::job_state_t* state) {
+    if (state->vorbis) {
+        // doesn't free anything with user alloc buffer
+        stb_vorbis_close(state->vorbis);
+        state->vorbis = nullptr;
+    }
+}
+
+void destroy(vorbis_decoder_t* dec) {
+    unregister_task(dec->scheduler, dec);
+
+    close_vorbis(&dec->job_state);
+    deallocate(dec->allocator, dec->job_state.vorbis_alloc.alloc_buffer);
+    deallocate(dec->allocator, dec->job_state.outputs);
+
+    dec->~vorbis_decoder_t();
+    deallocate(dec->allocator, dec);
+}
+
+void reset(vorbis_decoder_t* dec) {
+    auto alloc = dec->allocator;
+    auto scheduler = dec->scheduler;
+    auto alloc_buffer = dec->job_state.vorbis_alloc.alloc_buffer;
+    auto outputs = dec->job_state.outputs;
+    auto output_count = dec->job_state.output_indices.range_size;
+
+    close_vorbis(&dec->job_state);
+
+    // destroy + create witout allocation
+    dec->~vorbis_decoder_t();
+    new(dec) vorbis_decoder_t(); // init c++ stuff
+    dec->allocator = alloc;
+    dec->scheduler = scheduler;
+
+    init_job_state(dec, alloc_buffer, outputs, output_count);
+}
+
+//---------------------------------------------------------------------------------------
+// job
+
+static void mark_input_consumed(vorbis_decoder_t::job_state_t* state) {
+    state->input = {};
+    state->not_enough_input_data = true;
+}
+
+static void consume_rest_input(vorbis_decoder_t::job_state_t* state) {
+    // keep the rest part of input
+    if (0 < state->input.buffer.size) {
+        if (sizeof(state->aux_input_buf) < state->input.buffer.size) {
+            // packet is too big to be joined with the next input
+            assert(false && "vorbis packet doesn't fit aux buffer");
+            state->stream_failed = true;
+        } else {
+            memcpy(state->aux_input_buf, state->input.buffer.data, state->input.buffer.size);
+            state->aux_input_size = state->input.buffer.size;
+        }
+    }
+
+    mark_input_consumed(state);
+}
+
+static void reset_aux_input(vorbis_decoder_t::job_state_t* state) {
+    state->aux_input_size = 0;
+    state->aux_input = {};
+}
+
+/**
+ * aux input lacks data: keep not processed aux bytes if the whole input is in aux already,
+ * the packet is too big otherwise. Whole last input in aux means trailing bytes only
+ */
+static void consume_aux_input(vorbis_decoder_t::job_state_t* state) {
+    auto appended_size = state->aux_input.data + state->aux_input.size - (state->aux_input_buf + state->aux_input_size);
+    if (appended_size < (ptrdiff_t)state->input.buffer.size) {
+        assert(false && "vorbis packet doesn't fit aux buffer");
+        state->stream_failed = true;
+        reset_aux_input(state);
+        mark_input_consumed(state);
+        return;
+    }
+
+    if (state->input.last) {
+        reset_aux_input(state);
+        mark_input_consumed(state);
+        return;
+    }
+
+    memmove(state->aux_input_buf, state->aux_input.data, state->aux_input.size);
+    state->aux_input_size = state->aux_input.size;
+    state->aux_input = {};
+
+    mark_input_consumed(state);
+}
+
+static void advance_input(vorbis_decoder_t::job_state_t* state, data_buffer_t* input_ptr, size_t amount) {
+    *input_ptr = advance(*input_ptr, amount);
+    if (state->aux_input.data) {
+        size_t aux_processed_bytes = state->aux_input.data - state->aux_input_buf;
+        // use current input when processed aux buffer from previous input
+        if (state->aux_input_size <= aux_processed_bytes) {
+            // advance input with bytes
+            state->input.buffer = advance(state->input.buffer, aux_processed_bytes - state->aux_input_size);
+
+            reset_aux_input(state);
+        }
+    }
+}
+
+/**
+ * interleave decoded packet frames into the next output buffer
+ */
+static void write_packet_output(vorbis_decoder_t::job_state_t* state) {
+    auto wp = state->output_indices.write_pos.load();
+    auto& output = state->outputs[state->output_indices.index(wp)];
+
+    int channels = state->packet_channels;
+    int frame_count = state->packet_frame_count - state->packet_frame_offset;
+    if (OUTPUT_BUFFER_FRAMES < frame_count) frame_count = OUTPUT_BUFFER_FRAMES;
+
+    for (int ch = 0; ch < channels; ++ch) {
+        const float* src = state->packet_pcm[ch] + state->packet_frame_offset;
+        for (int i = 0; i < frame_count; ++i) {
+            output.pcm[i * channels + ch] = src[i];
+        }
+    }
+    output.frame_offset = 0;
+    output.frame_count = frame_count;
+    output.channels = channels;
+    output.sample_rate = state->sample_rate;
+
+    state->packet_frame_offset += frame_count;
+    if (state->packet_frame_offset == state->packet_frame_count) {
+        state->packet_pcm = nullptr;
+        state->packet_frame_offset = state->packet_frame_count = 0;
+    }
+
+    state->output_indices.write_pos.store(++wp);
+}
+
+static void decode_vorbis(vorbis_decoder_t::job_state_t* state) {
+    assert(state->input.buffer.size || state->packet_frame_count);
+
+    // join the rest of previous input with the head of the current one
+    if (state->aux_input_size && !state->aux_input.data) {
+        auto input_moved_to_aux_size = sizeof(state->aux_input_buf) - state->aux_input_size;
+        input_moved_to_aux_size = input_moved_to_aux_size < state->input.buffer.size ? input_moved_to_aux_size : state->input.buffer.size;
+        memcpy(&state->aux_input_buf[state->aux_input_size], state->input.buffer.data, input_moved_to_aux_size);
+
+        data_buffer_t aux_input = {};
+        aux_input.data = state->aux_input_buf;
+        aux_input.size = state->aux_input_size + input_moved_to_aux_size;
+        state->aux_input = aux_input;
+    }
+
+    while(state->output_indices.can_write() && !state->stop_requested) {
+        // finish with previously decoded packet first
+        if (state->packet_frame_count) {
+            write_packet_output(state);
+            continue;
+        }
+
+        // stream failure drops inputs, no more outputs; the same for the rest of segment inputs
+        if (state->stream_failed || is_complete(state->segment)) {
+            reset_aux_input(state);
+            mark_input_consumed(state);
+            break;
+        }
+
+        if (is_empty(state->input.buffer)) {
+            consume_rest_input(state);
+            break;
+        }
+
+        auto input_ptr = state->aux_input.data ? &state->aux_input : &state->input.buffer;
+
+        if (!state->vorbis) {
+            // parse headers
+            int consumed = 0, error = 0;
+            state->vorbis = stb_vorbis_open_pushdata(input_ptr->data, (int)input_ptr->size, &consumed, &error, &state->vorbis_alloc);
+            if (!state->vorbis) {
+                if (error == VORBIS_need_more_data && !state->input.last) {
+                    if (state->aux_input.data) consume_aux_input(state);
+                    else consume_rest_input(state);
+                } else {
+                    assert(false && "couldn't open vorbis stream");
+                    state->stream_failed = true;
+                    reset_aux_input(state);
+                    mark_input_consumed(state);
+                }
+                break;
+            }
+
+            stb_vorbis_info info = stb_vorbis_get_info(state->vorbis);
+            state->sample_rate = int(info.sample_rate);
+            if (MAX_VORBIS_CHANNELS < info.channels) {
+                assert(false && "not supported vorbis channel count");
+                state->stream_failed = true;
+            }
+
+            advance_input(state, input_ptr, consumed);
+            continue;
+        }
+
+        int channels = 0, frames = 0;
+        float** pcm = nullptr;
+        auto used = stb_vorbis_decode_frame_pushdata(state->vorbis, input_ptr->data, (int)input_ptr->size, &channels, &pcm, &frames);
+        if (used == 0 && frames == 0) {
+            // insufficient data
+            if (state->aux_input.data) {
+                consume_aux_input(state);
+            } else if (state->input.last) {
+                // trailing bytes without complete packet, nothing more to decode
+                mark_input_consumed(state);
+            } else {
+                consume_rest_input(state);
+            }
+            break;
+        }
+
+        advance_input(state, input_ptr, used);
+
+        int frame_offset = 0;
+        trim_frames(state->segment, &frame_offset, &frames);
+        if (frame_offset < frames) {
+            state->packet_pcm = pcm;
+            state->packet_channels = channels;
+            state->packet_frame_offset = frame_offset;
+            state->packet_frame_count = frames;
+        }
+
+        // consume input if it is small enough to be joined with next input
+        if (!state->aux_input.data && !state->packet_frame_count &&
+            (is_empty(state->input.buffer) ||
+            (!state->input.last && (state->input.buffer.size < AUX_INPUT_BUF_SIZE / 2)))) {
+
+            consume_rest_input(state);
+            break;
+        }
+    }
+
+    // we could've been here when out_read_pos is increased from the poll thread (output_indices.read_pos.store++)
+    state->running = false;
+}
+
+// job
+//---------------------------------------------------------------------------------------
+
+static size_t release_consumed_inputs(vorbis_decoder_t* dec) {
+    // inputs consumed before flush are dropped already
+    if (!dec->job_state.running && !dec->reset_state) {
+        if (dec->job_state.not_enough_input_data) {
+            dec->job_state.not_enough_input_data = false;
+
+            ++dec->consumed_input_count;
+            assert(dec->input_count);
+        }
+    }
+
+    auto consumed_input_count = dec->consumed_input_count;
+
+    if (consumed_input_count) {
+        for (auto i = consumed_input_count; i < dec->input_count; ++i) {
+            dec->inputs[i - consumed_input_count] = dec->inputs[i];
+        }
+        dec->input_count -= consumed_input_count;
+        dec->consumed_input_count = 0;
+    }
+
+    return consumed_input_count;
+}
+
+static void reset_inputs(vorbis_decoder_t::job_state_t* state) {
+    state->output_indices.reset();
+    state->input = {};
+
+    reset_aux_input(state);
+
+    state->packet_pcm = nullptr;
+    state->packet_frame_offset = state->packet_frame_count = 0;
+
+    state->not_enough_input_data = false;
+    state->stream_failed = false;
+    state->stop_requested = false;
+    state->segment = unlimited_segment_window();
+
+    // inputs are restarted from the stream beginning, so headers are parsed again
+    close_vorbis(state);
+}
+
+static void start_input_segment(vorbis_decoder_t::job_state_t* state) {
+    reset_aux_input(state);
+    state->stream_failed = false;
+    state->segment = state->input.segment;
+
+    // segments start from the stream beginning (no seek points), so headers are parsed again
+    close_vorbis(state);
+}
+
+static void apply_pending_reset(vorbis_decoder_t* dec) {
+    if (dec->job_state.running) return;
+
+    if (dec->reset_state) {
+        dec->reset_state = false;
+        reset_inputs(&dec->job_state);
+    }
+}
+
+/**
+ * @brief prepares decoding job input, decoding is launched by scheduler in batch with other decoders
+ */
+static bool begin_decoding_step(vorbis_decoder_t* dec) {
+    if (dec->job_state.running) return false;
+
+    apply_pending_reset(dec);
+
+    if (dec->job_state.not_enough_input_data) {
+        // wait till release_consumed_inputs
+        return false;
+    }
+
+    // do not launch if has no input (input is kept till the pending packet is written out)
+    bool has_inputs = dec->consumed_input_count < dec->input_count;
+    if (!has_inputs) return false;
+
+    // or outputs
+    if (!dec->job_state.output_indices.can_write()) return false;
+
+    if (is_empty(dec->job_state.input.buffer) && !dec->job_state.packet_frame_count) {
+        dec->job_state.input = dec->inputs[dec->consumed_input_count];
+        if (dec->job_state.input.segment_start) start_input_segment(&dec->job_state);
+    }
+
+    dec->job_state.running = true;
+    return true;
+}
+
+static uint32_t buffered_time_ms(const vorbis_decoder_t* dec) {
+    // outputs are dropped on reset
+    if (dec->reset_state) return 0;
+
+    auto& indices = dec->job_state.output_indices;
+    auto wp = indices.write_pos.load();
+
+    uint32_t res = 0;
+    for (auto pos = indices.read_pos.load(); pos != wp; ++pos) {
+        auto& output = dec->job_state.outputs[indices.index(pos)];
+        res += uint32_t((output.frame_count - output.frame_offset) * 1000 / output.sample_rate);
+    }
+    return res;
+}
+
+static bool queue_input(vorbis_decoder_t* dec, const data_buffer_t& buf, bool last_input) {
+    // should not be the case ever, ?assert?
+    if (dec->input_count == MAX_INPUT_BUFFERS) return false;
+
+    input_buffer_t input = {};
+    input.buffer = buf;
+    input.last = last_input;
+    input.segment_start = dec->segment_pending;
+    input.segment = dec->pending_segment;
+    dec->inputs[dec->input_count++] = input;
+
+    dec->segment_pending = false;
+
+    return true;
+}
+
+static bool contains(const output_buffer_t& out_buf, const void* ptr) {
+    auto ptr_u8 = (uint8_t*)ptr;
+    return (uint8_t*)out_buf.pcm <= ptr_u8 && ptr_u8 < ((uint8_t*)out_buf.pcm + sizeof(out_buf.pcm));
+}
+
+static void release_output(vorbis_decoder_t* dec, data_buffer_t output_buf) {
+    if (output_buf.size) {
+        auto rp = dec->job_state.output_indices.read_pos.load();
+        assert(contains(dec->job_state.outputs[dec->job_state.output_indices.index(rp)], output_buf.data));
+
+        // vacant output buffer is decoded into with the next scheduled batch
+        dec->job_state.output_indices.read_pos.store(++rp);
+    }
+}
+
+static data_buffer_t get_frames_output_buffer(const output_buffer_t& output) {
+    assert(output.frame_offset < output.frame_count);
+
+    auto sample_byte_size = sizeof(float) * output.channels;
+
+    data_buffer_t res = {};
+    res.data = (uint8_t*)output.pcm + output.frame_offset * sample_byte_size;
+    res.size = (output.frame_count - output.frame_offset) * sample_byte_size;
+    return res;
+}
+
+static data_buffer_t next_output(vorbis_decoder_t* dec, const data_buffer_t& current_buf) {
+    // outputs decoded before flush are dropped
+    if (dec->reset_state) {
+        apply_pending_reset(dec);
+        if (dec->reset_state) return {};
+    }
+
+    // release previous buffer
+    release_output(dec, current_buf);
+
+    auto rp = dec->job_state.output_indices.read_pos.load();
+
+    // return empty if next is still writing
+    auto wp = dec->job_state.output_indices.write_pos.load();
+    if (rp == wp) {
+        return {};
+    }
+
+    uint8_t read_buf_index = dec->job_state.output_indices.index(rp);
+
+    return get_frames_output_buffer(dec->job_state.outputs[read_buf_index]);
+}
+
+static bool is_running(const vorbis_decoder_t* dec) {
+    return dec->job_state.running;
+}
+
+static void flush(vorbis_decoder_t* dec) {
+    dec->consumed_input_count = 0;
+    dec->input_count = 0;
+    dec->segment_pending = false;
+
+    if (dec->job_state.running) {
+        // reset when the job is finished
+        dec->job_state.stop_requested = true;
+        dec->reset_state = true;
+    } else {
+        reset_inputs(&dec->job_state);
+    }
+}
+
+static void start_segment(vorbis_decoder_t* dec, uint64_t skip_frames, uint64_t max_frames) {
+    dec->segment_pending = true;
+    dec->pending_segment = make_segment_window(skip_frames, max_frames);
+}
+
+//
+// decoder_ti vtable
+//
+
+static size_t vorbis_dec_release_consumed_inputs(void* state) {
+    auto dec = (vorbis_decoder_t*)state;
+    return release_consumed_inputs(dec);
+}
+
+static bool vorbis_dec_queue_input(void* state, const data_buffer_t& buf, bool last_input) {
+    auto dec = (vorbis_decoder_t*)state;
+    return queue_input(dec, buf, last_input);
+}
+
+static data_buffer_t vorbis_dec_next_output(void* state, const data_buffer_t& current_buf) {
+    auto dec = (vorbis_decoder_t*)state;
+    return next_output(dec, current_buf);
+}
+
+static bool vorbis_dec_is_running(void* state) {
+    auto dec = (vorbis_decoder_t*)state;
+    return is_running(dec);
+}
+
+static void vorbis_dec_flush(void* state) {
+    auto dec = (vorbis_decoder_t*)state;
+    flush(dec);
+}
+
+static void vorbis_dec_start_segment(void* state, uint64_t skip_frames, uint64_t max_frames) {
+    auto dec = (vorbis_decoder_t*)state;
+    start_segment(dec, skip_frames, max_frames);
+}
+
+static void vorbis_dec_destroy(void* state) {
+    auto dec = (vorbis_decoder_t*)state;
+    destroy(dec);
+}
+
+static const decoder_ti g_vorbis_decoder_vt = []() {
+    decoder_ti vt = {};
+    vt.release_consumed_inputs = vorbis_dec_release_consumed_inputs;
+    vt.queue_input = vorbis_dec_queue_input;
+    vt.next_output = vorbis_dec_next_output;
+    vt.is_running = vorbis_dec_is_running;
+    vt.flush = vorbis_dec_flush;
+    vt.start_segment = vorbis_dec_start_segment;
+    vt.destroy = vorbis_dec_destroy;
+
+    return vt;
+}();
+
+//
+// decode_task_ti vtable
+//
+
+static uint32_t vorbis_dec_buffered_time_ms(void* state) {
+    auto dec = (vorbis_decoder_t*)state;
+    return buffered_time_ms(dec);
+}
+
+static bool vorbis_dec_begin_step(void* state) {
+    auto dec = (vorbis_decoder_t*)state;
+    return begin_decoding_step(dec);
+}
+
+static void vorbis_dec_run_step(void* state) {
+    auto dec = (vorbis_decoder_t*)state;
+
+    HLEA_TRACE_SCOPE("decode_vorbis");
+    decode_vorbis(&dec->job_state);
+}
+
+static const decode_task_ti g_vorbis_decode_task_vt = []() {
+    decode_task_ti vt = {};
+    vt.buffered_time_ms = vorbis_dec_buffered_time_ms;
+    vt.begin_step = vorbis_dec_begin_step;
+    vt.run_step = vorbis_dec_run_step;
+
+    return vt;
+}();
+
+decode_task_t cast_to_decode_task(vorbis_decoder_t* dec) {
+    decode_task_t res = {};
+    res.vt = &g_vorbis_decode_task_vt;
+    res.state = dec;
+    return res;
+}
+
+decoder_t cast_to_decoder(vorbis_decoder_t* dec) {
+    decoder_t res = {};
+    res.vt = &g_vorbis_decoder_vt;
+    res.state = dec;
+    return res;
+}
+
+uint64_t vorbis_decode_buffer_s16(allocator_t allocator, const data_buffer_t& input, uint8_t channels,
+        int16_t* frames_out, uint64_t frame_count) {
+    stb_vorbis_alloc vorbis_alloc = {};
+    vorbis_alloc.alloc_buffer = (char*)allocate(allocator, VORBIS_ALLOC_BUFFER_SIZE);
+    vorbis_alloc.alloc_buffer_length_in_bytes = VORBIS_ALLOC_BUFFER_SIZE;
+
+    uint64_t frames_written = 0;
+
+    int error = 0;
+    auto vorbis = stb_vorbis_open_memory(input.data, int(input.size), &error, &vorbis_alloc);
+    if (vorbis) {
+        if (stb_vorbis_get_info(vorbis).channels == channels) {
+            while (frames_written < frame_count) {
+                auto frames_left = frame_count - frames_written;
+                int frames = stb_vorbis_get_samples_short_interleaved(vorbis, channels,
+                    frames_out + frames_written * channels, int(std::min(frames_left, uint64_t(OUTPUT_BUFFER_FRAMES)) * channels));
+                if (!frames) break;
+
+                frames_written += frames;
+            }
+        }
+        stb_vorbis_close(vorbis);
+    }
+
+    deallocate(allocator, vorbis_alloc.alloc_buffer);
+
+    return frames_written;
+}
+
+}
+}
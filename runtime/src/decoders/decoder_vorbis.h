@@ -0,0 +1,39 @@
+#pragma once
+
+#include "decoder.h"
+#include "internal_alloc_types.h"
+#include "decode_scheduler.h"
+
+namespace hle_audio {
+namespace rt {
+
+struct vorbis_decoder_t;
+
+static const uint8_t DEFAULT_VORBIS_OUTPUT_BUFFERS = 4;
+
+struct vorbis_decoder_create_info_t {
+    allocator_t allocator;
+    decode_scheduler_t* scheduler;
+
+    // decoded frames ring depth, power of 2 (0 - default)
+    uint8_t output_buffer_count;
+};
+
+vorbis_decoder_t* create_decoder(const vorbis_decoder_create_info_t& info);
+void destroy(vorbis_decoder_t* dec);
+
+void reset(vorbis_decoder_t* dec);
+decoder_t cast_to_decoder(vorbis_decoder_t* dec);
+
+// registered in scheduler on create
+decode_task_t cast_to_decode_task(vorbis_decoder_t* dec);
+
+/**
+ * @brief decodes whole ogg vorbis data synchronously (e.g. on job thread) into s16 frames
+ * @return number of frames written, frame_count at most
+ */
+uint64_t vorbis_decode_buffer_s16(allocator_t allocator, const data_buffer_t& input, uint8_t channels,
+    int16_t* frames_out, uint64_t frame_count);
+
+}
+}
@@ -1,22 +1,75 @@
 #include "default_allocator.h"
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
 
 namespace hle_audio {
 
+/**
+ * malloc block is over-allocated to align the user pointer,
+ * the header right before it keeps the block offset and the alignment for reallocate
+ */
+struct aligned_header_t {
+    uint32_t offset; // from malloc block start
+    uint32_t alignment;
+};
+
+static const size_t MIN_ALIGNMENT = alignof(std::max_align_t);
+
+static size_t block_size(size_t size, size_t alignment) {
+    return size + alignment - 1 + sizeof(aligned_header_t);
+}
+
+static void* align_block(void* block, size_t alignment) {
+    auto user_ptr = (uintptr_t(block) + sizeof(aligned_header_t) + alignment - 1) & ~uintptr_t(alignment - 1);
+    return (void*)user_ptr;
+}
+
+static aligned_header_t* get_header(void* p) {
+    return (aligned_header_t*)p - 1;
+}
+
 static void* default_malloc_allocate(void* udata, size_t size, size_t alignment) {
-    assert(alignment <= alignof(std::max_align_t));
-    return malloc(size);
-    // todo: no aligned_alloc on windows
-    // return std::aligned_alloc(alignment, size);
+    assert(alignment && (alignment & (alignment - 1)) == 0);
+    if (alignment < MIN_ALIGNMENT) alignment = MIN_ALIGNMENT;
+
+    auto block = malloc(block_size(size, alignment));
+    if (!block) return nullptr;
+
+    auto p = align_block(block, alignment);
+
+    auto header = get_header(p);
+    header->offset = uint32_t((uint8_t*)p - (uint8_t*)block);
+    header->alignment = uint32_t(alignment);
+    return p;
 }
 
 static void* default_malloc_reallocate(void* udata, void* p, size_t size) {
-    return realloc(p, size);
+    if (!p) return default_malloc_allocate(udata, size, MIN_ALIGNMENT);
+
+    auto header = *get_header(p);
+    auto block = (uint8_t*)p - header.offset;
+
+    auto new_block = (uint8_t*)realloc(block, block_size(size, header.alignment));
+    if (!new_block) return nullptr;
+
+    auto new_p = align_block(new_block, header.alignment);
+    auto new_offset = uint32_t((uint8_t*)new_p - new_block);
+
+    // moved block could have different alignment padding
+    if (new_offset != header.offset) {
+        memmove(new_p, new_block + header.offset, size);
+    }
+
+    header.offset = new_offset;
+    *get_header(new_p) = header;
+    return new_p;
 }
 
 static void default_malloc_deallocate(void* udata, void* p) {
-    free(p);
+    if (!p) return;
+
+    free((uint8_t*)p - get_header(p)->offset);
 }
 
 static const hlea_allocator_ti g_malloc_allocator_vt  = {
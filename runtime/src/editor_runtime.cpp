@@ -128,7 +128,8 @@ bank_streaming_source_info_t retrieve_streaming_info(editor_runtime_t* editor_rt
 
         bank_streaming_source_info_t res = {};
         res.streaming_src = str_src;
-        res.file_range = fd_rec.data_chunk_range;
+        res.file_range.offset = fd_rec.data_chunk_range.offset;
+        res.file_range.size = fd_rec.data_chunk_range.size;
 
         editor_runtime_t::cache_record_t cache_file = {};
         cache_file.use_count = 1;
@@ -0,0 +1,250 @@
+#include "hlea/fault_file.h"
+#include "default_allocator.h"
+#include "alloc_utils.inl"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <new>
+#include <random>
+#include <thread>
+
+#include "miniaudio_public.h"
+
+using clock_type = std::chrono::steady_clock;
+
+struct hlea_fault_file_t {
+    allocator_t allocator;
+
+    const hlea_file_ti* file_api_vt;
+    void* file_sys;
+    ma_default_vfs default_vfs;
+
+    std::mutex mutex;
+    hlea_fault_file_settings_t settings;
+    std::mt19937 rng;
+    clock_type::time_point device_free_time;
+
+    std::atomic<uint64_t> reads;
+    std::atomic<uint64_t> bytes_read;
+    std::atomic<uint64_t> delay_us;
+    std::atomic<uint64_t> stalls;
+    std::atomic<uint64_t> short_reads;
+};
+
+/**
+ * default files over miniaudio default vfs
+ */
+static hlea_file_handle_t default_file_open(void* sys, const char* file_path) {
+    ma_vfs_file file = {};
+    if (ma_vfs_open((ma_vfs*)sys, file_path, MA_OPEN_MODE_READ, &file) != MA_SUCCESS) return {};
+    return (hlea_file_handle_t)(intptr_t)file;
+}
+
+static void default_file_close(void* sys, hlea_file_handle_t file) {
+    ma_vfs_close((ma_vfs*)sys, (ma_vfs_file)file);
+}
+
+static size_t default_file_size(void* sys, hlea_file_handle_t file) {
+    ma_file_info info = {};
+    ma_vfs_info((ma_vfs*)sys, (ma_vfs_file)file, &info);
+    return (size_t)info.sizeInBytes;
+}
+
+static size_t default_file_read(void* sys, hlea_file_handle_t file, void* dst, size_t dst_size) {
+    size_t read_bytes = 0;
+    ma_vfs_read((ma_vfs*)sys, (ma_vfs_file)file, dst, dst_size, &read_bytes);
+    return read_bytes;
+}
+
+static size_t default_file_tell(void* sys, hlea_file_handle_t file) {
+    ma_int64 cursor = 0;
+    ma_vfs_tell((ma_vfs*)sys, (ma_vfs_file)file, &cursor);
+    return (size_t)cursor;
+}
+
+static void default_file_seek(void* sys, hlea_file_handle_t file, size_t pos) {
+    ma_vfs_seek((ma_vfs*)sys, (ma_vfs_file)file, (ma_int64)pos, ma_seek_origin_start);
+}
+
+static const hlea_file_ti default_file_vt = {
+    default_file_open,
+    default_file_close,
+    default_file_size,
+    default_file_read,
+    default_file_tell,
+    default_file_seek
+};
+
+/**
+ * fault file api
+ */
+struct read_plan_t {
+    clock_type::time_point ready_time;
+    size_t read_size;
+};
+
+static read_plan_t plan_read(hlea_fault_file_t* ff, size_t size) {
+    std::lock_guard<std::mutex> lock(ff->mutex);
+    const auto& settings = ff->settings;
+
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+
+    float delay_ms = 0.0f;
+    if (settings.latency_median_ms > 0.0f) {
+        delay_ms += settings.latency_median_ms * expf(settings.latency_spread * normal(ff->rng));
+    }
+    delay_ms += settings.jitter_ms * uniform(ff->rng);
+    if (settings.stall_probability > 0.0f && uniform(ff->rng) < settings.stall_probability) {
+        delay_ms += settings.stall_ms;
+        ff->stalls++;
+    }
+
+    read_plan_t res = {};
+    res.read_size = size;
+    if (settings.short_read_probability > 0.0f && size && uniform(ff->rng) < settings.short_read_probability) {
+        // at least a byte, zero bytes read is the end of file
+        res.read_size = std::max<size_t>(1, size_t(float(size) * uniform(ff->rng)));
+        ff->short_reads++;
+    }
+
+    auto now = clock_type::now();
+    res.ready_time = now + std::chrono::microseconds(int64_t(delay_ms * 1000.0f));
+    if (settings.bandwidth_bytes_per_second) {
+        // transfers don't overlap, next one starts after the device is free
+        auto transfer_time = std::chrono::microseconds(res.read_size * 1000000u / settings.bandwidth_bytes_per_second);
+        auto start_time = std::max(res.ready_time, ff->device_free_time);
+        res.ready_time = ff->device_free_time = start_time + transfer_time;
+    }
+
+    ff->delay_us += std::chrono::duration_cast<std::chrono::microseconds>(res.ready_time - now).count();
+    return res;
+}
+
+static hlea_file_handle_t fault_file_open(void* sys, const char* file_path) {
+    auto ff = (hlea_fault_file_t*)sys;
+    return ff->file_api_vt->open(ff->file_sys, file_path);
+}
+
+static void fault_file_close(void* sys, hlea_file_handle_t file) {
+    auto ff = (hlea_fault_file_t*)sys;
+    ff->file_api_vt->close(ff->file_sys, file);
+}
+
+static size_t fault_file_size(void* sys, hlea_file_handle_t file) {
+    auto ff = (hlea_fault_file_t*)sys;
+    return ff->file_api_vt->size(ff->file_sys, file);
+}
+
+static size_t fault_file_read(void* sys, hlea_file_handle_t file, void* dst, size_t dst_size) {
+    auto ff = (hlea_fault_file_t*)sys;
+
+    auto plan = plan_read(ff, dst_size);
+    std::this_thread::sleep_until(plan.ready_time);
+
+    auto read_bytes = ff->file_api_vt->read(ff->file_sys, file, dst, plan.read_size);
+    ff->reads++;
+    ff->bytes_read += read_bytes;
+    return read_bytes;
+}
+
+static size_t fault_file_tell(void* sys, hlea_file_handle_t file) {
+    auto ff = (hlea_fault_file_t*)sys;
+    return ff->file_api_vt->tell(ff->file_sys, file);
+}
+
+static void fault_file_seek(void* sys, hlea_file_handle_t file, size_t pos) {
+    auto ff = (hlea_fault_file_t*)sys;
+    ff->file_api_vt->seek(ff->file_sys, file, pos);
+}
+
+static const hlea_file_ti fault_file_vt = {
+    fault_file_open,
+    fault_file_close,
+    fault_file_size,
+    fault_file_read,
+    fault_file_tell,
+    fault_file_seek
+};
+
+const hlea_file_ti* hlea_fault_file_api() {
+    return &fault_file_vt;
+}
+
+hlea_fault_file_settings_t hlea_fault_file_preset(hlea_fault_file_preset_e preset) {
+    hlea_fault_file_settings_t res = {};
+    switch (preset) {
+    case hlea_fault_file_preset_e::hdd:
+        res.latency_median_ms = 8.0f;
+        res.latency_spread = 0.5f;
+        res.jitter_ms = 2.0f;
+        res.bandwidth_bytes_per_second = 100u << 20;
+        res.stall_probability = 0.001f;
+        res.stall_ms = 200.0f;
+        break;
+    case hlea_fault_file_preset_e::sd_card:
+        res.latency_median_ms = 2.0f;
+        res.latency_spread = 0.6f;
+        res.jitter_ms = 1.0f;
+        res.bandwidth_bytes_per_second = 20u << 20;
+        res.stall_probability = 0.005f;
+        res.stall_ms = 100.0f;
+        break;
+    case hlea_fault_file_preset_e::network_drive:
+        res.latency_median_ms = 20.0f;
+        res.latency_spread = 0.8f;
+        res.jitter_ms = 10.0f;
+        res.bandwidth_bytes_per_second = 10u << 20;
+        res.stall_probability = 0.01f;
+        res.stall_ms = 500.0f;
+        res.short_read_probability = 0.01f;
+        break;
+    default:
+        break;
+    }
+    return res;
+}
+
+hlea_fault_file_t* hlea_fault_file_create(const hlea_fault_file_create_info_t* info) {
+    allocator_t alloc = hle_audio::make_default_allocator();
+    if (info->allocator_vt) {
+        alloc = allocator_t{info->allocator_vt, info->allocator_udata};
+    }
+
+    auto ff = new (allocate<hlea_fault_file_t>(alloc)) hlea_fault_file_t();
+    ff->allocator = alloc;
+    ff->settings = info->settings;
+    ff->rng.seed(info->seed);
+
+    ff->file_api_vt = info->file_api_vt;
+    ff->file_sys = info->file_sys;
+    if (!ff->file_api_vt) {
+        ma_default_vfs_init(&ff->default_vfs, nullptr);
+        ff->file_api_vt = &default_file_vt;
+        ff->file_sys = &ff->default_vfs;
+    }
+
+    return ff;
+}
+
+void hlea_fault_file_destroy(hlea_fault_file_t* fault_file) {
+    auto alloc = fault_file->allocator;
+    fault_file->~hlea_fault_file_t();
+    deallocate(alloc, fault_file);
+}
+
+void hlea_fault_file_set_settings(hlea_fault_file_t* fault_file, const hlea_fault_file_settings_t* settings) {
+    std::lock_guard<std::mutex> lock(fault_file->mutex);
+    fault_file->settings = *settings;
+}
+
+void hlea_fault_file_get_stats(hlea_fault_file_t* fault_file, hlea_fault_file_stats_t* out_stats) {
+    out_stats->reads = fault_file->reads.load();
+    out_stats->bytes_read = fault_file->bytes_read.load();
+    out_stats->delay_us = fault_file->delay_us.load();
+    out_stats->stalls = fault_file->stalls.load();
+    out_stats->short_reads = fault_file->short_reads.load();
+}
@@ -26,7 +26,13 @@ static ma_result read_file(ma_vfs* pVFS, const char* pFilePath,
             data_buffer_t res = {};
             res.data = (uint8_t*)allocate(alloc, info.sizeInBytes);
             if (res.data) {
-                result = ma_vfs_read(pVFS, file, res.data, (size_t)info.sizeInBytes, &res.size);  /* Safe cast. */
+                // short reads are continued, file is expected to be read whole
+                while (result == MA_SUCCESS && res.size < (size_t)info.sizeInBytes) {  /* Safe cast. */
+                    size_t read_bytes = 0;
+                    result = ma_vfs_read(pVFS, file, res.data + res.size, (size_t)info.sizeInBytes - res.size, &read_bytes);
+                    if (result == MA_SUCCESS && !read_bytes) result = MA_AT_END;
+                    res.size += read_bytes;
+                }
                 if (result == MA_SUCCESS) {
                     assert(out_read_buffer != NULL);
                     *out_read_buffer = res;
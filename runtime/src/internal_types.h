@@ -3,12 +3,20 @@
 #include <cstdint>
 #include <limits>
 #include <array>
+#include "hlea/runtime.h"
 #include "rt_types.h"
+#include "runtime_stats.h"
 #include "data_sources/streaming_data_source.h"
 #include "data_sources/buffer_data_source.h"
 #include "nodes/fade_node.h"
 #include "chunk_streaming_cache.h"
 #include "internal_jobs_types.h"
+#include "decode_scheduler.h"
+#include "sound_sequencer.h"
+#include "update_thread.h"
+#include "job_pool.h"
+#include "decoders/decoder_pool.h"
+#include "decoded_cache.h"
 #include "file_api_vfs_bridge.h"
 
 namespace hle_audio { namespace rt {
@@ -18,10 +26,16 @@ struct pcm_decoder_t;
 }}
 
 static const uint16_t MAX_SOUNDS = 1024;
-static const uint16_t MAX_ACTIVE_GROUPS = 128;
+static const uint16_t MAX_ACTIVE_GROUPS = 512;
+static const uint16_t MAX_ENGINE_GROUPS = 128; // direct groups don't use one
 static const uint16_t SOUNDS_UNUSED_LIST = 0u;
 static const uint8_t MAX_OUPUT_BUSES = 32u;
 static const uint16_t MAX_STREAMING_SOURCES = MAX_SOUNDS;
+static const uint8_t MAX_BANK_STREAM_FILES = hle_audio::rt::MAX_STREAM_FILE_PARTS;
+static const uint16_t MAX_TIMED_EVENTS = 256;
+static const uint16_t DEFAULT_SCHEDULE_AHEAD_MS = 50;
+static const uint32_t HEADLESS_SAMPLE_RATE = 48000; // no_device output format
+static const uint32_t HEADLESS_CHANNELS = 2;
 
 enum sound_id_t : uint16_t;
 const sound_id_t invalid_sound_id = (sound_id_t)0u;
@@ -36,6 +50,7 @@ struct sound_data_t {
 
     decoder_t decoder;
     audio_format_type_e coding_format;
+    uint32_t decoded_entry_id; // decoded cache entry played, 0 if none
 
     streaming_data_source_t* str_src;
     buffer_data_source_t* buffer_src;
@@ -46,12 +61,24 @@ struct sound_data_t {
     fade_graph_node_t* sound_fade_node;
 };
 
+struct bank_stream_file_t {
+    ma_vfs_file file;
+    hle_audio::rt::async_file_handle_t afile;
+    hle_audio::rt::streaming_source_handle cache_src;
+
+    uint64_t size; // file or region size
+    bool owns_file; // false for client provided regions
+};
+
 struct hlea_event_bank_t {
     hle_audio::rt::buffer_t data_buffer_ptr;
     const hle_audio::rt::store_t* static_data;
-    ma_vfs_file streaming_file;
-    hle_audio::rt::async_file_handle_t streaming_afile;
-    hle_audio::rt::streaming_source_handle streaming_cache_src;
+
+    bank_stream_file_t stream_files[MAX_BANK_STREAM_FILES];
+    uint8_t stream_file_count;
+
+    // per group, single file node groups are played straight into output bus
+    bool* direct_groups;
 };
 
 struct sequence_rt_state_t {
@@ -80,6 +107,7 @@ struct group_data_t {
 
     playing_state_e state;
 
+    bool direct; // sound is attached to output bus, no engine group
     group_index_t engine_group_index;
 
     sound_id_t sound_id;
@@ -93,6 +121,13 @@ struct event_desc_t {
     uint32_t target_index;
     uint32_t obj_id;
     float fade_time;
+    uint64_t time_pcm; // engine time action takes effect at, 0 - right away
+};
+
+struct timed_event_t {
+    hlea_action_type_e type;
+    event_desc_t desc;
+    uint32_t order; // fired in order of firing if time is the same
 };
 
 template<typename T, size_t ARRAY_SIZE_T, typename CountType>
@@ -136,10 +171,10 @@ static const T* bank_get(const hlea_event_bank_t* bank,
 
 struct bank_streaming_source_info_t {
     using streaming_source_handle = hle_audio::rt::streaming_source_handle;
-    using range_t = hle_audio::rt::range_t;
+    using stream_range_t = hle_audio::rt::stream_range_t;
     
     streaming_source_handle streaming_src;
-    range_t file_range;
+    stream_range_t file_range;
 };
 
 struct editor_api_t {
@@ -163,7 +198,7 @@ struct hlea_context_t {
     vfs_bridge_t vfs_impl;
     ma_default_vfs vfs_default;
 
-    ma_device_job_thread task_executor;
+    hle_audio::rt::job_pool_t* job_pool;
 
     allocator_t base_allocator;
     tracking_allocator_t tracking_alloc; // debug
@@ -171,6 +206,13 @@ struct hlea_context_t {
     ma_vfs* pVFS;
     allocator_t allocator;
     jobs_t jobs;
+    hle_audio::rt::runtime_counters_t* counters; // shared with modules
+    hle_audio::rt::decode_scheduler_t* decode_scheduler;
+    hle_audio::rt::sound_sequencer_t* sequencer; // slot per engine group
+    hle_audio::rt::update_thread_t* update_thread; // optional, runs hlea_process_frame
+    hle_audio::rt::decoder_pool_t* decoder_pool;
+    hle_audio::rt::decoded_cache_t* decoded_cache;
+    bool decode_on_bank_load;
     hle_audio::rt::async_file_reader_t* async_io;
     hle_audio::rt::chunk_streaming_cache_t* streaming_cache;
 
@@ -194,9 +236,16 @@ struct hlea_context_t {
 
     group_data_t active_groups[MAX_ACTIVE_GROUPS];
     uint16_t active_groups_size;
+    uint16_t active_groups_high_water;
+
+    // heap of events fired ahead of time, the earliest on top
+    array_with_size_t<timed_event_t, MAX_TIMED_EVENTS, uint16_t> timed_events;
+    uint32_t timed_events_order;
+    uint32_t schedule_ahead_pcm;
 
-    array_with_size_t<ma_sound_group, MAX_ACTIVE_GROUPS, uint16_t> group_engine_groups;
-    array_with_size_t<group_index_t, MAX_ACTIVE_GROUPS, uint16_t> unused_group_engine_groups_indices;
+    // initialized on first use and kept so until context destroy, unused ones are detached
+    array_with_size_t<ma_sound_group, MAX_ENGINE_GROUPS, uint16_t> group_engine_groups;
+    array_with_size_t<group_index_t, MAX_ENGINE_GROUPS, uint16_t> unused_group_engine_groups_indices;
 
     array_with_size_t<streaming_data_source_t, MAX_STREAMING_SOURCES, uint16_t> streaming_sources;
     array_with_size_t<uint16_t, MAX_STREAMING_SOURCES, uint16_t> unused_streaming_sources_indices;
@@ -208,3 +257,21 @@ struct hlea_context_t {
     array_with_size_t<uint16_t, MAX_SOUNDS, uint16_t> unused_fade_nodes_indices;
 };
 
+/**
+ * client api calls are serialized with runtime update thread, if there is one
+ */
+struct api_lock_t {
+    hle_audio::rt::update_thread_t* update_thread;
+
+    explicit api_lock_t(hlea_context_t* ctx) : update_thread(ctx->update_thread) {
+        if (update_thread) lock(update_thread);
+    }
+
+    ~api_lock_t() {
+        if (update_thread) unlock(update_thread);
+    }
+
+    api_lock_t(const api_lock_t&) = delete;
+    api_lock_t& operator=(const api_lock_t&) = delete;
+};
+
@@ -0,0 +1,307 @@
+#include "job_pool.h"
+#include "alloc_utils.inl"
+#include "trace.h"
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cassert>
+#include <algorithm>
+#include <cstdio>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <cerrno>
+#include <cstring>
+#if defined(__APPLE__)
+#include <pthread/qos.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+namespace hle_audio {
+namespace rt {
+
+/**
+ * owner pops from the back (the latest job is likely hot in cache), thieves take from the front
+ */
+struct job_queue_t {
+    std::mutex sync_mutex;
+
+    hlea_job_t jobs[MAX_WORKER_JOBS];
+    uint32_t front_pos;
+    uint32_t back_pos;
+};
+
+struct job_worker_t {
+    job_queue_t queue;
+    std::thread thread;
+};
+
+struct job_pool_t {
+    allocator_t allocator;
+
+    job_worker_t workers[MAX_JOB_POOL_WORKERS];
+    uint8_t worker_count;
+    hlea_thread_priority_e priority;
+
+    // round-robin distribution of launched jobs
+    std::atomic<uint32_t> next_worker;
+
+    // queued, not started jobs
+    std::atomic<uint32_t> pending_count;
+
+    std::mutex sleep_mutex;
+    std::condition_variable wakeup_signal;
+
+    std::atomic<bool> stopped;
+};
+
+static_assert((MAX_WORKER_JOBS & (MAX_WORKER_JOBS - 1)) == 0, "MAX_WORKER_JOBS is expected to be power of 2");
+
+static uint32_t size(const job_queue_t& queue) {
+    return queue.back_pos - queue.front_pos;
+}
+
+static bool push(job_queue_t& queue, const hlea_job_t& job) {
+    std::unique_lock<std::mutex> lk(queue.sync_mutex);
+    if (size(queue) == MAX_WORKER_JOBS) return false;
+
+    queue.jobs[queue.back_pos++ & (MAX_WORKER_JOBS - 1)] = job;
+    return true;
+}
+
+static bool pop_back(job_queue_t& queue, hlea_job_t* out_job) {
+    std::unique_lock<std::mutex> lk(queue.sync_mutex);
+    if (!size(queue)) return false;
+
+    *out_job = queue.jobs[--queue.back_pos & (MAX_WORKER_JOBS - 1)];
+    return true;
+}
+
+static bool pop_front(job_queue_t& queue, hlea_job_t* out_job) {
+    std::unique_lock<std::mutex> lk(queue.sync_mutex);
+    if (!size(queue)) return false;
+
+    *out_job = queue.jobs[queue.front_pos++ & (MAX_WORKER_JOBS - 1)];
+    return true;
+}
+
+static bool steal(job_pool_t* pool, uint8_t thief_index, hlea_job_t* out_job) {
+    for (uint8_t i = 1; i < pool->worker_count; ++i) {
+        auto& victim = pool->workers[(thief_index + i) % pool->worker_count];
+        if (pop_front(victim.queue, out_job)) return true;
+    }
+    return false;
+}
+
+#if defined(__linux__)
+// SCHED_OTHER threads have the only static priority, they are weighted by per thread nice value
+static const int HIGH_PRIORITY_NICE = -10;
+static const int LOW_PRIORITY_NICE = 10;
+#endif
+
+static void set_current_thread_priority(hlea_thread_priority_e priority) {
+    if (priority == hlea_thread_priority_e::normal) return;
+    bool high = priority == hlea_thread_priority_e::high;
+
+#if defined(_WIN32)
+    if (!SetThreadPriority(GetCurrentThread(), high ? THREAD_PRIORITY_ABOVE_NORMAL : THREAD_PRIORITY_BELOW_NORMAL)) {
+        fprintf(stderr, "hlea: couldn't set job thread priority (error %lu)\n", GetLastError());
+    }
+#elif defined(__APPLE__)
+    int err = pthread_set_qos_class_self_np(high ? QOS_CLASS_USER_INTERACTIVE : QOS_CLASS_UTILITY, 0);
+    if (err) {
+        fprintf(stderr, "hlea: couldn't set job thread qos class (%s)\n", strerror(err));
+    }
+#elif defined(__linux__)
+    // raising priority needs CAP_SYS_NICE or RLIMIT_NICE
+    auto tid = (id_t)syscall(SYS_gettid);
+    if (setpriority(PRIO_PROCESS, tid, high ? HIGH_PRIORITY_NICE : LOW_PRIORITY_NICE)) {
+        fprintf(stderr, "hlea: couldn't set job thread nice value (%s)\n", strerror(errno));
+    }
+#else
+    (void)high;
+    fprintf(stderr, "hlea: job thread priority isn't supported on this platform\n");
+#endif
+}
+
+static void process_jobs(job_pool_t* pool, uint8_t worker_index) {
+    HLEA_TRACE_THREAD_NAME("hlea job worker");
+    set_current_thread_priority(pool->priority);
+
+    auto& worker = pool->workers[worker_index];
+
+    while (true) {
+        hlea_job_t job = {};
+        if (pop_back(worker.queue, &job) || steal(pool, worker_index, &job)) {
+            --pool->pending_count;
+            job.job_func(job.udata);
+            continue;
+        }
+
+        // launched jobs are finished before stop
+        if (pool->stopped) break;
+
+        std::unique_lock<std::mutex> lk(pool->sleep_mutex);
+        pool->wakeup_signal.wait(lk, [pool]() {
+            return pool->stopped || pool->pending_count.load();
+        });
+    }
+}
+
+static void wakeup_workers(job_pool_t* pool, uint32_t job_count) {
+    {
+        // avoid lost wakeup between predicate check and wait
+        std::unique_lock<std::mutex> lk(pool->sleep_mutex);
+    }
+    if (job_count == 1) pool->wakeup_signal.notify_one();
+    else pool->wakeup_signal.notify_all();
+}
+
+static void queue_job(job_pool_t* pool, const hlea_job_t& job) {
+    ++pool->pending_count;
+
+    auto worker_index = pool->next_worker++;
+    for (uint8_t i = 0; i < pool->worker_count; ++i) {
+        auto& worker = pool->workers[(worker_index + i) % pool->worker_count];
+        if (push(worker.queue, job)) return;
+    }
+
+    // not expected with runtime jobs, the job is kept till workers take some,
+    // it's never run on launching thread
+    assert(false && "job queues overflow");
+    wakeup_workers(pool, pool->worker_count);
+    while (true) {
+        std::this_thread::yield();
+        for (uint8_t i = 0; i < pool->worker_count; ++i) {
+            if (push(pool->workers[i].queue, job)) return;
+        }
+    }
+}
+
+static void launch(job_pool_t* pool, const hlea_job_t& job) {
+    queue_job(pool, job);
+    wakeup_workers(pool, 1);
+}
+
+static void launch_batch(job_pool_t* pool, const hlea_job_t* jobs, uint32_t job_count) {
+    if (!job_count) return;
+
+    for (uint32_t i = 0; i < job_count; ++i) {
+        queue_job(pool, jobs[i]);
+    }
+    wakeup_workers(pool, job_count);
+}
+
+//
+// platform thread setup
+//
+
+static uint8_t nth_set_bit(uint64_t mask, uint32_t n) {
+    uint8_t set_bit_count = 0;
+    for (uint8_t bit = 0; bit < 64; ++bit) {
+        if (mask & (1ull << bit)) ++set_bit_count;
+    }
+    n %= set_bit_count;
+
+    for (uint8_t bit = 0; bit < 64; ++bit) {
+        if (!(mask & (1ull << bit))) continue;
+        if (!n--) return bit;
+    }
+    return 0;
+}
+
+static void setup_thread_affinity(std::thread& thread, uint64_t affinity_mask, uint8_t worker_index) {
+    if (!affinity_mask) return;
+
+    auto handle = thread.native_handle();
+#if defined(_WIN32)
+    SetThreadAffinityMask(handle, DWORD_PTR(1ull << nth_set_bit(affinity_mask, worker_index)));
+#elif defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(nth_set_bit(affinity_mask, worker_index), &cpu_set);
+    pthread_setaffinity_np(handle, sizeof(cpu_set), &cpu_set);
+#else
+    // no thread affinity api
+    (void)handle;
+    (void)worker_index;
+#endif
+}
+
+job_pool_t* create_job_pool(const job_pool_create_info_t& info) {
+    auto pool = allocate<job_pool_t>(info.allocator);
+    pool = new(pool) job_pool_t(); // init c++ members
+    pool->allocator = info.allocator;
+
+    uint8_t worker_count = info.worker_count;
+    if (!worker_count) {
+        auto hw_threads = std::thread::hardware_concurrency();
+        worker_count = uint8_t(1 < hw_threads ? std::min(hw_threads - 1, unsigned(MAX_JOB_POOL_WORKERS)) : 1);
+    }
+    if (MAX_JOB_POOL_WORKERS < worker_count) worker_count = MAX_JOB_POOL_WORKERS;
+    pool->worker_count = worker_count;
+    pool->priority = info.priority;
+
+    for (uint8_t i = 0; i < pool->worker_count; ++i) {
+        auto& worker = pool->workers[i];
+        worker.thread = std::thread(process_jobs, pool, i);
+        setup_thread_affinity(worker.thread, info.affinity_mask, i);
+    }
+
+    return pool;
+}
+
+void destroy(job_pool_t* pool) {
+    pool->stopped = true;
+    wakeup_workers(pool, pool->worker_count);
+
+    for (uint8_t i = 0; i < pool->worker_count; ++i) {
+        pool->workers[i].thread.join();
+    }
+
+    pool->~job_pool_t();
+    deallocate(pool->allocator, pool);
+}
+
+//
+// hlea_jobs_ti vtable
+//
+
+static void job_pool_launch(void* udata, hlea_job_t job) {
+    auto pool = (job_pool_t*)udata;
+    launch(pool, job);
+}
+
+static void job_pool_launch_batch(void* udata, const hlea_job_t* jobs, uint32_t job_count) {
+    auto pool = (job_pool_t*)udata;
+    launch_batch(pool, jobs, job_count);
+}
+
+static const hlea_jobs_ti g_job_pool_vt = []() {
+    hlea_jobs_ti vt = {};
+    vt.launch = job_pool_launch;
+    vt.launch_batch = job_pool_launch_batch;
+
+    return vt;
+}();
+
+jobs_t cast_to_jobs(job_pool_t* pool) {
+    jobs_t res = {};
+    res.vt = &g_job_pool_vt;
+    res.udata = pool;
+    return res;
+}
+
+}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include "internal_alloc_types.h"
+#include "internal_jobs_types.h"
+
+namespace hle_audio {
+namespace rt {
+
+static const uint8_t MAX_JOB_POOL_WORKERS = 32;
+
+// every worker queue fits runtime worst case of queued jobs (decode tasks and decoded cache entries)
+static const uint32_t MAX_WORKER_JOBS = 2048;
+
+struct job_pool_create_info_t {
+    allocator_t allocator;
+
+    // 0 - hardware threads - 1
+    uint8_t worker_count;
+
+    // set by each worker: thread priority on Windows, qos class on Apple, nice value on Linux
+    // (raising it needs CAP_SYS_NICE or RLIMIT_NICE), failures are reported to stderr
+    hlea_thread_priority_e priority;
+
+    // worker i is pinned to i-th set bit core, wraps around (0 - no affinity)
+    uint64_t affinity_mask;
+};
+
+struct job_pool_t;
+
+job_pool_t* create_job_pool(const job_pool_create_info_t& info);
+
+/**
+ * @brief waits for all launched jobs to finish
+ */
+void destroy(job_pool_t* pool);
+
+/**
+ * @brief work-stealing pool: jobs are spread among workers queues,
+ *  idle workers steal from the others
+ */
+jobs_t cast_to_jobs(job_pool_t* pool);
+
+}
+}
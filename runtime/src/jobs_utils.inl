@@ -5,3 +5,14 @@
 static void launch(const jobs_t& jobs_obj, hlea_job_t job) {
     jobs_obj.vt->launch(jobs_obj.udata, job);
 }
+
+static void launch_batch(const jobs_t& jobs_obj, const hlea_job_t* jobs, uint32_t job_count) {
+    if (jobs_obj.vt->launch_batch) {
+        jobs_obj.vt->launch_batch(jobs_obj.udata, jobs, job_count);
+        return;
+    }
+
+    for (uint32_t i = 0; i < job_count; ++i) {
+        jobs_obj.vt->launch(jobs_obj.udata, jobs[i]);
+    }
+}
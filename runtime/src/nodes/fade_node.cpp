@@ -1,12 +1,52 @@
 #include "fade_node.h"
+#include "audio_kernels.h"
+#include "fade_curve.h"
 #include <algorithm>
 #include <cassert>
 
 namespace hle_audio {
 namespace rt {
 
+static const ma_uint32 FADE_GAINS_CHUNK_FRAMES = 256;
+
+/**
+ * @brief applies fade gains to frame_count frames starting at fade_time of fade_length frames fade
+ */
+static void apply_fade(float* frames, ma_uint32 frame_count, ma_uint32 channels,
+        const fade_curve_knots_t& curve, ma_uint64 fade_time, ma_uint64 fade_length, bool fade_out) {
+    const float time_scale = 1.0f / fade_length;
+
+    if (!curve.count) {
+        float gain = float(fade_time) * time_scale;
+        float gain_step = time_scale;
+        if (fade_out) {
+            gain = 1.0f - gain;
+            gain_step = -gain_step;
+        }
+        apply_gain_ramp(frames, frame_count, channels, gain, gain_step);
+        return;
+    }
+
+    // fade out is the fade in curve reversed
+    float gains[FADE_GAINS_CHUNK_FRAMES];
+    uint32_t segment_hint = fade_out ? curve.count - 2 : 0;
+    while (frame_count) {
+        auto chunk_frames = std::min(frame_count, FADE_GAINS_CHUNK_FRAMES);
+        for (ma_uint32 i = 0; i < chunk_frames; ++i) {
+            float x = float(fade_time + i) * time_scale;
+            gains[i] = sample_fade_curve_knots(curve.knots, curve.count, fade_out ? 1.0f - x : x, &segment_hint);
+        }
+        apply_gain_envelope(frames, chunk_frames, channels, gains);
+
+        frames += chunk_frames * channels;
+        frame_count -= chunk_frames;
+        fade_time += chunk_frames;
+    }
+}
+
 static void fade_node_process_pcm_frames(ma_node* pNode, const float** ppFramesIn, ma_uint32* pFrameCountIn, float** ppFramesOut, ma_uint32* pFrameCountOut) {
     fade_graph_node_t* fade_node = (fade_graph_node_t*)pNode;
+    audio_cost_scope_t cost(fade_node->counters ? &fade_node->counters->audio_load : nullptr, AUDIO_COST_FADE_NODE);
 
     ma_uint64 node_local_time = ma_node_get_time(pNode);
     ma_uint64 target_local_time = ma_node_get_time(fade_node->target_sound);
@@ -25,27 +65,27 @@ static void fade_node_process_pcm_frames(ma_node* pNode, const float** ppFramesI
     ma_uint64 local_time = target_local_time - frameCount;
 
     auto channels = ma_node_get_output_channels(pNode, 0);
-    if (local_time <= fade_node->start_time_pcm_frames) {
-        for (ma_uint64 iFrame = 0; iFrame < frameCount; iFrame += 1) {
-            float a = std::min(ma_uint32(local_time + iFrame), fade_node->start_time_pcm_frames) / float(fade_node->start_time_pcm_frames);
-            float volume = a;
-            assert(0.0f <= volume && volume <= 1.0f);
-
-            for (ma_uint32 iChannel = 0; iChannel < channels; iChannel += 1) {
-                pFramesOutF32[iFrame*channels + iChannel] = pFramesInF32[iFrame*channels + iChannel] * volume;
-            }
-        }
+
+    // fade in: gain 0 -> 1 till start_time
+    auto fade_in_frames = fade_node->start_time_pcm_frames;
+    if (local_time < fade_in_frames) {
+        auto fade_frames = ma_uint32(std::min(ma_uint64(frameCount), fade_in_frames - local_time));
+        apply_fade(pFramesOutF32, fade_frames, channels, fade_node->start_curve, local_time, fade_in_frames, false);
     }
-    if (fade_node->end_time_pcm_frames <= local_time) {
-        for (ma_uint64 iFrame = 0; iFrame < frameCount; iFrame += 1) {
-            float a = (std::max(ma_uint32(local_time + iFrame), fade_node->end_time_pcm_frames) - fade_node->end_time_pcm_frames) / float(fade_node->end_time_length_pcm);
-            float volume = 1.0f - a;
-            assert(0.0f <= volume && volume <= 1.0f);
-
-            for (ma_uint32 iChannel = 0; iChannel < channels; iChannel += 1) {
-                pFramesOutF32[iFrame*channels + iChannel] = pFramesInF32[iFrame*channels + iChannel] * volume;
-            }
-        }
+
+    // fade out: gain 1 -> 0 from end_time during end_time_length, silence after
+    auto fade_out_frames = fade_node->end_time_length_pcm;
+    auto fade_out_start = fade_node->end_time_pcm_frames;
+    if (fade_out_frames && fade_out_start < local_time + frameCount) {
+        ma_uint32 first_frame = fade_out_start < local_time ? 0 : ma_uint32(fade_out_start - local_time);
+        ma_uint64 fade_out_time = local_time + first_frame - fade_out_start;
+
+        auto fade_frames = fade_out_time < fade_out_frames ?
+            ma_uint32(std::min(ma_uint64(frameCount - first_frame), fade_out_frames - fade_out_time)) : 0;
+        apply_fade(pFramesOutF32 + first_frame * channels, fade_frames, channels, fade_node->end_curve, fade_out_time, fade_out_frames, true);
+
+        auto silence_frame = first_frame + fade_frames;
+        std::fill(pFramesOutF32 + silence_frame * channels, pFramesOutF32 + frameCount * channels, 0.0f);
     }
 }
 
@@ -71,6 +111,9 @@ ma_result fade_node_init(ma_node_graph* pNodeGraph, const fade_node_init_info_t*
     p_node->end_time_pcm_frames = init_info->end_time_pcm_frames;
     p_node->end_time_length_pcm = init_info->end_time_length_pcm;
     p_node->target_sound = init_info->target_sound;
+    p_node->start_curve = init_info->start_curve;
+    p_node->end_curve = init_info->end_curve;
+    p_node->counters = init_info->counters;
 
     const ma_allocation_callbacks* pAllocationCallbacks = nullptr; // no need to allocated anything?
     ma_result result = ma_node_init(pNodeGraph, &baseConfig, pAllocationCallbacks, &p_node->baseNode);
@@ -1,10 +1,20 @@
 #pragma once
 
 #include "miniaudio_public.h"
+#include "runtime_stats.h"
+#include "rt_types.h"
 
 namespace hle_audio {
 namespace rt {
 
+/**
+ * @brief baked fade in curve knots (bank data), linear fade if empty
+ */
+struct fade_curve_knots_t {
+    const fade_curve_knot_t* knots;
+    uint32_t count;
+};
+
 struct fade_graph_node_t {
     ma_node_base baseNode;
     
@@ -12,6 +22,11 @@ struct fade_graph_node_t {
     ma_uint32 end_time_pcm_frames;
     ma_uint32 end_time_length_pcm;
     ma_sound* target_sound;
+
+    fade_curve_knots_t start_curve;
+    fade_curve_knots_t end_curve;
+
+    runtime_counters_t* counters;
 };
 
 struct fade_node_init_info_t {
@@ -19,6 +34,11 @@ struct fade_node_init_info_t {
     ma_uint32 end_time_pcm_frames;
     ma_uint32 end_time_length_pcm;
     ma_sound* target_sound;
+
+    fade_curve_knots_t start_curve;
+    fade_curve_knots_t end_curve;
+
+    runtime_counters_t* counters; // optional, processing cost
 };
 
 ma_result fade_node_init(ma_node_graph* pNodeGraph, const fade_node_init_info_t* init_info, fade_graph_node_t* p_node);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+
+namespace hle_audio {
+namespace rt {
+
+/**
+ * single producer/single consumer ring positions, range_size is expected to be power of 2
+ */
+template<typename T>
+struct ring_indices {
+    using indices_type = T;
+
+    std::atomic<indices_type> read_pos;
+    std::atomic<indices_type> write_pos;
+    indices_type range_size;
+
+    void init(indices_type range) {
+        assert(range && (range & (range - 1)) == 0);
+        range_size = range;
+        reset();
+    }
+
+    void reset() {
+        read_pos = write_pos = {};
+    }
+
+    bool can_write() const {
+        return write_pos.load() != indices_type(read_pos.load() + range_size);
+    }
+
+    indices_type index(indices_type pos) const {
+        return pos & (range_size - 1);
+    }
+};
+
+}
+}
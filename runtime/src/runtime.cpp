@@ -4,6 +4,7 @@
 #include <cassert>
 #include <cstdio>
 #include <algorithm>
+#include <chrono>
 
 #include "miniaudio_public.h"
 
@@ -13,6 +14,12 @@
 #include "async_file_reader.h"
 #include "internal_types.h"
 #include "chunk_streaming_cache.h"
+#include "decode_scheduler.h"
+#include "sound_sequencer.h"
+#include "update_thread.h"
+#include "job_pool.h"
+#include "decoded_cache.h"
+#include "trace.h"
 
 #include "alloc_utils.inl"
 #include "jobs_utils.inl"
@@ -21,8 +28,8 @@
 
 /**
  * streaming TODOs:
- *  - implement decoder_ti for ogg, etc
- *  - loop range support with decoder_ti is tricky (async decoding to start position doesn't help to maintain gapless playback)
+ *  - implement decoder_ti for other formats (flac, etc)
+ *  - loop head segment is planned once the loop end inputs are queued, so break_loop doesn't affect the loop head decoded ahead
  *  - make MAX_POOL_CHUNKS configurable (chunk_streaming_cache.cpp)
  *  - add configurable dynamic chunks pool to overflow default pool budget
  */
@@ -40,34 +47,44 @@ using hle_audio::rt::editor_runtime_t;
 
 // runtime_groups.cpp
 void fire_event(hlea_context_t* ctx, hlea_action_type_e event_type, const event_desc_t* desc);
+void fire_event_at(hlea_context_t* ctx, hlea_action_type_e event_type, const event_desc_t* desc);
+void process_timed_events(hlea_context_t* ctx);
 void group_release_all_in_bank(hlea_context_t* ctx, const hlea_event_bank_t* bank);
 void process_pending_sounds(hlea_context_t* ctx);
+void prefetch_decoded_sounds(hlea_context_t* ctx, const hlea_event_bank_t* bank);
+void mark_direct_groups(hlea_context_t* ctx, hlea_event_bank_t* bank);
 
 /////////////////////////////////////////////////////////////////////////////////////////
 
-static ma_result task_executor_job_process(ma_job* pJob) {
-    hlea_job_t job = {};
-    job.job_func = (decltype(job.job_func))pJob->data.custom.data0;
-    job.udata = (decltype(job.udata))pJob->data.custom.data1;
-
-    job.job_func(job.udata);
+/**
+ * called on audio thread after each engine read, group transitions are started
+ * and decoders are stepped once per audio quantum
+ */
+static void engine_process_callback(void* pUserData, float* pFramesOut, ma_uint64 frameCount) {
+    auto ctx = (hlea_context_t*)pUserData;
+    HLEA_TRACE_THREAD_NAME("hlea audio");
 
-    return MA_SUCCESS;
+    process_transitions(ctx->sequencer, &ctx->engine, frameCount);
+    process_decode_tasks(ctx->decode_scheduler);
 }
 
-static void task_executor_launch(void* udata, hlea_job_t job) {
-    auto executor = (ma_device_job_thread*)udata;
-
-    auto ma_job = ma_job_init(MA_JOB_TYPE_CUSTOM);
-    ma_job.data.custom.proc = task_executor_job_process;
-    ma_job.data.custom.data0 = (ma_uintptr)job.job_func;
-    ma_job.data.custom.data1 = (ma_uintptr)job.udata;
-    auto result = ma_device_job_thread_post(executor, &ma_job);
+/**
+ * engine read, timed for audio load
+ */
+static void read_engine_timed(hlea_context_t* ctx, void* frames_out, uint32_t frame_count) {
+    auto start = std::chrono::steady_clock::now();
+    ma_engine_read_pcm_frames(&ctx->engine, frames_out, frame_count, nullptr);
+    auto busy_time = std::chrono::steady_clock::now() - start;
+
+    auto busy_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(busy_time).count();
+    uint64_t period_ns = uint64_t(frame_count) * 1000000000u / ma_engine_get_sample_rate(&ctx->engine);
+    record_callback(&ctx->counters->audio_load, uint64_t(busy_ns), period_ns);
 }
 
-static const hlea_jobs_ti s_task_executor_jobs_vt {
-    task_executor_launch
-};
+static void engine_data_callback(ma_device* pDevice, void* pFramesOut, const void* pFramesIn, ma_uint32 frameCount) {
+    auto engine = (ma_engine*)pDevice->pUserData;
+    read_engine_timed((hlea_context_t*)engine->pProcessUserData, pFramesOut, frameCount);
+}
 
 hlea_context_t* hlea_create(hlea_context_create_info_t* info) {
 
@@ -101,6 +118,73 @@ hlea_context_t* hlea_create(hlea_context_create_info_t* info) {
     }
     config.allocationCallbacks = allocation_callbacks;
 
+    if (info->jobs_vt) {
+        jobs_t jobs_impl = {};
+        jobs_impl.vt = info->jobs_vt;
+        jobs_impl.udata = info->jobs_udata;
+        
+        ctx->jobs = jobs_impl;
+    } else {
+        // built-in pool as default job processor
+        static_assert(hle_audio::rt::MAX_DECODE_TASKS + hle_audio::rt::MAX_DECODED_ENTRIES <= hle_audio::rt::MAX_WORKER_JOBS,
+            "worker queue should fit all runtime jobs");
+
+        hle_audio::rt::job_pool_create_info_t pool_info = {};
+        pool_info.allocator = ctx->allocator;
+        pool_info.worker_count = info->job_thread_count;
+        pool_info.priority = info->job_thread_priority;
+        pool_info.affinity_mask = info->job_thread_affinity_mask;
+        ctx->job_pool = hle_audio::rt::create_job_pool(pool_info);
+
+        ctx->jobs = cast_to_jobs(ctx->job_pool);
+    }
+
+    ctx->counters = allocate<hle_audio::rt::runtime_counters_t>(ctx->allocator);
+    ctx->counters = new(ctx->counters) hle_audio::rt::runtime_counters_t(); // zero atomics
+    ctx->counters->audio_load.measure_costs = info->measure_audio_costs;
+
+    hle_audio::rt::decode_scheduler_create_info_t sched_info = {};
+    sched_info.allocator = ctx->allocator;
+    sched_info.jobs = ctx->jobs;
+    sched_info.watermark_ms = info->decode_watermark_ms;
+    sched_info.counters = ctx->counters;
+    ctx->decode_scheduler = hle_audio::rt::create_decode_scheduler(sched_info);
+
+    hle_audio::rt::sound_sequencer_create_info_t seq_info = {};
+    seq_info.allocator = ctx->allocator;
+    ctx->sequencer = hle_audio::rt::create_sound_sequencer(seq_info);
+
+    using hle_audio::rt::audio_format_type_e;
+    static_assert(MAX_SOUNDS <= hle_audio::rt::MAX_POOLED_DECODERS, "decoder pool should fit a decoder per sound");
+
+    hle_audio::rt::decoder_pool_create_info_t dec_pool_info = {};
+    dec_pool_info.allocator = ctx->allocator;
+    dec_pool_info.scheduler = ctx->decode_scheduler;
+    dec_pool_info.mp3_output_buffer_count = info->mp3_output_buffer_count;
+    dec_pool_info.vorbis_output_buffer_count = info->vorbis_output_buffer_count;
+    dec_pool_info.pool_sizes[uint8_t(audio_format_type_e::mp3)] = info->mp3_decoder_pool_size;
+    dec_pool_info.pool_sizes[uint8_t(audio_format_type_e::vorbis)] = info->vorbis_decoder_pool_size;
+    dec_pool_info.pool_sizes[uint8_t(audio_format_type_e::pcm)] = info->pcm_decoder_pool_size;
+    dec_pool_info.pool_sizes[uint8_t(audio_format_type_e::adpcm)] = info->adpcm_decoder_pool_size;
+    ctx->decoder_pool = hle_audio::rt::create_decoder_pool(dec_pool_info);
+
+    hle_audio::rt::decoded_cache_create_info_t decoded_cache_info = {};
+    decoded_cache_info.allocator = ctx->allocator;
+    decoded_cache_info.jobs = ctx->jobs;
+    decoded_cache_info.budget_bytes = info->decoded_cache_budget_bytes;
+    decoded_cache_info.max_sound_bytes = info->decoded_cache_sound_bytes;
+    ctx->decoded_cache = hle_audio::rt::create_decoded_cache(decoded_cache_info);
+    ctx->decode_on_bank_load = info->decode_on_bank_load;
+
+    config.dataCallback = engine_data_callback;
+    if (info->no_device) {
+        config.noDevice = MA_TRUE;
+        config.channels = HEADLESS_CHANNELS;
+        config.sampleRate = HEADLESS_SAMPLE_RATE;
+    }
+    config.onProcess = engine_process_callback;
+    config.pProcessUserData = ctx.get();
+
     ma_result result = ma_engine_init(&config, &ctx->engine);
     if (result != MA_SUCCESS) {
         printf("Failed to initialize audio engine.");
@@ -108,6 +192,9 @@ hlea_context_t* hlea_create(hlea_context_create_info_t* info) {
         return nullptr;
     }
 
+    auto schedule_ahead_ms = info->schedule_ahead_ms ? info->schedule_ahead_ms : DEFAULT_SCHEDULE_AHEAD_MS;
+    ctx->schedule_ahead_pcm = schedule_ahead_ms * ma_engine_get_sample_rate(&ctx->engine) / 1000;
+
     ctx->output_bus_group_count = (info->output_bus_count <= MAX_OUPUT_BUSES) ? info->output_bus_count : MAX_OUPUT_BUSES;
     for (size_t i = 0; i < ctx->output_bus_group_count; ++i) {
         // todo: check results, deinit, return nullptr
@@ -115,51 +202,64 @@ hlea_context_t* hlea_create(hlea_context_create_info_t* info) {
         assert(result == MA_SUCCESS);
     }
     
-    if (info->jobs_vt) {
-        jobs_t jobs_impl = {};
-        jobs_impl.vt = info->jobs_vt;
-        jobs_impl.udata = info->jobs_udata;
-        
-        ctx->jobs = jobs_impl;
-    } else {
-        // init single thread pool as default job processor
-        auto jobThreadConfig = ma_device_job_thread_config_init();
-        ma_device_job_thread_init(&jobThreadConfig, &config.allocationCallbacks, &ctx->task_executor);
-
-        jobs_t jobs_impl = {};
-        jobs_impl.vt = &s_task_executor_jobs_vt;
-        jobs_impl.udata = &ctx->task_executor;
-        
-        ctx->jobs = jobs_impl;
-    }
-
     hle_audio::rt::async_file_reader_create_info_t cinfo = {};
     cinfo.allocator = ctx->allocator;
     cinfo.vfs = ctx->pVFS;
+    cinfo.lane_count = info->streaming_read_thread_count;
+    cinfo.counters = ctx->counters;
     ctx->async_io = hle_audio::rt::create_async_file_reader(cinfo);
 
     hle_audio::rt::chunk_streaming_cache_init_info_t cache_iinfo = {};
     cache_iinfo.allocator = ctx->allocator;
     cache_iinfo.async_io = ctx->async_io;
+    cache_iinfo.counters = ctx->counters;
     ctx->streaming_cache = hle_audio::rt::create_cache(cache_iinfo);
 
+    if (info->update_thread_period_ms) {
+        hle_audio::rt::update_thread_create_info_t update_info = {};
+        update_info.allocator = ctx->allocator;
+        update_info.period_ms = info->update_thread_period_ms;
+        update_info.update = [](void* udata) { hlea_process_frame((hlea_context_t*)udata); };
+        update_info.udata = ctx.get();
+        ctx->update_thread = hle_audio::rt::create_update_thread(update_info);
+    }
+
     return ctx.release();
 }
 
 void hlea_destroy(hlea_context_t* ctx) {
+    if (ctx->update_thread) {
+        destroy(ctx->update_thread);
+        ctx->update_thread = nullptr;
+    }
+
     destroy(ctx->streaming_cache);
     destroy(ctx->async_io);
 
-    if (ctx->jobs.vt == &s_task_executor_jobs_vt) {
-        auto alloc_cb = make_allocation_callbacks(&ctx->allocator);
-        ma_device_job_thread_uninit(&ctx->task_executor, &alloc_cb);
+    for (size_t i = 0; i < ctx->group_engine_groups.size; ++i) {
+        ma_sound_group_uninit(&ctx->group_engine_groups.vec[i]);
     }
-
     for (size_t i = 0; i < ctx->output_bus_group_count; ++i) {
         ma_sound_group_uninit(&ctx->output_bus_groups[i]);
     }
     ma_engine_uninit(&ctx->engine);
 
+    // batches left pending by the last audio callback are launched here, none after
+    stop(ctx->decode_scheduler);
+
+    // waits for decoding jobs, so before job pool
+    destroy(ctx->decoded_cache);
+
+    // finishes launched jobs, decoders and batches they use are alive till then
+    if (ctx->job_pool) destroy(ctx->job_pool);
+    destroy(ctx->decoder_pool);
+    destroy(ctx->decode_scheduler);
+    destroy(ctx->sequencer);
+
+    // modules above could count till destroyed
+    ctx->counters->~runtime_counters_t();
+    deallocate(ctx->allocator, ctx->counters);
+
     assert(ctx->tracking_alloc.counter == 0);
     deallocate(ctx->base_allocator, ctx);
 }
@@ -172,6 +272,11 @@ void hlea_wakeup(hlea_context_t* ctx) {
     ma_engine_start(&ctx->engine);
 }
 
+void hlea_render_pcm(hlea_context_t* ctx, float* frames_out, uint32_t frame_count) {
+    assert(!ma_engine_get_device(&ctx->engine) && "device context is rendered by audio thread");
+    read_engine_timed(ctx, frames_out, frame_count);
+}
+
 /**
  * init with allocated buffer
  */
@@ -194,22 +299,59 @@ static hlea_event_bank_t* load_events_bank_buffer(hlea_context_t* ctx, void* pDa
     bank->data_buffer_ptr = buf;
     bank->static_data = store;
 
+    mark_direct_groups(ctx, bank);
+    if (ctx->decode_on_bank_load) prefetch_decoded_sounds(ctx, bank);
+
     return bank;
 }
 
 hlea_event_bank_t* hlea_load_events_bank(hlea_context_t* ctx, const char* bank_filename, const char* stream_bank_filename) {
+    hlea_events_bank_load_info_t info = {};
+    info.bank_filename = bank_filename;
+    info.stream_bank_filenames = &stream_bank_filename;
+    info.stream_bank_count = stream_bank_filename ? 1 : 0;
+
+    return hlea_load_events_bank(ctx, &info);
+}
+
+hlea_event_bank_t* hlea_load_events_bank(hlea_context_t* ctx, const hlea_events_bank_load_info_t* info) {
+    assert(info);
+
+    // sounds of dropped parts wouldn't play
+    if (MAX_BANK_STREAM_FILES < info->stream_bank_count) {
+        fprintf(stderr, "hlea: %u stream parts passed, %u supported, bank isn't loaded\n",
+            unsigned(info->stream_bank_count), unsigned(MAX_BANK_STREAM_FILES));
+        return nullptr;
+    }
+
     data_buffer_t buffer = {};
-    ma_result result = read_file(ctx->pVFS, bank_filename, ctx->allocator, &buffer);
+    ma_result result = read_file(ctx->pVFS, info->bank_filename, ctx->allocator, &buffer);
+    if (result != MA_SUCCESS) return nullptr;
 
+    api_lock_t lock(ctx);
     hlea_event_bank_t* res = load_events_bank_buffer(ctx, buffer.data);
-
-    result = ma_vfs_open(ctx->pVFS, stream_bank_filename, MA_OPEN_MODE_READ, &res->streaming_file);
-    if (result == MA_SUCCESS) {
-        res->streaming_afile = start_async_reading(ctx->async_io, res->streaming_file);
-        res->streaming_cache_src = register_source(ctx->streaming_cache, res->streaming_afile);
-    } else {
-        // couldn't open file, do nothing here
-    } 
+    if (!res) return nullptr;
+
+    auto stream_file_count = info->stream_bank_count;
+    for (uint8_t i = 0; i < stream_file_count; ++i) {
+        auto& stream_file = res->stream_files[i];
+
+        result = ma_vfs_open(ctx->pVFS, info->stream_bank_filenames[i], MA_OPEN_MODE_READ, &stream_file.file);
+        if (result == MA_SUCCESS) {
+            ma_file_info file_info = {};
+            ma_vfs_info(ctx->pVFS, stream_file.file, &file_info);
+            stream_file.size = file_info.sizeInBytes;
+            stream_file.owns_file = true;
+
+            // parts are expected to be placed on different devices, so read them in different lanes
+            stream_file.afile = start_async_reading(ctx->async_io, stream_file.file, i);
+            stream_file.cache_src = register_source(ctx->streaming_cache, stream_file.afile);
+        } else {
+            // couldn't open file, do nothing here
+            stream_file = {};
+        }
+    }
+    res->stream_file_count = stream_file_count;
 
     return res;
 }
@@ -218,39 +360,90 @@ hlea_event_bank_t* hlea_load_events_bank_from_buffer(hlea_context_t* ctx, const
     auto internal_buf = allocate(ctx->allocator, buf_size);
     memcpy(internal_buf, buf, buf_size);
 
+    api_lock_t lock(ctx);
     return load_events_bank_buffer(ctx, internal_buf);
 }
 
+hlea_event_bank_t* hlea_load_events_bank_from_buffer(hlea_context_t* ctx, const uint8_t* buf, size_t buf_size, 
+        const hlea_stream_bank_region_t* stream_regions, uint8_t stream_region_count) {
+    // region handles are of client file api, default vfs files can't be passed
+    if (stream_region_count && ctx->pVFS != (ma_vfs*)&ctx->vfs_impl) {
+        fprintf(stderr, "hlea: stream regions need context file api (file_api_vt), bank isn't loaded\n");
+        return nullptr;
+    }
+    if (MAX_BANK_STREAM_FILES < stream_region_count) {
+        fprintf(stderr, "hlea: %u stream regions passed, %u supported, bank isn't loaded\n",
+            unsigned(stream_region_count), unsigned(MAX_BANK_STREAM_FILES));
+        return nullptr;
+    }
+
+    auto res = hlea_load_events_bank_from_buffer(ctx, buf, buf_size);
+    if (!res) return nullptr;
+
+    api_lock_t lock(ctx);
+
+    auto stream_file_count = stream_region_count;
+    for (uint8_t i = 0; i < stream_file_count; ++i) {
+        auto& region = stream_regions[i];
+        auto& stream_file = res->stream_files[i];
+
+        // base offset is applied by the reader, no offset translation layer needed
+        stream_file.file = (ma_vfs_file)(intptr_t)region.file;
+        stream_file.size = region.size;
+        stream_file.owns_file = false;
+        stream_file.afile = start_async_reading(ctx->async_io, stream_file.file, i, region.base_offset);
+        stream_file.cache_src = register_source(ctx->streaming_cache, stream_file.afile);
+    }
+    res->stream_file_count = stream_file_count;
+
+    return res;
+}
+
 void hlea_unload_events_bank(hlea_context_t* ctx, hlea_event_bank_t* bank) {
+    api_lock_t lock(ctx);
+
     // stop all sounds from bank
     group_release_all_in_bank(ctx, bank);
 
-    if (bank->streaming_afile) {
+    for (uint8_t i = 0; i < bank->stream_file_count; ++i) {
+        auto& stream_file = bank->stream_files[i];
+        if (!stream_file.afile) continue;
+
         // safe as all sounds're stopped feeding from the stream
-        deregister_source(ctx->streaming_cache, bank->streaming_cache_src);
-        bank->streaming_cache_src = {};
+        deregister_source(ctx->streaming_cache, stream_file.cache_src);
+        stream_file.cache_src = {};
 
         // wait for all reads to finish and stop
-        stop_async_reading(ctx->async_io, bank->streaming_afile);
-        bank->streaming_afile = {};
+        stop_async_reading(ctx->async_io, stream_file.afile);
+        stream_file.afile = {};
 
         // no more pending reads, close the file
-        ma_vfs_close(ctx->pVFS, bank->streaming_file);
-        bank->streaming_file = {};
+        if (stream_file.owns_file) {
+            ma_vfs_close(ctx->pVFS, stream_file.file);
+        }
+        stream_file.file = {};
     }
 
+    // decoding jobs read bank data
+    release_owner(ctx->decoded_cache, bank);
+
     // todo: push decoder could be using data_buffer_ptr (not yet the case), so need to keep buffer until 
     deallocate(ctx->allocator, bank->data_buffer_ptr.ptr);
+    if (bank->direct_groups) deallocate(ctx->allocator, bank->direct_groups);
     deallocate(ctx->allocator, bank);
 }
 
 void hlea_process_frame(hlea_context_t* ctx) {
+    HLEA_TRACE_SCOPE("process_frame");
+    api_lock_t lock(ctx);
+
     update_pending_reads(ctx->streaming_cache);
+    process_timed_events(ctx);
     hlea_process_active_groups(ctx);
     process_pending_sounds(ctx);
 }
 
-void hlea_fire_event(hlea_context_t* ctx, hlea_event_bank_t* bank, const char* eventName, uint32_t obj_id) {
+static const event_t* find_event(hlea_event_bank_t* bank, const char* eventName) {
     // find event with binary search
     // todo: replace with hash index
     auto buf_ptr = bank->data_buffer_ptr;
@@ -262,8 +455,21 @@ void hlea_fire_event(hlea_context_t* ctx, hlea_event_bank_t* bank, const char* e
                 auto event_name = event.name.get_ptr(buf_ptr);
                 return strcmp(event_name, str) < 0;
             });
-    if (event == event_offset_end || strcmp(eventName, event->name.get_ptr(buf_ptr)) != 0) return;
+    if (event == event_offset_end || strcmp(eventName, event->name.get_ptr(buf_ptr)) != 0) return nullptr;
+
+    return event;
+}
+
+/**
+ * time_pcm - 0 for right away
+ */
+static void fire_bank_event(hlea_context_t* ctx, hlea_event_bank_t* bank, const char* eventName, uint32_t obj_id, uint64_t time_pcm) {
+    api_lock_t lock(ctx);
 
+    auto event = find_event(bank, eventName);
+    if (!event) return;
+
+    auto buf_ptr = bank->data_buffer_ptr;
     auto actions_size = event->actions.count;
     auto actions = event->actions.elements.get_ptr(buf_ptr);
     for (uint32_t action_index = 0u; action_index < actions_size; ++action_index) {
@@ -275,14 +481,17 @@ void hlea_fire_event(hlea_context_t* ctx, hlea_event_bank_t* bank, const char* e
         desc.target_index = action->target_index;
         desc.obj_id = obj_id;
         desc.fade_time = action->fade_time;
+        desc.time_pcm = time_pcm;
 
         auto type = (hlea_action_type_e)((int)(action->type) - 1);
-        fire_event(ctx, type, &desc);
+        if (time_pcm) fire_event_at(ctx, type, &desc);
+        else fire_event(ctx, type, &desc);
     }
 }
 
-void hlea_fire_event(hlea_context_t* ctx, const hlea_fire_event_info_t* event_info) {
+static void fire_event_actions(hlea_context_t* ctx, const hlea_fire_event_info_t* event_info, uint64_t time_pcm) {
     assert(event_info);
+    api_lock_t lock(ctx);
 
     for (uint32_t action_index = 0u; action_index< event_info->action_count; ++action_index) {
         auto& action = event_info->actions[action_index];
@@ -292,11 +501,43 @@ void hlea_fire_event(hlea_context_t* ctx, const hlea_fire_event_info_t* event_in
         desc.target_index = action.target_index;
         desc.obj_id = event_info->obj_id;
         desc.fade_time = action.fade_time;
+        desc.time_pcm = time_pcm;
 
-        fire_event(ctx, action.type, &desc);
+        if (time_pcm) fire_event_at(ctx, action.type, &desc);
+        else fire_event(ctx, action.type, &desc);
     }
 }
 
+void hlea_fire_event(hlea_context_t* ctx, hlea_event_bank_t* bank, const char* eventName, uint32_t obj_id) {
+    fire_bank_event(ctx, bank, eventName, obj_id, 0u);
+}
+
+void hlea_fire_event(hlea_context_t* ctx, const hlea_fire_event_info_t* event_info) {
+    fire_event_actions(ctx, event_info, 0u);
+}
+
+uint64_t hlea_get_time_pcm(hlea_context_t* ctx) {
+    return ma_engine_get_time_in_pcm_frames(&ctx->engine);
+}
+
+uint32_t hlea_get_sample_rate(hlea_context_t* ctx) {
+    return ma_engine_get_sample_rate(&ctx->engine);
+}
+
+void hlea_fire_event_at(hlea_context_t* ctx, hlea_event_bank_t* bank, const char* eventName, uint32_t obj_id, uint64_t time_pcm) {
+    // 0 is in the past anyway
+    fire_bank_event(ctx, bank, eventName, obj_id, time_pcm);
+}
+
+void hlea_fire_event_at(hlea_context_t* ctx, const hlea_fire_event_info_t* event_info, uint64_t time_pcm) {
+    fire_event_actions(ctx, event_info, time_pcm);
+}
+
+void hlea_fire_event_delayed(hlea_context_t* ctx, hlea_event_bank_t* bank, const char* eventName, uint32_t obj_id, float delay) {
+    auto delay_pcm = (uint64_t)(delay * ma_engine_get_sample_rate(&ctx->engine));
+    fire_bank_event(ctx, bank, eventName, obj_id, hlea_get_time_pcm(ctx) + delay_pcm);
+}
+
 void hlea_set_main_volume(hlea_context_t* ctx, float volume) {
     ma_engine_set_volume(&ctx->engine, volume);   
 }
@@ -305,15 +546,102 @@ void hlea_set_bus_volume(hlea_context_t* ctx, uint8_t bus_index, float volume) {
     ma_sound_group_set_volume(&ctx->output_bus_groups[bus_index], volume);
 }
 
+static hlea_pool_stats_t make_pool_stats(uint32_t used, uint32_t high_water, uint32_t capacity) {
+    hlea_pool_stats_t res = {};
+    res.used = used;
+    res.high_water = high_water;
+    res.capacity = capacity;
+    return res;
+}
+
+// pools grow only when there is no unused entry, so size is the high water mark
+template<typename T, size_t ARRAY_SIZE_T, typename CountType, typename U>
+static hlea_pool_stats_t make_pool_stats(const array_with_size_t<T, ARRAY_SIZE_T, CountType>& pool,
+        const array_with_size_t<U, ARRAY_SIZE_T, CountType>& unused) {
+    return make_pool_stats(pool.size - unused.size, pool.size, ARRAY_SIZE_T);
+}
+
+void hlea_get_stats(hlea_context_t* ctx, hlea_runtime_stats_t* out_stats) {
+    using hle_audio::rt::load;
+
+    api_lock_t lock(ctx);
+
+    hlea_runtime_stats_t res = {};
+    res.sounds = make_pool_stats(ctx->sounds_allocated - ctx->recycled_count, ctx->sounds_allocated, MAX_SOUNDS);
+    res.active_groups = make_pool_stats(ctx->active_groups_size, ctx->active_groups_high_water, MAX_ACTIVE_GROUPS);
+    res.engine_groups = make_pool_stats(ctx->group_engine_groups, ctx->unused_group_engine_groups_indices);
+    res.streaming_sources = make_pool_stats(ctx->streaming_sources, ctx->unused_streaming_sources_indices);
+    res.buffer_sources = make_pool_stats(ctx->buffer_sources, ctx->unused_buffer_sources_indices);
+    res.fade_nodes = make_pool_stats(ctx->fade_nodes, ctx->unused_fade_nodes_indices);
+
+    auto counters = ctx->counters;
+    res.cache_hits = load(counters->cache_hits);
+    res.cache_misses = load(counters->cache_misses);
+    res.cache_evictions = load(counters->cache_evictions);
+    res.cache_no_free_chunk = load(counters->cache_no_free_chunk);
+
+    auto cache_stats = get_stats(ctx->streaming_cache);
+    res.cache_free_chunks = cache_stats.free_chunks;
+    res.cache_chunk_count = cache_stats.chunk_count;
+
+    res.reads_queued = load(counters->reads_queued);
+    res.reads_completed = load(counters->reads_completed);
+    res.bytes_read = load(counters->bytes_read);
+    res.read_latency_p50_ms = read_latency_percentile_ms(counters, 0.50f);
+    res.read_latency_p95_ms = read_latency_percentile_ms(counters, 0.95f);
+    res.read_latency_p99_ms = read_latency_percentile_ms(counters, 0.99f);
+
+    res.decode_jobs = load(counters->decode_jobs);
+    res.decode_time_us = load(counters->decode_time_us);
+
+    res.underruns = load(counters->underruns);
+    res.dropped_events = load(counters->dropped_events);
+    res.dropped_sounds = load(counters->dropped_sounds);
+
+    *out_stats = res;
+}
+
+void hlea_get_audio_load(hlea_context_t* ctx, hlea_audio_load_t* out_load) {
+    using hle_audio::rt::load;
+
+    auto& meter = ctx->counters->audio_load;
+
+    hlea_audio_load_t res = {};
+    res.callback_count = load(meter.callback_count);
+    res.overrun_count = load(meter.overrun_count);
+    res.min_load = meter.min_load.load(std::memory_order_relaxed);
+    res.max_load = meter.max_load.load(std::memory_order_relaxed);
+    res.p99_load = load_percentile(&meter, 0.99f);
+
+    auto period_ns = load(meter.period_ns);
+    if (period_ns) {
+        res.avg_load = float(double(load(meter.busy_ns)) / period_ns);
+
+        using namespace hle_audio::rt;
+        res.streaming_source_read_load = float(double(load(meter.cost_ns[AUDIO_COST_STREAMING_SOURCE_READ])) / period_ns);
+        res.buffer_source_read_load = float(double(load(meter.cost_ns[AUDIO_COST_BUFFER_SOURCE_READ])) / period_ns);
+        res.fade_node_load = float(double(load(meter.cost_ns[AUDIO_COST_FADE_NODE])) / period_ns);
+    }
+
+    *out_load = res;
+}
+
+void hlea_reset_audio_load(hlea_context_t* ctx) {
+    request_reset(&ctx->counters->audio_load);
+}
+
 /**************************************************************************************************
  * editor api
  */
 
 size_t hlea_get_active_groups_count(hlea_context_t* ctx) {
+    api_lock_t lock(ctx);
     return ctx->active_groups_size;
 }
 
 size_t hlea_get_active_groups_infos(hlea_context_t* ctx, hlea_group_info_t* out_infos, size_t out_infos_size) {
+    api_lock_t lock(ctx);
+
     const size_t out_groups_count = (out_infos_size < ctx->active_groups_size) ? out_infos_size : ctx->active_groups_size;
 
     for (size_t active_index = 0u; active_index < out_groups_count; ++active_index) {
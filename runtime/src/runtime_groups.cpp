@@ -2,9 +2,12 @@
 #include "miniaudio_public.h"
 #include "internal_types.h"
 #include "internal_editor_runtime.h"
-#include "decoders/decoder_mp3.h"
-#include "decoders/decoder_pcm.h"
+#include "decoders/decoder_pool.h"
+#include "trace.h"
 #include <cstdlib>
+#include <algorithm>
+
+#include "alloc_utils.inl"
 
 using hle_audio::rt::named_group_t;
 using hle_audio::rt::data_buffer_t;
@@ -14,9 +17,9 @@ using hle_audio::rt::streaming_data_source_init_info_t;
 using hle_audio::rt::buffer_data_source_t;
 using hle_audio::rt::buffer_data_source_init_info_t;
 using hle_audio::rt::fade_graph_node_t;
-using hle_audio::rt::range_t;
 using hle_audio::rt::audio_format_type_e;
 using hle_audio::rt::decoder_t;
+using hle_audio::rt::count;
 
 static sound_data_t* get_sound_data(hlea_context_t* ctx, sound_id_t sound_id) {
     return &ctx->sounds[sound_id - 1];
@@ -52,13 +55,30 @@ static void release_sound(hlea_context_t* ctx, sound_id_t sound_id) {
     ctx->recycled_sounds[ctx->recycled_count++] = sound_id;
 }
 
+/**
+ * engine groups are initialized once and kept detached while unused,
+ * so playing a group only resets and reattaches the node
+ */
+static bool has_free_engine_group(hlea_context_t* ctx) {
+    return !ctx->unused_group_engine_groups_indices.empty() || !ctx->group_engine_groups.is_full();
+}
+
 static group_index_t acquire_engine_group(hlea_context_t* ctx) {
     if (!ctx->unused_group_engine_groups_indices.empty()) {
         auto group_index = ctx->unused_group_engine_groups_indices.pop_back();
+
+        // reset fade state left by stop/pause, applied before next processed frame
+        ma_sound_group* engine_group = &ctx->group_engine_groups.vec[group_index];
+        ma_sound_set_fade_in_pcm_frames(engine_group, 1, 1, 0);
         return group_index;
     } else if (!ctx->group_engine_groups.is_full()) {
         auto group_index = ctx->group_engine_groups.size;
         ctx->group_engine_groups.push_back({});
+
+        ma_sound_group* engine_group = &ctx->group_engine_groups.vec[group_index];
+        auto result = ma_sound_group_init(&ctx->engine, 0, nullptr, engine_group);
+        // todo: error handling
+        assert(result == MA_SUCCESS);
         return group_index;
     }
 
@@ -67,6 +87,9 @@ static group_index_t acquire_engine_group(hlea_context_t* ctx) {
 }
 
 static void release_engine_group(hlea_context_t* ctx, group_index_t index) {
+    ma_sound_group* engine_group = &ctx->group_engine_groups.vec[index];
+    ma_node_detach_output_bus(engine_group, 0);
+
     ctx->unused_group_engine_groups_indices.push_back(index);
 }
 
@@ -125,16 +148,20 @@ static bank_streaming_source_info_t retrieve_bank_streaming_info(hlea_context_t*
         hlea_event_bank_t* bank, uint32_t file_index) {
     
     auto buf_ptr = bank->data_buffer_ptr;
-    if (bank->static_data->file_data.count && bank->streaming_afile) {
+    if (bank->static_data->file_data.count && bank->stream_file_count) {
         auto& fd_ref = bank->static_data->file_data.get(buf_ptr, file_index);
+        if (bank->stream_file_count <= fd_ref.stream_file_index) return {};
+
+        // stream_file is zeroed if couldn't be opened
+        auto& stream_file = bank->stream_files[fd_ref.stream_file_index];
 
-        range_t range = {};
-        range.offset = fd_ref.data_buffer.elements.pos;
-        range.size = fd_ref.data_buffer.count;
+        // don't read outside of the file (region)
+        auto& range = fd_ref.stream_range;
+        if (stream_file.size < range.offset + range.size) return {};
 
         bank_streaming_source_info_t res = {};
-        res.streaming_src = bank->streaming_cache_src;
-        res.file_range = range;
+        res.streaming_src = stream_file.cache_src;
+        res.file_range = fd_ref.stream_range;
 
         return res;
     }
@@ -147,32 +174,19 @@ struct decoder_result_t {
     decoder_t decoder;
 };
 
-static decoder_result_t acquire_decoder(hlea_context_t* ctx, audio_format_type_e audio_format) {
-    using hle_audio::rt::mp3_decoder_t;
-    using hle_audio::rt::pcm_decoder_t;
-
+static decoder_result_t acquire_decoder(hlea_context_t* ctx, const file_data_t::meta_t& meta) {
     decoder_result_t res = {};
+    res.decoder = acquire_decoder(ctx->decoder_pool, meta.coding_format, meta.channels);
 
-    switch (audio_format) {
-    case audio_format_type_e::mp3: {
-        hle_audio::rt::mp3_decoder_create_info_t dec_init_info = {};
-        dec_init_info.allocator = ctx->allocator;
-        dec_init_info.jobs = ctx->jobs;
-        auto mp3_dec = create_decoder(dec_init_info);
-
-        res.decoder = cast_to_decoder(mp3_dec);
+    switch (meta.coding_format) {
+    case audio_format_type_e::mp3:
+    case audio_format_type_e::vorbis:
         res.format = ma_format_f32;
         break;
-    }
-    case audio_format_type_e::pcm: {
-        hle_audio::rt::pcm_decoder_create_info_t dec_init_info = {};
-        dec_init_info.allocator = ctx->allocator;
-        auto dec_inst = create_decoder(dec_init_info);
-
-        res.decoder = cast_to_decoder(dec_inst);
+    case audio_format_type_e::pcm:
+    case audio_format_type_e::adpcm:
         res.format = ma_format_s16;
         break;
-    }
     default:
         assert(false && "not supported format");
         break;
@@ -181,8 +195,10 @@ static decoder_result_t acquire_decoder(hlea_context_t* ctx, audio_format_type_e
     return res;
 }
 
-static void release_decoder(hlea_context_t* ctx, decoder_t decoder) {
-    destroy(decoder);
+static void release_decoder(hlea_context_t* ctx, audio_format_type_e format, decoder_t decoder) {
+    if (!decoder.vt) return;
+
+    release_decoder(ctx->decoder_pool, format, decoder);
 }
 
 static sound_id_t make_sound(hlea_context_t* ctx, 
@@ -207,15 +223,36 @@ static sound_id_t make_sound(hlea_context_t* ctx,
         buffer_data.data = (uint8_t*)fd_ref.data_buffer.elements.get_ptr(buf_ptr); // todo: void* cast, but read only here
         buffer_data.size = fd_ref.data_buffer.count;
     }
+    auto seek_points = fd_ref.seek_table.elements.get_ptr(buf_ptr);
+    auto seek_point_count = fd_ref.seek_table.count;
 
     sound_data_t* sound = nullptr;
     auto sound_id = acquire_sound(ctx, &sound);
     if (!sound_id) {
         // sound limit reached
+        count(ctx->counters->dropped_sounds);
         return invalid_id;
     }
 
-    auto dec_data = acquire_decoder(ctx, meta.coding_format);
+    // play decoded frames as pcm if cached
+    if (buffer_data.data && is_cacheable(ctx->decoded_cache, meta)) {
+        hle_audio::rt::decoded_cache_key_t key = {bank, file_node->file_index};
+        auto decoded = acquire(ctx->decoded_cache, key, meta, buffer_data);
+        if (decoded.entry_id) {
+            sound->decoded_entry_id = decoded.entry_id;
+
+            meta.coding_format = audio_format_type_e::pcm;
+            buffer_data = decoded.frames;
+            seek_points = nullptr;
+            seek_point_count = 0;
+        }
+    }
+
+    // resident pcm is read (converted to f32) by data source directly
+    decoder_result_t dec_data = {};
+    if (is_direct_pcm(meta)) dec_data.format = ma_format_f32;
+    else dec_data = acquire_decoder(ctx, meta);
+
     sound->decoder = dec_data.decoder;
     sound->coding_format = meta.coding_format;
     sound->offset_time_pcm = offset_time_pcm;
@@ -235,6 +272,9 @@ static sound_id_t make_sound(hlea_context_t* ctx,
 
                 info.format = dec_data.format;
                 info.meta = meta;
+                info.seek_points = fd_ref.seek_table.elements.get_ptr(buf_ptr);
+                info.seek_point_count = fd_ref.seek_table.count;
+                info.counters = ctx->counters;
 
                 auto result = streaming_data_source_init(str_src, info);
                 if (result == MA_SUCCESS) {
@@ -247,7 +287,7 @@ static sound_id_t make_sound(hlea_context_t* ctx,
                         &sound->engine_sound);
 
                     if (result == MA_SUCCESS) {
-                        // ma_sound_set_looping(&sound->engine_sound, file_node->loop);
+                        ma_sound_set_looping(&sound->engine_sound, file_node->loop);
 
                         return sound_id;
                     }
@@ -256,6 +296,8 @@ static sound_id_t make_sound(hlea_context_t* ctx,
                 }
             }
             release_streaming_data_source(ctx, str_src);
+        } else {
+            count(ctx->counters->dropped_sounds);
         }
 
     //
@@ -270,6 +312,9 @@ static sound_id_t make_sound(hlea_context_t* ctx,
             info.format = dec_data.format;
             info.meta = meta;
             info.buffer = buffer_data;
+            info.seek_points = seek_points;
+            info.seek_point_count = seek_point_count;
+            info.counters = ctx->counters;
             auto result = buffer_data_source_init(src, info);
             if (result == MA_SUCCESS) {
                 sound->buffer_src = src;
@@ -295,10 +340,13 @@ static sound_id_t make_sound(hlea_context_t* ctx,
             }
 
             release_buffer_data_source(ctx, src);
+        } else {
+            count(ctx->counters->dropped_sounds);
         }
     }
 
-    release_decoder(ctx, dec_data.decoder);
+    release_decoder(ctx, meta.coding_format, dec_data.decoder);
+    if (sound->decoded_entry_id) release(ctx->decoded_cache, sound->decoded_entry_id);
 
     release_sound(ctx, sound_id);
     return invalid_id;
@@ -308,6 +356,16 @@ static const named_group_t* bank_get_group(const hlea_event_bank_t* bank, uint32
     return bank_get(bank, bank->static_data->groups, group_index);
 }
 
+static hle_audio::rt::fade_curve_knots_t make_fade_curve_knots(const hle_audio::rt::buffer_t& data_ptr,
+        const hle_audio::rt::array_view_t<hle_audio::rt::fade_curve_knot_t>& knots) {
+    hle_audio::rt::fade_curve_knots_t res = {};
+    if (knots.count) {
+        res.knots = knots.elements.get_ptr(data_ptr);
+        res.count = knots.count;
+    }
+    return res;
+}
+
 static bool create_filter_nodes(hlea_context_t* ctx, hlea_event_bank_t* bank, const hle_audio::rt::file_node_t* file_node, sound_id_t sound_id) {
     using hle_audio::rt::node_type_e;
     using hle_audio::rt::fade_node_t;
@@ -343,6 +401,9 @@ static bool create_filter_nodes(hlea_context_t* ctx, hlea_event_bank_t* bank, co
                 info.end_time_pcm_frames = end_time_pcm_frames;
                 info.end_time_length_pcm = end_time_length_pcm;
                 info.target_sound = &engine_sound;
+                info.start_curve = make_fade_curve_knots(data_ptr, fade_node_desc->start_curve_knots);
+                info.end_curve = make_fade_curve_knots(data_ptr, fade_node_desc->end_curve_knots);
+                info.counters = ctx->counters;
                 auto res = fade_node_init(graph, &info, fade_graph_node);
                 if (res == MA_SUCCESS) {
                     sound_data->sound_fade_node = fade_graph_node;
@@ -409,40 +470,28 @@ static sound_id_t make_next_sound(hlea_context_t* ctx, hlea_event_bank_t* bank,
     return invalid_sound_id;
 }
 
-static void start_next_after_current(hlea_context_t* ctx, group_data_t& group) {
+/**
+ * next sound is started by sequencer on audio thread at the exact end of the current one
+ */
+static void arm_group_transition(hlea_context_t* ctx, group_data_t& group) {
     assert(group.sound_id);
     if (!group.next_sound_id) return;
 
-    auto sound_data_ptr = get_sound_data(ctx, group.sound_id);
-    auto sound = &sound_data_ptr->engine_sound;
-    if (ma_sound_is_looping(sound)) return;
-    
-    auto engine_rate = ma_engine_get_sample_rate(&ctx->engine);
-
-    ma_uint64 cursor, length;
-    ma_sound_get_cursor_in_pcm_frames(sound, &cursor);
-    ma_sound_get_length_in_pcm_frames(sound, &length);
-    ma_uint32 sample_rate;
-    ma_sound_get_data_format(sound, NULL, NULL, &sample_rate, NULL, 0);
-
-    ma_uint64 rest_frames_local_freq = length - cursor;
-    auto rest_frames_time = (double)rest_frames_local_freq / sample_rate;
-    auto rest_frames_pcm = ma_uint64(rest_frames_time * engine_rate);
+    hle_audio::rt::sound_transition_t transition = {};
+    transition.current = &get_sound_data(ctx, group.sound_id)->engine_sound;
 
-    auto sound_finished = ma_sound_at_end(sound);
+    auto next_sound_data_ptr = get_sound_data(ctx, group.next_sound_id);
+    transition.next = &next_sound_data_ptr->engine_sound;
+    transition.offset_time_pcm = next_sound_data_ptr->offset_time_pcm;
 
-    auto group_data = bank_get_group(group.bank, group.group_index);
+    arm_transition(ctx->sequencer, group.engine_group_index, transition);
+}
 
-    auto next_sound_data_ptr = get_sound_data(ctx, group.next_sound_id);
-    auto next_sound = &next_sound_data_ptr->engine_sound;
+// true if next sound was started by sequencer
+static bool cancel_group_transition(hlea_context_t* ctx, const group_data_t& group) {
+    if (group.direct) return false;
 
-    bool has_no_rest_pcm = next_sound_data_ptr->offset_time_pcm < 0 && rest_frames_pcm < -next_sound_data_ptr->offset_time_pcm;
-    ma_uint64 start_offset_pcm = (has_no_rest_pcm) ? 0u : rest_frames_pcm + next_sound_data_ptr->offset_time_pcm;
-    if (!sound_finished && (0 < start_offset_pcm)) {
-        ma_sound_set_start_time_in_pcm_frames(next_sound, ma_engine_get_time(&ctx->engine) + start_offset_pcm);
-    }
-    ma_sound_set_stop_time_in_pcm_frames(next_sound, (ma_uint64)-1);
-    ma_sound_start(next_sound);
+    return cancel_transition(ctx->sequencer, group.engine_group_index);
 }
 
 static void group_make_next_sound(hlea_context_t* ctx, group_data_t& group) {
@@ -461,14 +510,109 @@ static void group_make_next_sound(hlea_context_t* ctx, group_data_t& group) {
     ma_sound_group* engine_group = &ctx->group_engine_groups.vec[group.engine_group_index];
     ma_node_attach_output_bus(attach_node, 0, engine_group, 0);
 
-    start_next_after_current(ctx, group);
+    arm_group_transition(ctx, group);
+}
+
+/**
+ * single file node without filter and next node, sound is attached straight to output bus
+ * and takes group volume and fades
+ */
+static bool is_direct_group(const hlea_event_bank_t* bank, const named_group_t* group_data) {
+    using hle_audio::rt::node_type_e;
+    using hle_audio::rt::file_node_t;
+
+    if (!group_data->first_node_offset) return false;
+
+    auto data_ptr = bank->data_buffer_ptr;
+
+    hle_audio::rt::offset_typed_t<node_type_e> type_accessor = {group_data->first_node_offset};
+    if (*type_accessor.get_ptr(data_ptr) != node_type_e::FILE) return false;
+
+    hle_audio::rt::offset_typed_t<file_node_t> file_accessor = {group_data->first_node_offset};
+    auto file_node = file_accessor.get_ptr(data_ptr);
+
+    return !file_node->filter_node && !file_node->next_node;
+}
+
+void mark_direct_groups(hlea_context_t* ctx, hlea_event_bank_t* bank) {
+    auto group_count = bank->static_data->groups.count;
+    if (!group_count) return;
+
+    bank->direct_groups = (bool*)allocate(ctx->allocator, group_count * sizeof(bool), alignof(bool));
+    for (uint32_t group_index = 0; group_index < group_count; ++group_index) {
+        bank->direct_groups[group_index] = is_direct_group(bank, bank_get_group(bank, group_index));
+    }
+}
+
+// node which group volume and fades are applied to
+static ma_sound* group_fader(hlea_context_t* ctx, const group_data_t& group) {
+    if (group.direct) {
+        return group.sound_id ? &get_sound_data(ctx, group.sound_id)->engine_sound : nullptr;
+    }
+
+    return &ctx->group_engine_groups.vec[group.engine_group_index];
+}
+
+// fade of timed event starts at its time, right away otherwise
+static void set_group_fade(ma_sound* fader, float volume_beg, float volume_end, ma_uint64 fade_time_pcm, uint64_t time_pcm) {
+    ma_sound_set_fade_start_in_pcm_frames(fader, volume_beg, volume_end, fade_time_pcm, time_pcm ? time_pcm : ~(ma_uint64)0);
+}
+
+static ma_uint64 fade_time_to_pcm(hlea_context_t* ctx, float fade_time) {
+    return (ma_uint64)(fade_time * ma_engine_get_sample_rate(&ctx->engine));
+}
+
+static void push_active_group(hlea_context_t* ctx, const group_data_t& group) {
+    ctx->active_groups[ctx->active_groups_size++] = group;
+    ctx->active_groups_high_water = std::max(ctx->active_groups_high_water, ctx->active_groups_size);
+}
+
+static void group_play_direct(hlea_context_t* ctx, const event_desc_t* desc, const named_group_t* group_data) {
+    group_data_t group = {};
+    group.bank = desc->bank;
+    group.group_index = desc->target_index;
+    group.obj_id = desc->obj_id;
+    group.direct = true;
+    group.exec_state.current_node_offset = group_data->first_node_offset;
+
+    group.sound_id = make_next_sound(ctx, desc->bank, &group.exec_state);
+    if (!group.sound_id) return;
+
+    auto sound = &get_sound_data(ctx, group.sound_id)->engine_sound;
+
+    ma_sound_group* output_bus_group = &ctx->output_bus_groups[group_data->output_bus_index];
+    ma_node_attach_output_bus(sound, 0, output_bus_group, 0);
+    ma_sound_set_volume(sound, group_data->volume);
+
+    if (0 < desc->fade_time) {
+        set_group_fade(sound, 0, 1, fade_time_to_pcm(ctx, desc->fade_time), desc->time_pcm);
+    }
+    if (desc->time_pcm) ma_sound_set_start_time_in_pcm_frames(sound, desc->time_pcm);
+    ma_sound_start(sound);
+
+    push_active_group(ctx, group);
 }
 
 static void group_play(hlea_context_t* ctx, const event_desc_t* desc) {
-    if (ctx->active_groups_size == MAX_ACTIVE_GROUPS) return;
+    HLEA_TRACE_SCOPE("group_play");
+
+    if (ctx->active_groups_size == MAX_ACTIVE_GROUPS) {
+        count(ctx->counters->dropped_events);
+        return;
+    }
 
     auto group_data = bank_get_group(desc->bank, desc->target_index);
 
+    if (desc->bank->direct_groups && desc->bank->direct_groups[desc->target_index]) {
+        group_play_direct(ctx, desc, group_data);
+        return;
+    }
+
+    if (!has_free_engine_group(ctx)) {
+        count(ctx->counters->dropped_events);
+        return;
+    }
+
     group_data_t group = {};
     group.bank = desc->bank;
     group.group_index = desc->target_index;
@@ -477,9 +621,6 @@ static void group_play(hlea_context_t* ctx, const event_desc_t* desc) {
     group.engine_group_index = acquire_engine_group(ctx);
 
     ma_sound_group* engine_group = &ctx->group_engine_groups.vec[group.engine_group_index];
-    auto result = ma_sound_group_init(&ctx->engine, 0, nullptr, engine_group);
-    // todo: error handling
-    assert(result == MA_SUCCESS);
 
     ma_sound_group* output_bus_group = &ctx->output_bus_groups[group_data->output_bus_index];
     ma_node_attach_output_bus(engine_group, 0, output_bus_group, 0);
@@ -497,14 +638,15 @@ static void group_play(hlea_context_t* ctx, const event_desc_t* desc) {
         ma_node_attach_output_bus(attach_node, 0, engine_group, 0);
 
         if (0 < desc->fade_time) {
-            ma_sound_set_fade_in_milliseconds(engine_group, 0, 1, desc->fade_time * 1000);
+            set_group_fade(engine_group, 0, 1, fade_time_to_pcm(ctx, desc->fade_time), desc->time_pcm);
         }
+        if (desc->time_pcm) ma_sound_set_start_time_in_pcm_frames(sound, desc->time_pcm);
         ma_sound_start(sound);
 
         group_make_next_sound(ctx, group);
     }
 
-    ctx->active_groups[ctx->active_groups_size++] = group;
+    push_active_group(ctx, group);
 }
 
 static uint32_t find_active_group_index(hlea_context_t* ctx, const event_desc_t* desc) {
@@ -530,36 +672,51 @@ static void group_play_single(hlea_context_t* ctx, const event_desc_t* desc) {
     group_play(ctx, desc);
 }
 
-static void sound_stop(hlea_context_t* ctx, sound_id_t sound_id, ma_uint64 fade_time_pcm) {
+static void sound_stop(hlea_context_t* ctx, sound_id_t sound_id, ma_uint64 stop_time_pcm) {
     if (!sound_id) return;
 
-    auto sound_data = get_sound_data(ctx, sound_id);
+    auto sound = &get_sound_data(ctx, sound_id)->engine_sound;
 
-    // just stop if not playing (could have delayed start, so need to stop explicitly)
-    if (!ma_sound_is_playing(&sound_data->engine_sound)) {
-        ma_sound_stop(&sound_data->engine_sound);
+    // just stop if not started or delayed start is after stop, so need to stop explicitly
+    if (ma_node_get_state(sound) != ma_node_state_started ||
+        stop_time_pcm <= ma_node_get_state_time(sound, ma_node_state_started)) {
+        ma_sound_stop(sound);
         return;
     }
 
     // schedule stop
-    auto engine = ma_sound_get_engine(&sound_data->engine_sound);
-    auto engine_time = ma_engine_get_time(engine);
-    ma_sound_set_stop_time_in_pcm_frames(&sound_data->engine_sound, engine_time + fade_time_pcm);
+    ma_sound_set_stop_time_in_pcm_frames(sound, stop_time_pcm);
 }
 
-static void group_active_stop_with_fade(hlea_context_t* ctx, group_data_t& group, float fade_time) {
-    if (group.state == playing_state_e::STOPPED) return;
-    group.state = playing_state_e::STOPPED;
+/**
+ * started (could be delayed) and neither finished nor reached its stop time
+ */
+static bool sound_is_scheduled(hlea_context_t* ctx, sound_id_t sound_id) {
+    auto sound = &get_sound_data(ctx, sound_id)->engine_sound;
+    if (ma_node_get_state(sound) != ma_node_state_started || ma_sound_at_end(sound)) return false;
+
+    return ma_engine_get_time_in_pcm_frames(&ctx->engine) < ma_node_get_state_time(sound, ma_node_state_stopped);
+}
 
-    auto engine_srate = ma_engine_get_sample_rate(&ctx->engine);
-    auto fade_time_pcm = (ma_uint64)(fade_time * engine_srate);
+static void group_stop_sounds_with_fade(hlea_context_t* ctx, group_data_t& group, const event_desc_t* desc) {
+    auto fade_time_pcm = fade_time_to_pcm(ctx, desc->fade_time);
 
     // fade out group
-    ma_sound_group* engine_group = &ctx->group_engine_groups.vec[group.engine_group_index];
-    ma_sound_set_fade_in_pcm_frames(engine_group, -1, 0, fade_time_pcm);
-    
-    sound_stop(ctx, group.sound_id, fade_time_pcm);
-    sound_stop(ctx, group.next_sound_id, fade_time_pcm);
+    set_group_fade(group_fader(ctx, group), -1, 0, fade_time_pcm, desc->time_pcm);
+
+    auto stop_time_pcm = desc->time_pcm ? desc->time_pcm : ma_engine_get_time_in_pcm_frames(&ctx->engine);
+    stop_time_pcm += fade_time_pcm;
+
+    cancel_group_transition(ctx, group);
+    sound_stop(ctx, group.sound_id, stop_time_pcm);
+    sound_stop(ctx, group.next_sound_id, stop_time_pcm);
+}
+
+static void group_active_stop_with_fade(hlea_context_t* ctx, group_data_t& group, const event_desc_t* desc) {
+    if (group.state == playing_state_e::STOPPED) return;
+    group.state = playing_state_e::STOPPED;
+
+    group_stop_sounds_with_fade(ctx, group, desc);
 }
 
 static void group_stop(hlea_context_t* ctx, const event_desc_t* desc) {
@@ -567,23 +724,15 @@ static void group_stop(hlea_context_t* ctx, const event_desc_t* desc) {
 
     if (active_index == ctx->active_groups_size) return;
 
-    group_active_stop_with_fade(ctx, ctx->active_groups[active_index], desc->fade_time);
+    group_active_stop_with_fade(ctx, ctx->active_groups[active_index], desc);
 }
 
 
-static void group_active_pause_with_fade(hlea_context_t* ctx, group_data_t& group, float fade_time) {
+static void group_active_pause_with_fade(hlea_context_t* ctx, group_data_t& group, const event_desc_t* desc) {
     if (group.state != playing_state_e::PLAYING) return;
     group.state = playing_state_e::PAUSED;
 
-    auto engine_srate = ma_engine_get_sample_rate(&ctx->engine);
-    auto fade_time_pcm = (ma_uint64)(fade_time * engine_srate);
-
-    // fade out group
-    ma_sound_group* engine_group = &ctx->group_engine_groups.vec[group.engine_group_index];
-    ma_sound_set_fade_in_pcm_frames(engine_group, -1, 0, fade_time_pcm);
-
-    sound_stop(ctx, group.sound_id, fade_time_pcm);
-    sound_stop(ctx, group.next_sound_id, fade_time_pcm);
+    group_stop_sounds_with_fade(ctx, group, desc);
 }
 
 static void group_pause(hlea_context_t* ctx, const event_desc_t* desc) {
@@ -591,7 +740,7 @@ static void group_pause(hlea_context_t* ctx, const event_desc_t* desc) {
 
     if (active_index == ctx->active_groups_size) return;
 
-    group_active_pause_with_fade(ctx, ctx->active_groups[active_index], desc->fade_time);
+    group_active_pause_with_fade(ctx, ctx->active_groups[active_index], desc);
 }
 
 static void sound_start(hlea_context_t* ctx, sound_id_t sound_id) {
@@ -610,19 +759,15 @@ static void sound_start(hlea_context_t* ctx, sound_id_t sound_id) {
     ma_sound_start(sound);
 }
 
-static void group_active_resume_with_fade(hlea_context_t* ctx, group_data_t& group, float fade_time) {
+static void group_active_resume_with_fade(hlea_context_t* ctx, group_data_t& group, const event_desc_t* desc) {
     if (group.state != playing_state_e::PAUSED) return;
     group.state = playing_state_e::PLAYING;
 
-    auto engine_srate = ma_engine_get_sample_rate(&ctx->engine);
-    auto fade_time_pcm = (ma_uint64)(fade_time * engine_srate);
-
     // setup fade
-    ma_sound_group* engine_group = &ctx->group_engine_groups.vec[group.engine_group_index];
-    ma_sound_set_fade_in_pcm_frames(engine_group, -1, 1, fade_time_pcm);
+    ma_sound_set_fade_in_pcm_frames(group_fader(ctx, group), -1, 1, fade_time_to_pcm(ctx, desc->fade_time));
 
     sound_start(ctx, group.sound_id);
-    start_next_after_current(ctx, group);
+    if (group.sound_id) arm_group_transition(ctx, group);
 }
 
 static void group_resume(hlea_context_t* ctx, const event_desc_t* desc) {
@@ -630,7 +775,7 @@ static void group_resume(hlea_context_t* ctx, const event_desc_t* desc) {
 
     if (active_index == ctx->active_groups_size) return;
 
-    group_active_resume_with_fade(ctx, ctx->active_groups[active_index], desc->fade_time);
+    group_active_resume_with_fade(ctx, ctx->active_groups[active_index], desc);
 }
 
 static void group_stop_all(hlea_context_t* ctx, const event_desc_t* desc) {
@@ -638,12 +783,12 @@ static void group_stop_all(hlea_context_t* ctx, const event_desc_t* desc) {
         auto& group = ctx->active_groups[it_index];
 
         if (group.obj_id == desc->obj_id) {
-            group_active_stop_with_fade(ctx, group, desc->fade_time);
+            group_active_stop_with_fade(ctx, group, desc);
         }
     }
 }
 
-typedef void (*group_with_fade_func)(hlea_context_t* ctx, group_data_t& group, float fade_time);
+typedef void (*group_with_fade_func)(hlea_context_t* ctx, group_data_t& group, const event_desc_t* desc);
 
 static void apply_to_groups_with_bus(hlea_context_t* ctx, const event_desc_t* desc, group_with_fade_func action_func) {
     for (size_t it_index = 0u; it_index < ctx->active_groups_size; ++it_index) {
@@ -652,7 +797,7 @@ static void apply_to_groups_with_bus(hlea_context_t* ctx, const event_desc_t* de
         auto group_data = bank_get_group(group.bank, group.group_index);
 
         if (group_data->output_bus_index == desc->target_index) {
-            action_func(ctx, group, desc->fade_time);
+            action_func(ctx, group, desc);
         }
     }
 }
@@ -676,12 +821,13 @@ static void group_break_loop(hlea_context_t* ctx, const event_desc_t* desc) {
 
     group_data_t& group = ctx->active_groups[active_index];
     auto sound_data_ptr = get_sound_data(ctx, group.sound_id);
+    // armed transition waits for the loop end
     ma_sound_set_looping(&sound_data_ptr->engine_sound, false);
-    
-    start_next_after_current(ctx, group);
 }
 
 void fire_event(hlea_context_t* ctx, hlea_action_type_e event_type, const event_desc_t* desc) {
+    HLEA_TRACE_SCOPE("fire_event");
+
     switch(event_type) {
         case hlea_action_type_e::play: {
             group_play(ctx, desc);
@@ -726,13 +872,92 @@ void fire_event(hlea_context_t* ctx, hlea_action_type_e event_type, const event_
     }
 }
 
+// play, stop and pause are mapped onto engine start, stop and fade times, so are fired ahead
+static bool is_time_mapped(hlea_action_type_e type) {
+    switch (type) {
+        case hlea_action_type_e::play:
+        case hlea_action_type_e::play_single:
+        case hlea_action_type_e::stop:
+        case hlea_action_type_e::pause:
+        case hlea_action_type_e::stop_all:
+        case hlea_action_type_e::stop_bus:
+        case hlea_action_type_e::pause_bus:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool timed_event_later(const timed_event_t& a, const timed_event_t& b) {
+    if (a.desc.time_pcm != b.desc.time_pcm) return b.desc.time_pcm < a.desc.time_pcm;
+    return b.order < a.order;
+}
+
+void fire_event_at(hlea_context_t* ctx, hlea_action_type_e event_type, const event_desc_t* desc) {
+    auto& heap = ctx->timed_events;
+    auto now = ma_engine_get_time_in_pcm_frames(&ctx->engine);
+
+    // late events take effect right away
+    if (desc->time_pcm <= now) {
+        event_desc_t late_desc = *desc;
+        late_desc.time_pcm = 0;
+        fire_event(ctx, event_type, &late_desc);
+        return;
+    }
+
+    if (heap.is_full()) {
+        assert(false && "timed events limit reached");
+        fire_event(ctx, event_type, desc);
+        return;
+    }
+
+    timed_event_t timed_event = {};
+    timed_event.type = event_type;
+    timed_event.desc = *desc;
+    timed_event.order = ctx->timed_events_order++;
+    heap.push_back(timed_event);
+    std::push_heap(heap.vec, heap.vec + heap.size, timed_event_later);
+}
+
+/**
+ * events are fired in time order, mapped ones schedule_ahead_pcm earlier,
+ * the rest when their time is reached (and hold later events back)
+ */
+void process_timed_events(hlea_context_t* ctx) {
+    auto& heap = ctx->timed_events;
+    auto now = ma_engine_get_time_in_pcm_frames(&ctx->engine);
+
+    while (!heap.empty()) {
+        auto& top = heap.vec[0];
+
+        uint64_t fire_time = top.desc.time_pcm;
+        if (is_time_mapped(top.type)) {
+            fire_time = (ctx->schedule_ahead_pcm < fire_time) ? fire_time - ctx->schedule_ahead_pcm : 0u;
+        }
+        if (now < fire_time) break;
+
+        std::pop_heap(heap.vec, heap.vec + heap.size, timed_event_later);
+        auto timed_event = heap.pop_back();
+        if (timed_event.desc.time_pcm <= now) timed_event.desc.time_pcm = 0;
+
+        fire_event(ctx, timed_event.type, &timed_event.desc);
+    }
+}
+
+static void remove_timed_events_in_bank(hlea_context_t* ctx, const hlea_event_bank_t* bank) {
+    auto& heap = ctx->timed_events;
+
+    auto heap_end = std::remove_if(heap.vec, heap.vec + heap.size, [bank](const timed_event_t& timed_event) {
+        return timed_event.desc.bank == bank;
+    });
+    heap.size = uint16_t(heap_end - heap.vec);
+    std::make_heap(heap.vec, heap.vec + heap.size, timed_event_later);
+}
+
 static void group_active_release(hlea_context_t* ctx, uint32_t active_index) {
     group_data_t& group = ctx->active_groups[active_index];
 
-    ma_sound_group* engine_group = &ctx->group_engine_groups.vec[group.engine_group_index];
-    ma_sound_group_uninit(engine_group);
-
-    release_engine_group(ctx, group.engine_group_index);
+    if (!group.direct) release_engine_group(ctx, group.engine_group_index);
 
     // swap remove
     ctx->active_groups[active_index] = ctx->active_groups[ctx->active_groups_size - 1];
@@ -759,16 +984,41 @@ static void release_sound_data(hlea_context_t* ctx, sound_id_t sound_id) {
         sound_data_ptr->buffer_src = nullptr;
     }
 
-    release_decoder(ctx, sound_data_ptr->decoder);
+    release_decoder(ctx, sound_data_ptr->coding_format, sound_data_ptr->decoder);
+
+    if (sound_data_ptr->decoded_entry_id) {
+        release(ctx->decoded_cache, sound_data_ptr->decoded_entry_id);
+        sound_data_ptr->decoded_entry_id = 0;
+    }
 
     release_sound(ctx, sound_id);
 }
 
+void prefetch_decoded_sounds(hlea_context_t* ctx, const hlea_event_bank_t* bank) {
+    auto buf_ptr = bank->data_buffer_ptr;
+    auto& file_data = bank->static_data->file_data;
+
+    for (uint32_t file_index = 0; file_index < file_data.count; ++file_index) {
+        auto& fd_ref = file_data.get(buf_ptr, file_index);
+        if (!fd_ref.data_buffer.count || !is_cacheable(ctx->decoded_cache, fd_ref.meta)) continue;
+
+        data_buffer_t buffer_data = {};
+        buffer_data.data = (uint8_t*)fd_ref.data_buffer.elements.get_ptr(buf_ptr);
+        buffer_data.size = fd_ref.data_buffer.count;
+
+        hle_audio::rt::decoded_cache_key_t key = {bank, file_index};
+        prefetch(ctx->decoded_cache, key, fd_ref.meta, buffer_data);
+    }
+}
+
 static void uninit_and_release_sound(hlea_context_t* ctx, sound_id_t sound_id) {
     auto sound_data_ptr = get_sound_data(ctx, sound_id);
     
     ma_sound_uninit(&sound_data_ptr->engine_sound);
 
+    // stop scheduling decoding steps, so is_running state could only go down
+    if (sound_data_ptr->decoder.state) unregister_task(ctx->decode_scheduler, sound_data_ptr->decoder.state);
+
     // defer uninit if decoder is not finished
     if(is_running(sound_data_ptr->decoder)) {
         assert(ctx->pending_sounds_size < (sizeof(ctx->pending_sounds) / sizeof(ctx->pending_sounds[0])));
@@ -780,6 +1030,8 @@ static void uninit_and_release_sound(hlea_context_t* ctx, sound_id_t sound_id) {
 }
 
 void hlea_process_active_groups(hlea_context_t* ctx) {
+    api_lock_t lock(ctx);
+
     for (uint32_t active_index = 0u; active_index < ctx->active_groups_size; ++active_index) {
         group_data_t& group = ctx->active_groups[active_index];
 
@@ -794,8 +1046,8 @@ void hlea_process_active_groups(hlea_context_t* ctx) {
             if (group.state == playing_state_e::STOPPED) {
 
                 while(group.sound_id) {
-                    auto sound_data_ptr = get_sound_data(ctx, group.sound_id);
-                    if (!ma_sound_is_playing(&sound_data_ptr->engine_sound)) {
+                    // timed stop could be ahead
+                    if (!sound_is_scheduled(ctx, group.sound_id)) {
                         uninit_and_release_sound(ctx, group.sound_id);
                         group.sound_id = group.next_sound_id;
                         group.next_sound_id = invalid_sound_id;
@@ -804,6 +1056,10 @@ void hlea_process_active_groups(hlea_context_t* ctx) {
 
             // if playing 
             } else if (ma_sound_at_end(&sound_data_ptr->engine_sound)) {
+                // ended before sequencer's quantum, start right away
+                if (!cancel_group_transition(ctx, group) && group.next_sound_id) {
+                    sound_start(ctx, group.next_sound_id);
+                }
                 uninit_and_release_sound(ctx, group.sound_id);
 
                 group.sound_id = group.next_sound_id;
@@ -838,10 +1094,13 @@ void process_pending_sounds(hlea_context_t* ctx) {
 }
 
 void group_release_all_in_bank(hlea_context_t* ctx, const hlea_event_bank_t* bank) {
+    remove_timed_events_in_bank(ctx, bank);
+
     for (uint32_t active_index = 0u; active_index < ctx->active_groups_size; ++active_index) {
         group_data_t& group = ctx->active_groups[active_index];
         if (group.bank != bank) continue;
 
+        cancel_group_transition(ctx, group);
         if (group.sound_id) uninit_and_release_sound(ctx, group.sound_id);
         if (group.next_sound_id) uninit_and_release_sound(ctx, group.next_sound_id);
         group_active_release(ctx, active_index);
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <cmath>
+#include "audio_load_meter.h"
+
+namespace hle_audio {
+namespace rt {
+
+// log2 buckets of microseconds, the last one takes the rest (~4s and longer)
+static const uint8_t READ_LATENCY_BUCKETS = 23;
+
+/**
+ * @brief runtime counters, bumped on any thread (game, audio, reading, job threads).
+ *  Relaxed atomics only, so values read together are not a consistent snapshot
+ */
+struct runtime_counters_t {
+    // streaming cache
+    std::atomic<uint64_t> cache_hits;
+    std::atomic<uint64_t> cache_misses;
+    std::atomic<uint64_t> cache_evictions;
+    std::atomic<uint64_t> cache_no_free_chunk;
+
+    // async reads
+    std::atomic<uint64_t> reads_queued;
+    std::atomic<uint64_t> reads_completed;
+    std::atomic<uint64_t> bytes_read;
+    std::atomic<uint64_t> read_latency_buckets[READ_LATENCY_BUCKETS];
+
+    // decode scheduler jobs
+    std::atomic<uint64_t> decode_jobs;
+    std::atomic<uint64_t> decode_time_us;
+
+    // data source reads with no frames ready (MA_BUSY)
+    std::atomic<uint64_t> underruns;
+
+    // pool exhaustion
+    std::atomic<uint64_t> dropped_events;
+    std::atomic<uint64_t> dropped_sounds;
+
+    audio_load_meter_t audio_load;
+};
+
+static inline void count(std::atomic<uint64_t>& counter, uint64_t value = 1u) {
+    counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+static inline uint64_t load(const std::atomic<uint64_t>& counter) {
+    return counter.load(std::memory_order_relaxed);
+}
+
+static inline void count_read_latency(runtime_counters_t* counters, uint64_t latency_us) {
+    uint8_t bucket = 0;
+    while (latency_us >>= 1) ++bucket;
+    if (READ_LATENCY_BUCKETS <= bucket) bucket = READ_LATENCY_BUCKETS - 1;
+
+    count(counters->read_latency_buckets[bucket]);
+}
+
+/**
+ * @brief upper bound of the bucket the percentile falls into, 0 if nothing is read
+ */
+static inline float read_latency_percentile_ms(const runtime_counters_t* counters, float percentile) {
+    uint64_t buckets[READ_LATENCY_BUCKETS];
+    uint64_t total = 0;
+    for (uint8_t i = 0; i < READ_LATENCY_BUCKETS; ++i) {
+        buckets[i] = load(counters->read_latency_buckets[i]);
+        total += buckets[i];
+    }
+    if (!total) return 0.0f;
+
+    // nearest rank
+    auto rank = uint64_t(std::ceil(percentile * float(total)));
+    if (rank < 1) rank = 1;
+
+    uint64_t accumulated = 0;
+    uint8_t bucket = 0;
+    for (; bucket < READ_LATENCY_BUCKETS - 1; ++bucket) {
+        accumulated += buckets[bucket];
+        if (rank <= accumulated) break;
+    }
+
+    return float(uint64_t(2) << bucket) / 1000.0f;
+}
+
+}
+}
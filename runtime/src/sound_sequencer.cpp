@@ -0,0 +1,141 @@
+#include "sound_sequencer.h"
+
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+#include "alloc_utils.inl"
+
+namespace hle_audio {
+namespace rt {
+
+enum slot_state_e : uint8_t {
+    SLOT_IDLE,
+    SLOT_PENDING,
+    SLOT_FIRING, // audio thread reads transition
+    SLOT_FIRED
+};
+
+struct transition_slot_t {
+    sound_transition_t transition;
+    std::atomic<uint8_t> state;
+};
+
+struct sound_sequencer_t {
+    allocator_t allocator;
+
+    transition_slot_t slots[MAX_TRANSITION_SLOTS];
+
+    // slots above are never armed, written by game thread only
+    std::atomic<uint16_t> slot_count;
+};
+
+sound_sequencer_t* create_sound_sequencer(const sound_sequencer_create_info_t& info) {
+    auto seq = allocate<sound_sequencer_t>(info.allocator);
+    seq = new(seq) sound_sequencer_t(); // init c++ members
+
+    seq->allocator = info.allocator;
+
+    return seq;
+}
+
+void destroy(sound_sequencer_t* seq) {
+    seq->~sound_sequencer_t();
+    deallocate(seq->allocator, seq);
+}
+
+void arm_transition(sound_sequencer_t* seq, uint16_t slot, const sound_transition_t& transition) {
+    assert(slot < MAX_TRANSITION_SLOTS);
+    auto& slot_ref = seq->slots[slot];
+    assert(slot_ref.state.load(std::memory_order_relaxed) == SLOT_IDLE && "cancel first");
+
+    slot_ref.transition = transition;
+    slot_ref.state.store(SLOT_PENDING, std::memory_order_release);
+
+    if (seq->slot_count.load(std::memory_order_relaxed) <= slot) {
+        seq->slot_count.store(slot + 1, std::memory_order_release);
+    }
+}
+
+bool cancel_transition(sound_sequencer_t* seq, uint16_t slot) {
+    assert(slot < MAX_TRANSITION_SLOTS);
+    auto& state = seq->slots[slot].state;
+
+    uint8_t current = state.load(std::memory_order_acquire);
+    while (true) {
+        if (current == SLOT_FIRING) {
+            // a few engine calls on audio thread
+            std::this_thread::yield();
+            current = state.load(std::memory_order_acquire);
+            continue;
+        }
+
+        if (state.compare_exchange_weak(current, SLOT_IDLE, std::memory_order_acq_rel)) break;
+    }
+
+    return current == SLOT_FIRED;
+}
+
+/**
+ * next sound is started when its start time is within lookahead,
+ * current cursor is re-read each quantum before that, so decoding stalls don't shift the start
+ */
+static bool try_start_next(const sound_transition_t& transition, ma_engine* engine, ma_uint64 lookahead_frames) {
+    auto current = transition.current;
+    auto engine_time = ma_engine_get_time_in_pcm_frames(engine);
+
+    ma_uint64 start_time = engine_time;
+    if (!ma_sound_at_end(current)) {
+        // waits for break loop
+        if (ma_sound_is_looping(current)) return false;
+        if (ma_node_get_state(current) != ma_node_state_started) return false;
+
+        ma_uint64 cursor, length;
+        ma_sound_get_cursor_in_pcm_frames(current, &cursor);
+        ma_sound_get_length_in_pcm_frames(current, &length);
+        ma_uint32 sample_rate;
+        ma_sound_get_data_format(current, NULL, NULL, &sample_rate, NULL, 0);
+
+        auto engine_rate = ma_engine_get_sample_rate(engine);
+        ma_uint64 rest_frames = (cursor < length) ? length - cursor : 0u;
+        auto rest_frames_pcm = ma_uint64(double(rest_frames) * engine_rate / sample_rate);
+
+        // current could have delayed start itself
+        auto current_start_time = ma_node_get_state_time(current, ma_node_state_started);
+        auto end_time = std::max(engine_time, current_start_time) + rest_frames_pcm;
+
+        auto next_start_time = int64_t(end_time) + transition.offset_time_pcm;
+        if (int64_t(engine_time) < next_start_time) start_time = ma_uint64(next_start_time);
+
+        if (engine_time + lookahead_frames < start_time) return false;
+    }
+
+    auto next = transition.next;
+    ma_sound_set_stop_time_in_pcm_frames(next, (ma_uint64)-1);
+    if (engine_time < start_time) {
+        ma_sound_set_start_time_in_pcm_frames(next, start_time);
+    }
+    ma_sound_start(next);
+
+    return true;
+}
+
+void process_transitions(sound_sequencer_t* seq, ma_engine* engine, ma_uint64 frame_count) {
+    // start time has to be set before the read it falls into, quantum could vary
+    const ma_uint64 lookahead_frames = 2 * frame_count;
+
+    auto slot_count = seq->slot_count.load(std::memory_order_acquire);
+    for (uint16_t i = 0; i < slot_count; ++i) {
+        auto& slot = seq->slots[i];
+
+        uint8_t expected = SLOT_PENDING;
+        if (slot.state.load(std::memory_order_relaxed) != expected) continue;
+        if (!slot.state.compare_exchange_strong(expected, SLOT_FIRING, std::memory_order_acq_rel)) continue;
+
+        bool started = try_start_next(slot.transition, engine, lookahead_frames);
+        slot.state.store(started ? SLOT_FIRED : SLOT_PENDING, std::memory_order_release);
+    }
+}
+
+}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include "miniaudio_public.h"
+#include "internal_alloc_types.h"
+
+namespace hle_audio {
+namespace rt {
+
+static const uint16_t MAX_TRANSITION_SLOTS = 128; // MAX_ENGINE_GROUPS
+
+/**
+ * @brief next sound of a group, started by sequencer when current one ends
+ */
+struct sound_transition_t {
+    ma_sound* current;
+    ma_sound* next;
+
+    // engine frames after current sound end, negative overlaps
+    int32_t offset_time_pcm;
+};
+
+/**
+ * @brief starts prepared sounds at exact engine time on audio thread,
+ *  so transitions don't depend on game thread update rate.
+ *  Slots are armed/cancelled on game thread and fired on audio thread, lock-free
+ */
+struct sound_sequencer_t;
+
+struct sound_sequencer_create_info_t {
+    allocator_t allocator;
+};
+
+sound_sequencer_t* create_sound_sequencer(const sound_sequencer_create_info_t& info);
+void destroy(sound_sequencer_t* seq);
+
+/**
+ * @brief slot is expected not to be armed, current sound is started.
+ *  Transition waits while current sound is looping
+ */
+void arm_transition(sound_sequencer_t* seq, uint16_t slot, const sound_transition_t& transition);
+
+/**
+ * @brief sounds of slot are not accessed after the call,
+ *  returns true if next sound was started
+ */
+bool cancel_transition(sound_sequencer_t* seq, uint16_t slot);
+
+/**
+ * @brief called on audio thread after each engine read (of frame_count frames),
+ *  starts next sounds of transitions whose current sound ends soon
+ */
+void process_transitions(sound_sequencer_t* seq, ma_engine* engine, ma_uint64 frame_count);
+
+}
+}
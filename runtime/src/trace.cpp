@@ -0,0 +1,203 @@
+#include "hlea/runtime.h"
+#include "trace.h"
+
+#if defined(HLEA_TRACING)
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+namespace hle_audio {
+namespace rt {
+
+static const uint32_t TRACE_RING_SIZE = 4096; // power of 2
+static const uint32_t MAX_TRACE_THREADS = 32;
+
+// records the writer could overwrite while dump copies the ring
+static const uint32_t TRACE_DUMP_MARGIN = 64;
+
+enum trace_record_type_e : uint8_t {
+    TRACE_RECORD_SCOPE,
+    TRACE_RECORD_INSTANT
+};
+
+struct trace_record_t {
+    const char* name;
+    uint64_t time_ns;
+    uint64_t duration_ns;
+    uint64_t value;
+    trace_record_type_e type;
+};
+
+/**
+ * single writer (owning thread), dump reads it without locking,
+ * rings of exited threads are kept till reused
+ */
+struct trace_ring_t {
+    std::atomic<bool> owned;
+    std::atomic<const char*> thread_name;
+    std::atomic<uint32_t> write_pos;
+    trace_record_t records[TRACE_RING_SIZE];
+};
+
+static trace_ring_t g_rings[MAX_TRACE_THREADS];
+
+static std::atomic<hlea_trace_callback_t> g_callback;
+static void* g_callback_udata;
+
+static const auto g_trace_epoch = std::chrono::steady_clock::now();
+
+struct thread_ring_t {
+    trace_ring_t* ring;
+    bool no_free_ring;
+
+    ~thread_ring_t() {
+        if (ring) ring->owned.store(false, std::memory_order_release);
+    }
+};
+static thread_local thread_ring_t t_thread_ring;
+
+static trace_ring_t* this_thread_ring() {
+    if (t_thread_ring.ring) return t_thread_ring.ring;
+    if (t_thread_ring.no_free_ring) return nullptr;
+
+    for (auto& ring : g_rings) {
+        bool expected = false;
+        if (!ring.owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) continue;
+
+        ring.thread_name.store(nullptr, std::memory_order_relaxed);
+        ring.write_pos.store(0, std::memory_order_release);
+
+        t_thread_ring.ring = &ring;
+        return &ring;
+    }
+
+    // more threads than rings, events of this one are forwarded to callback only
+    t_thread_ring.no_free_ring = true;
+    return nullptr;
+}
+
+static void write_record(const trace_record_t& record) {
+    auto ring = this_thread_ring();
+    if (!ring) return;
+
+    auto pos = ring->write_pos.load(std::memory_order_relaxed);
+    ring->records[pos & (TRACE_RING_SIZE - 1)] = record;
+    ring->write_pos.store(pos + 1, std::memory_order_release);
+}
+
+static void forward_event(const char* name, hlea_trace_phase_e phase, uint64_t time_ns, uint64_t value) {
+    auto callback = g_callback.load(std::memory_order_acquire);
+    if (!callback) return;
+
+    hlea_trace_event_t event = {};
+    event.name = name;
+    event.phase = phase;
+    event.time_ns = time_ns;
+    event.value = value;
+    callback(&event, g_callback_udata);
+}
+
+uint64_t trace_time_ns() {
+    auto time = std::chrono::steady_clock::now() - g_trace_epoch;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+}
+
+void trace_begin(const char* name, uint64_t time_ns) {
+    forward_event(name, hlea_trace_phase_e::begin, time_ns, 0);
+}
+
+void trace_end(const char* name, uint64_t begin_time_ns) {
+    auto time_ns = trace_time_ns();
+
+    // scopes are recorded complete, so ring wrap doesn't leave unmatched begin/end
+    trace_record_t record = {};
+    record.name = name;
+    record.time_ns = begin_time_ns;
+    record.duration_ns = time_ns - begin_time_ns;
+    record.type = TRACE_RECORD_SCOPE;
+    write_record(record);
+
+    forward_event(name, hlea_trace_phase_e::end, time_ns, 0);
+}
+
+void trace_instant(const char* name, uint64_t value) {
+    trace_record_t record = {};
+    record.name = name;
+    record.time_ns = trace_time_ns();
+    record.value = value;
+    record.type = TRACE_RECORD_INSTANT;
+    write_record(record);
+
+    forward_event(name, hlea_trace_phase_e::instant, record.time_ns, value);
+}
+
+void trace_thread_name(const char* name) {
+    auto ring = this_thread_ring();
+    if (ring) ring->thread_name.store(name, std::memory_order_relaxed);
+}
+
+static void write_ring_events(FILE* f, const trace_ring_t& ring, uint32_t tid, bool& first) {
+    auto end = ring.write_pos.load(std::memory_order_acquire);
+    uint32_t begin = (TRACE_RING_SIZE < end) ? end - TRACE_RING_SIZE + TRACE_DUMP_MARGIN : 0;
+
+    if (auto thread_name = ring.thread_name.load(std::memory_order_relaxed)) {
+        fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",", tid, thread_name);
+        first = false;
+    }
+
+    for (uint32_t pos = begin; pos != end; ++pos) {
+        auto record = ring.records[pos & (TRACE_RING_SIZE - 1)];
+        if (!record.name) continue;
+
+        fprintf(f, "%s\n", first ? "" : ",");
+        first = false;
+
+        // microseconds
+        double ts = record.time_ns / 1000.0;
+        if (record.type == TRACE_RECORD_SCOPE) {
+            fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                record.name, tid, ts, record.duration_ns / 1000.0);
+        } else {
+            fprintf(f, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%llu}}",
+                record.name, tid, ts, (unsigned long long)record.value);
+        }
+    }
+}
+
+}
+}
+
+void hlea_set_trace_callback(hlea_trace_callback_t callback, void* udata) {
+    hle_audio::rt::g_callback_udata = udata;
+    hle_audio::rt::g_callback.store(callback, std::memory_order_release);
+}
+
+bool hlea_trace_dump(const char* path) {
+    using namespace hle_audio::rt;
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+
+    fprintf(f, "{\"traceEvents\":[");
+    bool first = true;
+    for (uint32_t i = 0; i < MAX_TRACE_THREADS; ++i) {
+        write_ring_events(f, g_rings[i], i + 1, first);
+    }
+    fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    bool written = !ferror(f);
+    return (fclose(f) == 0) && written;
+}
+
+#else
+
+void hlea_set_trace_callback(hlea_trace_callback_t callback, void* udata) {
+}
+
+bool hlea_trace_dump(const char* path) {
+    return false;
+}
+
+#endif
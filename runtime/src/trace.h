@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * trace markers, compiled out unless HLEA_TRACING is defined.
+ * Names are expected to be string literals, they are stored by pointer
+ */
+#if defined(HLEA_TRACING)
+
+namespace hle_audio {
+namespace rt {
+
+uint64_t trace_time_ns();
+void trace_begin(const char* name, uint64_t time_ns);
+void trace_end(const char* name, uint64_t begin_time_ns);
+void trace_instant(const char* name, uint64_t value);
+
+// shown as thread name in trace, kept for the thread lifetime
+void trace_thread_name(const char* name);
+
+struct trace_scope_t {
+    const char* name;
+    uint64_t begin_time_ns;
+
+    explicit trace_scope_t(const char* in_name) : name(in_name), begin_time_ns(trace_time_ns()) {
+        trace_begin(name, begin_time_ns);
+    }
+
+    ~trace_scope_t() {
+        trace_end(name, begin_time_ns);
+    }
+
+    trace_scope_t(const trace_scope_t&) = delete;
+    trace_scope_t& operator=(const trace_scope_t&) = delete;
+};
+
+}
+}
+
+#define HLEA_TRACE_CONCAT_IMPL(a, b) a##b
+#define HLEA_TRACE_CONCAT(a, b) HLEA_TRACE_CONCAT_IMPL(a, b)
+
+#define HLEA_TRACE_SCOPE(name) hle_audio::rt::trace_scope_t HLEA_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define HLEA_TRACE_INSTANT(name, value) hle_audio::rt::trace_instant(name, value)
+#define HLEA_TRACE_THREAD_NAME(name) hle_audio::rt::trace_thread_name(name)
+
+#else
+
+#define HLEA_TRACE_SCOPE(name) ((void)0)
+#define HLEA_TRACE_INSTANT(name, value) ((void)0)
+#define HLEA_TRACE_THREAD_NAME(name) ((void)0)
+
+#endif
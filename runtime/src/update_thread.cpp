@@ -0,0 +1,85 @@
+#include "update_thread.h"
+#include "alloc_utils.inl"
+#include "trace.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+namespace hle_audio {
+namespace rt {
+
+struct update_thread_t {
+    allocator_t allocator;
+
+    std::chrono::milliseconds period;
+    void (*update)(void* udata);
+    void* udata;
+
+    std::recursive_mutex state_mutex;
+
+    std::mutex sleep_mutex;
+    std::condition_variable wakeup_signal;
+    bool stopped;
+
+    std::thread thread;
+};
+
+static void run_updates(update_thread_t* thread) {
+    HLEA_TRACE_THREAD_NAME("hlea update");
+
+    auto next_update = std::chrono::steady_clock::now();
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lk(thread->sleep_mutex);
+            thread->wakeup_signal.wait_until(lk, next_update, [thread]() { return thread->stopped; });
+            if (thread->stopped) break;
+        }
+
+        thread->update(thread->udata);
+
+        // fixed rate, skipped periods are not caught up
+        next_update += thread->period;
+        auto now = std::chrono::steady_clock::now();
+        if (next_update < now) next_update = now;
+    }
+}
+
+update_thread_t* create_update_thread(const update_thread_create_info_t& info) {
+    assert(info.update);
+
+    auto thread = allocate<update_thread_t>(info.allocator);
+    thread = new(thread) update_thread_t(); // init c++ members
+
+    thread->allocator = info.allocator;
+    thread->period = std::chrono::milliseconds(info.period_ms ? info.period_ms : 1);
+    thread->update = info.update;
+    thread->udata = info.udata;
+    thread->thread = std::thread(run_updates, thread);
+
+    return thread;
+}
+
+void destroy(update_thread_t* thread) {
+    {
+        std::unique_lock<std::mutex> lk(thread->sleep_mutex);
+        thread->stopped = true;
+    }
+    thread->wakeup_signal.notify_one();
+    thread->thread.join();
+
+    thread->~update_thread_t();
+    deallocate(thread->allocator, thread);
+}
+
+void lock(update_thread_t* thread) {
+    thread->state_mutex.lock();
+}
+
+void unlock(update_thread_t* thread) {
+    thread->state_mutex.unlock();
+}
+
+}
+}
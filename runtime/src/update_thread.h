@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include "internal_alloc_types.h"
+
+namespace hle_audio {
+namespace rt {
+
+struct update_thread_create_info_t {
+    allocator_t allocator;
+
+    uint16_t period_ms;
+
+    // called on update thread every period
+    void (*update)(void* udata);
+    void* udata;
+};
+
+/**
+ * @brief periodic update on its own thread, state shared with the client calls
+ *  is guarded by the thread lock (recursive, so nested api calls are fine)
+ */
+struct update_thread_t;
+
+update_thread_t* create_update_thread(const update_thread_create_info_t& info);
+
+/**
+ * @brief waits for the running update to finish
+ */
+void destroy(update_thread_t* thread);
+
+void lock(update_thread_t* thread);
+void unlock(update_thread_t* thread);
+
+}
+}
@@ -1,11 +1,13 @@
 #include "data_state.h"
 #include "file_data_provider.h"
+#include <cstdlib>
+#include <cstring>
 
 using namespace hle_audio::data;
 
 int main(int argc, char** argv) {
     if (argc < 5) {
-        fprintf(stderr, "invalid params, expected format: <cmd> json_filename out_filename out_stream_filename sounds_path\n");
+        fprintf(stderr, "invalid params, expected format: <cmd> json_filename out_filename out_stream_filename sounds_path [stream_part_size_mb] [adpcm: none|short|all]\n");
         return 1;
     }
     const char* json_filename = argv[1];
@@ -13,6 +15,22 @@ int main(int argc, char** argv) {
     const char* out_stream_filename = argv[3];
     const char* sounds_path = argv[4];
 
+    // split stream bank into several files if set
+    uint64_t stream_part_size = 0;
+    if (5 < argc) {
+        stream_part_size = strtoull(argv[5], nullptr, 10) * 1024 * 1024;
+    }
+
+    // wavs encoding into adpcm, besides files flagged adpcm in project
+    auto adpcm_policy = file_data_provider_t::adpcm_policy_e::none;
+    if (6 < argc) {
+        if (strcmp(argv[6], "short") == 0) {
+            adpcm_policy = file_data_provider_t::adpcm_policy_e::short_sounds;
+        } else if (strcmp(argv[6], "all") == 0) {
+            adpcm_policy = file_data_provider_t::adpcm_policy_e::all;
+        }
+    }
+
     data_state_t state = {};
     init(&state);
 
@@ -24,7 +42,12 @@ int main(int argc, char** argv) {
     file_data_provider_t fd_prov = {};
     fd_prov.sounds_path = sounds_path;
     fd_prov.use_oggs = true;
-    auto fb_buf = save_store_blob_buffer(&state, &fd_prov, out_stream_filename);
+    fd_prov.adpcm_policy = adpcm_policy;
+    auto fb_buf = save_store_blob_buffer(&state, &fd_prov, out_stream_filename, stream_part_size);
+    if (fb_buf.empty()) {
+        fprintf(stderr, "Stream data needs more than %u parts, increase stream part size!\n", unsigned(hle_audio::rt::MAX_STREAM_FILE_PARTS));
+        return 1;
+    }
 
     auto out_f = fopen(out_filename, "wb");
     if (out_f) {
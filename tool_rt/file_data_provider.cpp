@@ -5,6 +5,11 @@
 #include <fstream>
 
 #include "miniaudio_public.h"
+#include "adpcm.h"
+
+// implementation is compiled within hlea_runtime (decoder_mp3.cpp), seek points have to match its decoding
+#define MINIMP3_FLOAT_OUTPUT
+#include "minimp3.h"
 
 using hle_audio::data::audio_file_data_t;
 using hle_audio::rt::const_data_buffer_t;
@@ -103,7 +108,159 @@ static std::vector<uint8_t> read_file(const fs::path& file_path) {
     return file_buf;
 }
 
-audio_file_data_t file_data_provider_t::get_file_data(const char* filename, uint32_t file_index) {
+// ~0.4 sec at 44.1kHz, max frames to decode on seek is the interval + reservoir warm-up frames
+static const size_t MP3_SEEK_POINT_INTERVAL = 16;
+static const size_t MP3_MAX_WARMUP_FRAMES = 8;
+
+struct mp3_frame_pos_t {
+    uint32_t byte_offset;
+    uint32_t frame_index;
+};
+
+/**
+ * @brief decodes mp3 frames starting from frames[first], the same way runtime decoder does after seek
+ * @return decoded frames count output before frames[target] or -1 if frames[target] couldn't be decoded
+ */
+static int32_t mp3_frames_before_target(const_data_buffer_t data, const std::vector<mp3_frame_pos_t>& frames, size_t first, size_t target) {
+    mp3dec_t mp3d;
+    mp3dec_init(&mp3d);
+    float pcm[MINIMP3_MAX_SAMPLES_PER_FRAME];
+
+    const size_t target_pos = frames[target].byte_offset;
+
+    int32_t res = 0;
+    size_t pos = frames[first].byte_offset;
+    while (pos <= target_pos) {
+        mp3dec_frame_info_t info = {};
+        int frame_count = mp3dec_decode_frame(&mp3d, data.data + pos, int(data.size - pos), pcm, &info);
+        if (!info.frame_bytes) break;
+
+        if (pos == target_pos) return frame_count ? res : -1;
+
+        res += frame_count;
+        pos += info.frame_bytes;
+    }
+
+    return -1;
+}
+
+static std::vector<rt::seek_point_t> build_mp3_seek_table(const_data_buffer_t data) {
+    // positions of decoded frames
+    std::vector<mp3_frame_pos_t> frames;
+
+    mp3dec_t mp3d;
+    mp3dec_init(&mp3d);
+    float pcm[MINIMP3_MAX_SAMPLES_PER_FRAME];
+
+    size_t pos = 0;
+    uint64_t frame_index = 0;
+    while (pos < data.size) {
+        mp3dec_frame_info_t info = {};
+        int frame_count = mp3dec_decode_frame(&mp3d, data.data + pos, int(data.size - pos), pcm, &info);
+        if (!info.frame_bytes) break;
+
+        if (frame_count) {
+            mp3_frame_pos_t frame = {};
+            frame.byte_offset = uint32_t(pos);
+            frame.frame_index = uint32_t(frame_index);
+            frames.push_back(frame);
+        }
+
+        pos += info.frame_bytes;
+        frame_index += frame_count;
+    }
+
+    std::vector<rt::seek_point_t> res;
+    for (size_t i = 0; i < frames.size(); i += MP3_SEEK_POINT_INTERVAL) {
+        rt::seek_point_t point = {};
+        point.frame_index = frames[i].frame_index;
+
+        if (i) {
+            // start a few frames earlier, so the bit reservoir is filled at frames[i]
+            int32_t discard_frames = -1;
+            size_t first = i;
+            for (size_t warmup = 1; warmup <= MP3_MAX_WARMUP_FRAMES && warmup <= i; ++warmup) {
+                first = i - warmup;
+                discard_frames = mp3_frames_before_target(data, frames, first, i);
+                if (0 <= discard_frames) break;
+            }
+            if (discard_frames < 0) continue;
+
+            point.byte_offset = frames[first].byte_offset;
+            point.discard_frames = uint16_t(discard_frames);
+        }
+
+        res.push_back(point);
+    }
+
+    return res;
+}
+
+static std::vector<uint8_t> encode_adpcm(const std::vector<uint8_t>& content, const rt::file_data_t::meta_t& meta) {
+    using namespace hle_audio::rt;
+
+    if (ADPCM_MAX_CHANNELS < meta.channels) return {};
+
+    // decode to s16 of native channels and rate
+    ma_decoder_config config = ma_decoder_config_init(ma_format_s16, 0, 0);
+    ma_decoder decoder;
+    auto result = ma_decoder_init_memory(content.data(), content.size(), &config, &decoder);
+    if (result != MA_SUCCESS) return {};
+
+    const uint8_t channels = meta.channels;
+    const auto block_count = (meta.length_in_samples + ADPCM_BLOCK_FRAMES - 1) / ADPCM_BLOCK_FRAMES;
+
+    // the last block is padded with silence
+    std::vector<int16_t> samples(block_count * ADPCM_BLOCK_FRAMES * channels);
+    ma_uint64 frames_read = 0;
+    ma_decoder_read_pcm_frames(&decoder, samples.data(), meta.length_in_samples, &frames_read);
+    ma_decoder_uninit(&decoder);
+
+    std::vector<uint8_t> res(block_count * adpcm_block_size(channels));
+
+    adpcm_channel_state_t states[ADPCM_MAX_CHANNELS] = {};
+    for (size_t block_index = 0; block_index < block_count; ++block_index) {
+        uint8_t* block = &res[block_index * adpcm_block_size(channels)];
+        uint8_t* codes = block + ADPCM_BLOCK_HEADER_SIZE * channels;
+        const int16_t* block_samples = &samples[block_index * ADPCM_BLOCK_FRAMES * channels];
+
+        for (uint8_t ch = 0; ch < channels; ++ch) {
+            auto& state = states[ch];
+
+            // header holds the encoder state, so every block decodes from its start
+            uint8_t* header = block + ADPCM_BLOCK_HEADER_SIZE * ch;
+            int16_t predictor = int16_t(state.predictor);
+            memcpy(header, &predictor, sizeof(predictor));
+            header[2] = uint8_t(state.step_index);
+            header[3] = 0;
+
+            uint8_t* channel_codes = codes + ADPCM_BLOCK_CODES_SIZE * ch;
+            for (uint32_t i = 0; i < ADPCM_BLOCK_CODES_SIZE; ++i) {
+                auto code_lo = adpcm_encode_sample(&state, block_samples[(2 * i) * channels + ch]);
+                auto code_hi = adpcm_encode_sample(&state, block_samples[(2 * i + 1) * channels + ch]);
+                channel_codes[i] = uint8_t(code_lo | (code_hi << 4));
+            }
+        }
+    }
+
+    return res;
+}
+
+static bool should_encode_adpcm(const file_data_provider_t& prov, const rt::file_data_t::meta_t& meta) {
+    using adpcm_policy_e = file_data_provider_t::adpcm_policy_e;
+    switch (prov.adpcm_policy) {
+    case adpcm_policy_e::short_sounds:
+        return meta.length_in_samples <= prov.adpcm_max_length_in_samples;
+    case adpcm_policy_e::all:
+        return true;
+    default:
+        break;
+    }
+
+    return false;
+}
+
+audio_file_data_t file_data_provider_t::get_file_data(const char* filename, uint32_t file_index, const audio_file_flags_t& flags) {
     fs::path full_path = fs::path(sounds_path) / filename;
     std::vector<uint8_t> file_buf = read_file(full_path);
     if (file_buf.size() == 0) return {};
@@ -173,6 +330,24 @@ audio_file_data_t file_data_provider_t::get_file_data(const char* filename, uint
 
     ma_decoder_uninit(&decoder);
 
+    if (meta.coding_format == rt::audio_format_type_e::mp3) {
+        const_data_buffer_t data = {};
+        data.data = res.content.data() + res.data_chunk_range.offset;
+        data.size = res.data_chunk_range.size;
+        res.seek_table = build_mp3_seek_table(data);
+    }
+
+    if (meta.coding_format == rt::audio_format_type_e::pcm && (flags.adpcm || should_encode_adpcm(*this, meta))) {
+        auto adpcm_data = encode_adpcm(res.content, meta);
+        if (adpcm_data.size()) {
+            meta.coding_format = rt::audio_format_type_e::adpcm;
+            res.content = std::move(adpcm_data);
+
+            res.data_chunk_range.offset = 0;
+            res.data_chunk_range.size = uint32_t(res.content.size());
+        }
+    }
+
     res.meta = meta;
 
     assert(res.data_chunk_range.size);
@@ -10,7 +10,16 @@ public:
     const char* sounds_path;
     bool use_oggs = false;
 
-    hle_audio::data::audio_file_data_t get_file_data(const char* filename, uint32_t file_index) override;
+    // wav files to be encoded as ima adpcm, on top of the files flagged in project
+    enum class adpcm_policy_e : uint8_t {
+        none,
+        short_sounds, // not longer than adpcm_max_length_in_samples
+        all
+    };
+    adpcm_policy_e adpcm_policy = adpcm_policy_e::none;
+    uint64_t adpcm_max_length_in_samples = 2 * 48000;
+
+    hle_audio::data::audio_file_data_t get_file_data(const char* filename, uint32_t file_index, const hle_audio::data::audio_file_flags_t& flags) override;
 };
 
 }